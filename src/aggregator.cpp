@@ -0,0 +1,33 @@
+#include "aggregator.hpp"
+
+namespace dj {
+
+    bool aggregator_registry::empty() const {
+        return aggregators.empty();
+    }
+
+    std::vector<std::string> aggregator_registry::local_values() const {
+        std::vector<std::string> values;
+        for(auto& ag: aggregators) values.emplace_back(ag->local_value());
+        return values;
+    }
+
+    std::vector<std::string> aggregator_registry::combine(
+            const std::vector<std::string>& values1, const std::vector<std::string>& values2) const
+    {
+        if(values1.size() != aggregators.size() || values2.size() != aggregators.size())
+            throw std::runtime_error("Aggregators differ between processes");
+
+        std::vector<std::string> values;
+        for(uint i = 0; i < aggregators.size(); i++)
+            values.emplace_back(aggregators[i]->combine(values1[i], values2[i]));
+        return values;
+    }
+
+    void aggregator_registry::set_global(const std::vector<std::string>& values) {
+        if(values.size() != aggregators.size())
+            throw std::runtime_error("Aggregators differ between processes");
+
+        for(uint i = 0; i < aggregators.size(); i++) aggregators[i]->set_global(values[i]);
+    }
+}
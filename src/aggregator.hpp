@@ -0,0 +1,158 @@
+#ifndef AGGREGATOR_HPP
+#define AGGREGATOR_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <functional>
+#include <unordered_map>
+#include <stdexcept>
+#include "message.hpp"
+
+namespace dj {
+
+    enum class eaggregation {
+        SUM,
+        MIN,
+        MAX
+    };
+
+    class base_aggregator {
+
+        public:
+            virtual ~base_aggregator() = default;
+
+            /**
+             * @return serialized value accumulated on this process since the last combination
+             */
+            virtual std::string local_value() const = 0;
+            virtual std::string combine(const std::string& value1, const std::string& value2) const = 0;
+            /**
+             * sets combined value of all processes and starts local accumulation from scratch
+             */
+            virtual void set_global(const std::string& value) = 0;
+    };
+
+    /**
+     * Value updated locally by nodes and combined with associative operation
+     * of all processes when tasks phase ends
+     */
+    template <typename T>
+        class aggregator : public base_aggregator {
+
+            public:
+                aggregator(std::function<T(const T&, const T&)> op, T identity)
+                    : op(std::move(op)), identity(identity), local(identity), global(identity)
+                { }
+
+                void update(const T& value) {
+                    local = op(local, value);
+                }
+
+                /**
+                 * @return value combined at the last phase boundary
+                 */
+                const T& value() const {
+                    return global;
+                }
+
+                virtual std::string local_value() const {
+                    using serialization::operator<<;
+                    std::string data;
+                    return data << local;
+                }
+
+                virtual std::string combine(const std::string& value1, const std::string& value2) const {
+                    using serialization::operator<<;
+                    using serialization::operator>>;
+                    T t1, t2;
+                    value1 >> t1;
+                    value2 >> t2;
+                    std::string data;
+                    return data << op(t1, t2);
+                }
+
+                virtual void set_global(const std::string& value) {
+                    using serialization::operator>>;
+                    value >> global;
+                    local = identity;
+                }
+
+            private:
+                std::function<T(const T&, const T&)> op;
+                T identity;
+                T local;
+                T global;
+        };
+
+    /**
+     * Named aggregators of the pipeline.
+     * Every process has to register the same aggregators in the same order.
+     */
+    class aggregator_registry {
+
+        public:
+
+            /**
+             * Identity of MIN and MAX is taken from numeric_limits of T
+             */
+            template <typename T>
+                void add(const std::string& name, eaggregation type) {
+                    static_assert(std::numeric_limits<T>::is_specialized,
+                            "no numeric_limits for T, add the aggregator with op and identity instead");
+                    switch(type) {
+                        case eaggregation::SUM:
+                            add<T>(name, [](const T& t1, const T& t2) { return t1 + t2; }, T());
+                            break;
+                        case eaggregation::MIN:
+                            add<T>(name, [](const T& t1, const T& t2) { return (t2 < t1) ? t2 : t1; },
+                                    std::numeric_limits<T>::max());
+                            break;
+                        case eaggregation::MAX:
+                            add<T>(name, [](const T& t1, const T& t2) { return (t1 < t2) ? t2 : t1; },
+                                    std::numeric_limits<T>::lowest());
+                            break;
+                    }
+                }
+
+            /**
+             * @param op has to be associative
+             * @param identity op(identity, t) == t for every t
+             */
+            template <typename T>
+                void add(const std::string& name, std::function<T(const T&, const T&)> op, T identity) {
+                    if(name_to_index.find(name) != end(name_to_index))
+                        throw std::runtime_error("aggregator with given name is already added: " + name);
+                    name_to_index[name] = aggregators.size();
+                    aggregators.emplace_back(new aggregator<T>(std::move(op), std::move(identity)));
+                }
+
+            /**
+             * @throws runtime_error if there is no aggregator of given name and type
+             */
+            template <typename T>
+                aggregator<T>& get(const std::string& name) {
+                    auto it = name_to_index.find(name);
+                    if(it == end(name_to_index))
+                        throw std::runtime_error("No aggregator: " + name);
+                    aggregator<T>* ag = dynamic_cast<aggregator<T>*>(aggregators[it->second].get());
+                    if(ag == nullptr)
+                        throw std::runtime_error("Aggregator " + name + " is not of type: " + typeid(T).name());
+                    return *ag;
+                }
+
+            bool empty() const;
+
+            std::vector<std::string> local_values() const;
+            std::vector<std::string> combine(
+                    const std::vector<std::string>& values1, const std::vector<std::string>& values2) const;
+            void set_global(const std::vector<std::string>& values);
+
+        private:
+            std::vector<std::unique_ptr<base_aggregator>> aggregators;
+            std::unordered_map<std::string, uint> name_to_index;
+    };
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "arena.hpp"
+
+#include <algorithm>
+
+namespace dj {
+
+    arena::arena(std::size_t block_size) : block_size(block_size) { }
+
+    arena::~arena() {
+        release();
+    }
+
+    void* arena::allocate(std::size_t bytes, std::size_t alignment) {
+
+        if(!blocks.empty()) {
+            block& last = blocks.back();
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(last.memory.get());
+            std::size_t offset = (base + used + alignment - 1) / alignment * alignment - base;
+            if(offset + bytes <= last.size) {
+                used = offset + bytes;
+                total += bytes;
+                return last.memory.get() + offset;
+            }
+        }
+
+        // new block big enough for everything requested
+        std::size_t size = std::max(block_size, bytes + alignment);
+        blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        used = 0;
+        return allocate(bytes, alignment);
+    }
+
+    void arena::release() {
+        for(auto it = destructors.rbegin(); it != destructors.rend(); ++it) it->first(it->second);
+        destructors.clear();
+
+        if(blocks.size() > 1) blocks.resize(1);
+        used = 0;
+        total = 0;
+    }
+
+    std::size_t arena::allocated() const {
+        return total;
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace dj {
+
+    /**
+     * Bump allocator - memory is taken from big blocks and
+     * everything allocated is released at once
+     */
+    class arena {
+
+        public:
+            arena(std::size_t block_size = 4096);
+            arena(const arena& other) = delete;
+            arena& operator=(const arena& other) = delete;
+            ~arena();
+
+            void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+            /**
+             * Constructs object in arena, its destructor is called on release
+             */
+            template <typename T, typename... Args>
+                T* make(Args&&... args) {
+                    T* t = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+                    if(!std::is_trivially_destructible<T>::value)
+                        destructors.emplace_back([](void* ptr) { static_cast<T*>(ptr)->~T(); }, t);
+                    return t;
+                }
+
+            /**
+             * Destroys objects and frees all memory but the first block
+             */
+            void release();
+
+            std::size_t allocated() const;
+
+        private:
+            struct block {
+                std::unique_ptr<char[]> memory;
+                std::size_t size;
+            };
+
+            std::size_t block_size;
+            std::size_t used = 0; // in the last block
+            std::size_t total = 0;
+            std::vector<block> blocks;
+            std::vector<std::pair<void(*)(void*), void*>> destructors;
+    };
+
+    /**
+     * Allocator for standard containers keeping their memory in arena
+     */
+    template <typename T>
+        class arena_allocator {
+
+            template <typename U> friend class arena_allocator;
+
+            public:
+                typedef T value_type;
+
+                arena_allocator(arena& ar) : ar(&ar) { }
+
+                template <typename U>
+                    arena_allocator(const arena_allocator<U>& other) : ar(other.ar) { }
+
+                T* allocate(std::size_t n) {
+                    return static_cast<T*>(ar->allocate(n*sizeof(T), alignof(T)));
+                }
+
+                void deallocate(T* /* ptr */, std::size_t /* n */) { } // freed with arena
+
+                template <typename U>
+                    bool operator==(const arena_allocator<U>& other) const {
+                        return ar == other.ar;
+                    }
+
+                template <typename U>
+                    bool operator!=(const arena_allocator<U>& other) const {
+                        return ar != other.ar;
+                    }
+
+            private:
+                arena* ar;
+        };
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "batching.hpp"
+
+#include <algorithm>
+
+namespace dj {
+
+    batch_buffer::batch_buffer() {
+        clear();
+    }
+
+    std::size_t batch_buffer::add(const work_unit& work) {
+        int32_t tag = static_cast<int32_t>(work.work_type);
+        buffer.append(reinterpret_cast<const char*>(&tag), sizeof(tag));
+        // size is filled in when work is written
+        std::size_t size_at = buffer.size();
+        buffer.append(sizeof(uint32_t), '\0');
+        work.write(buffer);
+        uint32_t size = buffer.size() - size_at - sizeof(uint32_t);
+        std::memcpy(&buffer[size_at], &size, sizeof(size));
+        count++;
+        return size;
+    }
+
+    void batch_buffer::add(int tag, const char* data, std::size_t size) {
+        int32_t tag32 = tag;
+        uint32_t size32 = size;
+        buffer.append(reinterpret_cast<const char*>(&tag32), sizeof(tag32));
+        buffer.append(reinterpret_cast<const char*>(&size32), sizeof(size32));
+        buffer.append(data, size);
+        count++;
+    }
+
+    uint batch_buffer::size() const {
+        return count;
+    }
+
+    bool batch_buffer::empty() const {
+        return count == 0;
+    }
+
+    const std::string& batch_buffer::packed() {
+        std::memcpy(&buffer[0], &count, sizeof(count));
+        return buffer;
+    }
+
+    void batch_buffer::clear() {
+        buffer.assign(sizeof(uint32_t), '\0'); // place for count
+        count = 0;
+    }
+
+    message pack_batch(const std::vector<message>& batch) {
+        batch_buffer packed;
+        for(const message& mes: batch) packed.add(mes.tag, mes.data.data(), mes.data.size());
+        return message(batch_tag, packed.packed());
+    }
+
+    std::vector<message> unpack_batch(const message& mes) {
+        std::vector<message> batch;
+        for_each_in_batch(mes, [&batch](int tag, const char* data, std::size_t size) {
+                    batch.emplace_back(tag, std::string(data, size));
+                });
+        return batch;
+    }
+
+    adaptive_batch::adaptive_batch(uint min_size, uint max_size)
+        : min_size(min_size), max_size(max_size), _size(min_size)
+    { }
+
+    void adaptive_batch::set_target(std::chrono::microseconds target) {
+        _target = target;
+        _size = min_size;
+    }
+
+    std::chrono::microseconds adaptive_batch::target() const {
+        return _target;
+    }
+
+    uint adaptive_batch::size() const {
+        return _size;
+    }
+
+    void adaptive_batch::record(std::chrono::microseconds latency, uint batch_size) {
+        if(latency > _target) {
+            _size = std::max(min_size, _size/2);
+        } else if(batch_size >= _size && 2*latency < _target) {
+            // full batch with time to spare
+            _size = std::min(max_size, _size + _size/8 + 1);
+        }
+    }
+}
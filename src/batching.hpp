@@ -0,0 +1,100 @@
+#ifndef BATCHING_HPP
+#define BATCHING_HPP
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "message.hpp"
+
+namespace dj {
+
+    /**
+     * Tag of message carrying a batch of work messages
+     */
+    const int batch_tag = static_cast<int>(end_message::eend_message_type::WORK_END) + 1;
+
+    /**
+     * Work messages packed one after another (tag, size and data) into a single buffer,
+     * which keeps its memory from batch to batch
+     */
+    class batch_buffer {
+
+        public:
+            batch_buffer();
+
+            /**
+             * Work is serialized right into the batch
+             * @return bytes of added record
+             */
+            std::size_t add(const work_unit& work);
+            void add(int tag, const char* data, std::size_t size);
+
+            uint size() const;
+            bool empty() const;
+            /**
+             * @return data of message with batch_tag, valid until the batch is changed
+             */
+            const std::string& packed();
+            void clear();
+
+        private:
+            std::string buffer;
+            uint32_t count = 0;
+    };
+
+    /**
+     * Calls f(tag, data, size) for every record of batch, data points into the message
+     */
+    template <typename F>
+        void for_each_in_batch(const message& mes, F f) {
+            const char* pos = mes.data.data();
+            const char* end = pos + mes.data.size();
+            auto take = [&pos, end](void* to, std::size_t size) {
+                if(static_cast<std::size_t>(end - pos) < size) throw std::runtime_error("Truncated batch");
+                std::memcpy(to, pos, size);
+                pos += size;
+            };
+            uint32_t count;
+            take(&count, sizeof(count));
+            for(uint32_t i = 0; i < count; i++) {
+                int32_t tag;
+                uint32_t size;
+                take(&tag, sizeof(tag));
+                take(&size, sizeof(size));
+                if(static_cast<std::size_t>(end - pos) < size) throw std::runtime_error("Truncated batch");
+                f(static_cast<int>(tag), pos, static_cast<std::size_t>(size));
+                pos += size;
+            }
+        }
+
+    message pack_batch(const std::vector<message>& batch);
+    std::vector<message> unpack_batch(const message& mes);
+
+    /**
+     * Batch size adapted to measured latency - it grows while batches fill up
+     * well within the target and is halved whenever the target is exceeded
+     */
+    class adaptive_batch {
+
+        public:
+            adaptive_batch(uint min_size = 1, uint max_size = 4096);
+
+            void set_target(std::chrono::microseconds target);
+            std::chrono::microseconds target() const;
+
+            uint size() const;
+            /**
+             * @param latency time the first record of the batch waited until the batch was sent
+             */
+            void record(std::chrono::microseconds latency, uint batch_size);
+
+        private:
+            uint min_size;
+            uint max_size;
+            uint _size;
+            std::chrono::microseconds _target{ 0 };
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include "../DistributedJobs"
+
+using namespace dj;
+
+template <typename... Output>
+    class empty_task : public base_task<Output...> {
+
+        public:
+            empty_task() : base_task<Output...>("empty_task") { }
+            void operator()(int /* input */, const std::string& /* from */) { }
+            virtual void handle_finish() { }
+    };
+
+template <typename PipeInputType, typename InputType, typename OutputType>
+    class empty_reducer : public base_reducer<PipeInputType, InputType, OutputType> {
+
+        public:
+            empty_reducer() : base_reducer<PipeInputType, InputType, OutputType>("empty_reducer") { }
+            virtual void reduce(const InputType& /* input */, const std::string& /* parent */) override { }
+            virtual void collect(const OutputType& /* data_to_collect */) override { }
+            virtual void handle_finish() override { }
+    };
+
+template <typename OutputerInput>
+    class empty_outputer : public base_outputer<OutputerInput> {
+
+        public:
+            empty_outputer() : base_outputer<OutputerInput>("empty_outputer") { }
+            virtual void operator()(const OutputerInput& /* input */, const std::string& /* parent */) override { }
+            virtual void handle_finish() override { }
+    };
+
+/**
+ * Pipeline of two tasks, reducer and outputer - executor is never started,
+ * one process MPI environment is enough
+ */
+struct fixture {
+
+    fixture() {
+        node_graph& graph = pipe.get_node_graph();
+        first = graph.add(std::unique_ptr<task_node>(new task<empty_task<int>, int>("first")));
+        second = graph.add(std::unique_ptr<task_node>(new task<empty_task<int>, int>("second")));
+        reducer_index = graph.add(std::unique_ptr<reducer_node>(
+                    new reducer<empty_reducer, int, int, int>("sum", reducer_node::ereducer_type::MULTIPLE_FIXED)));
+        output_index = graph.add(std::unique_ptr<output_node>(new outputer<empty_outputer, int>("out")));
+        graph.set_root(first);
+        graph.add_directed(first, second);
+        graph.add_reducer_to_task(reducer_index, second);
+        graph.add_output_to_reducer(output_index, reducer_index);
+        processor.reset(new exec::executor(1, argv, pipe));
+    }
+
+    char name[4] = "dj";
+    char* argv[1] = { name };
+    execution_pipeline pipe;
+    std::unique_ptr<exec::executor> processor;
+    uint first, second, reducer_index, output_index;
+};
+
+fixture& instance() {
+    static fixture f;
+    return f;
+}
+
+static void rank_and_index(benchmark::State& state, enode_type from, enode_type to, std::string dest) {
+    fixture& f = instance();
+    int from_index = (from == enode_type::TASK) ? f.first : f.reducer_index;
+    for(auto _: state) benchmark::DoNotOptimize(f.processor->get_rank_and_index_for(from, from_index, to, dest));
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(rank_and_index, task_to_task, enode_type::TASK, enode_type::TASK, "second");
+BENCHMARK_CAPTURE(rank_and_index, task_to_reducer, enode_type::TASK, enode_type::REDUCER, "sum");
+BENCHMARK_CAPTURE(rank_and_index, task_to_any_reducer, enode_type::TASK, enode_type::REDUCER, "");
+BENCHMARK_CAPTURE(rank_and_index, reducer_to_output, enode_type::REDUCER, enode_type::OUTPUT, "out");
+BENCHMARK_CAPTURE(rank_and_index, reducer_to_root, enode_type::REDUCER, enode_type::REDUCER, "");
+
+BENCHMARK_MAIN();
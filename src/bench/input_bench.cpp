@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include "../file_input.hpp"
+#include "../record_file.hpp"
+
+using namespace dj;
+
+static const int numbers = 1 << 20;
+
+/**
+ * Edge list of numbers/2 lines written once
+ */
+static const std::string& numbers_file() {
+    static std::string filename;
+    if(filename.empty()) {
+        filename = "input_bench.txt";
+        std::ofstream out(filename);
+        for(int i = 0; i < numbers; i += 2) out << (i*7919L) % 100003 << " " << i << "\n";
+    }
+    return filename;
+}
+
+// the way multi_file_input_provider reads
+static void read_ifstream(benchmark::State& state) {
+    for(auto _: state) {
+        std::ifstream in(numbers_file());
+        long sum = 0;
+        int value;
+        while(in >> value) sum += value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*numbers);
+}
+
+// the way mmap_file_input reads its byte range, split into as many ranges as state.range(0)
+static void read_mapped(benchmark::State& state) {
+    uint parts = state.range(0);
+    for(auto _: state) {
+        mapped_file file(numbers_file());
+        long sum = 0;
+        for(uint part = 0; part < parts; part++) {
+            byte_range range = line_range(file.data(), file.size(), part, parts);
+            text_parser<int>::parse(file.data() + range.begin, file.data() + range.end, 
+                    [&sum](int value) { sum += value; });
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*numbers);
+}
+
+/**
+ * The same numbers as a record file
+ */
+static const std::string& numbers_records() {
+    static std::string filename;
+    if(filename.empty()) {
+        filename = "input_bench.rec";
+        record_writer<int> out(filename);
+        for(int i = 0; i < numbers; i += 2) {
+            out.write(static_cast<int>((i*7919L) % 100003));
+            out.write(i);
+        }
+    }
+    return filename;
+}
+
+// the way record_file_input reads, records are used in place
+static void read_records(benchmark::State& state) {
+    for(auto _: state) {
+        record_file file(numbers_records(), record_schema<int>::name(), erecord_layout::FIXED, sizeof(int));
+        const int* values = reinterpret_cast<const int*>(file.data());
+        long sum = 0;
+        for(uint64_t i = 0; i < file.header().records; i++) sum += values[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()*numbers);
+}
+
+BENCHMARK(read_ifstream)->Unit(benchmark::kMillisecond);
+BENCHMARK(read_mapped)->Arg(1)->Arg(16)->Unit(benchmark::kMillisecond);
+BENCHMARK(read_records)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    std::remove(numbers_file().c_str());
+    std::remove(numbers_records().c_str());
+}
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include "../message.hpp"
+#include "../batching.hpp"
+
+using namespace dj;
+
+namespace {
+    work_unit make_work(int64_t size) {
+        work_unit work;
+        work.work_type = work_unit::ework_type::TASK_WORK;
+        work.type_name = typeid(std::string).name();
+        work.data = std::string(size, 'x');
+        work.locale = locale_info(1, "localhost", 0);
+        work.index_to = 1;
+        work.index_from = 0;
+        work.phase = ecomputation_phase::TASKS;
+        return work;
+    }
+}
+
+static void work_to_message(benchmark::State& state) {
+    work_unit work = make_work(state.range(0));
+    for(auto _: state) {
+        message mes;
+        mes << work;
+        benchmark::DoNotOptimize(mes.data);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(work_to_message)->RangeMultiplier(16)->Range(8, 1 << 16);
+
+static void message_to_work(benchmark::State& state) {
+    message mes;
+    mes << make_work(state.range(0));
+    for(auto _: state) {
+        work_unit work;
+        work << mes;
+        benchmark::DoNotOptimize(work.data);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(message_to_work)->RangeMultiplier(16)->Range(8, 1 << 16);
+
+// batches of small work messages
+static void batch_round_trip(benchmark::State& state) {
+    std::vector<message> batch(state.range(0));
+    for(message& mes: batch) mes << make_work(32);
+    for(auto _: state) {
+        std::vector<message> unpacked = unpack_batch(pack_batch(batch));
+        benchmark::DoNotOptimize(unpacked);
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(batch_round_trip)->RangeMultiplier(4)->Range(1, 1024);
+
+BENCHMARK_MAIN();
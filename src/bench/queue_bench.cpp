@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include <boost/lockfree/queue.hpp>
+#include "../message.hpp"
+
+using namespace dj;
+
+// the same queue executor keeps its work in, shared by all benchmark threads
+boost::lockfree::queue<work_unit*> qd_work(20);
+
+static void queue_push_pop(benchmark::State& state) {
+    std::vector<work_unit> work(64);
+    for(auto _: state) {
+        for(work_unit& w: work) qd_work.push(&w);
+        work_unit* popped;
+        for(uint i = 0; i < work.size(); i++) {
+            while(!qd_work.pop(popped));
+            benchmark::DoNotOptimize(popped);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * work.size());
+}
+BENCHMARK(queue_push_pop)->ThreadRange(1, 8)->UseRealTime();
+
+// one thread fills the queue as input thread does, the others drain it
+static void queue_producer_consumer(benchmark::State& state) {
+    work_unit work;
+    work_unit* popped;
+    int64_t items = 0;
+    for(auto _: state) {
+        for(int i = 0; i < 64; i++) {
+            if(state.thread_index() == 0) {
+                qd_work.push(&work);
+                items++;
+            } else if(qd_work.pop(popped)) {
+                items++;
+            }
+        }
+    }
+    state.SetItemsProcessed(items);
+    if(state.thread_index() == 0) while(qd_work.pop(popped));
+}
+BENCHMARK(queue_producer_consumer)->ThreadRange(2, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include "../message.hpp"
+
+using namespace dj;
+
+namespace {
+    std::vector<int> numbers(int64_t size) {
+        std::vector<int> v(size);
+        for(int64_t i = 0; i < size; i++) v[i] = i;
+        return v;
+    }
+}
+
+static void serialize_vector(benchmark::State& state) {
+    using serialization::operator<<;
+
+    std::vector<int> input = numbers(state.range(0));
+    std::string data;
+    for(auto _: state) {
+        data << input;
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(serialize_vector)->RangeMultiplier(8)->Range(1, 1 << 18);
+
+static void deserialize_vector(benchmark::State& state) {
+    using serialization::operator<<;
+    using serialization::operator>>;
+
+    std::string data;
+    data << numbers(state.range(0));
+    std::vector<int> output;
+    for(auto _: state) {
+        data >> output;
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(deserialize_vector)->RangeMultiplier(8)->Range(1, 1 << 18);
+
+static void serialize_string(benchmark::State& state) {
+    using serialization::operator<<;
+
+    std::string input(state.range(0), 'x');
+    std::string data;
+    for(auto _: state) {
+        data << input;
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(serialize_string)->RangeMultiplier(8)->Range(1, 1 << 20);
+
+static void deserialize_string(benchmark::State& state) {
+    using serialization::operator<<;
+    using serialization::operator>>;
+
+    std::string data;
+    data << std::string(state.range(0), 'x');
+    std::string output;
+    for(auto _: state) {
+        data >> output;
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(deserialize_string)->RangeMultiplier(8)->Range(1, 1 << 20);
+
+// scalars are written into payload without an archive
+template <typename T>
+    static void scalar_round_trip(benchmark::State& state) {
+        using serialization::operator<<;
+        using serialization::operator>>;
+
+        T input = 42;
+        T output;
+        payload data;
+        for(auto _: state) {
+            data << input;
+            data >> output;
+            benchmark::DoNotOptimize(output);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+BENCHMARK_TEMPLATE(scalar_round_trip, int);
+BENCHMARK_TEMPLATE(scalar_round_trip, double);
+
+BOOST_CLASS_EXPORT(std::vector<int>)
+
+BENCHMARK_MAIN();
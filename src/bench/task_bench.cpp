@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include "../task.hpp"
+#include "../node.hpp"
+#include "../message.hpp"
+
+using namespace dj;
+
+template <typename... Output>
+    class sink_task : public base_task<Output...> {
+
+        public:
+            sink_task() : base_task<Output...>("sink_task") { }
+
+            void operator()(int input, const std::string& /* from */) {
+                benchmark::DoNotOptimize(input);
+            }
+
+            void operator()(double input, const std::string& /* from */) {
+                benchmark::DoNotOptimize(input);
+            }
+
+            void operator()(const std::string& input, const std::string& /* from */) {
+                benchmark::DoNotOptimize(input);
+            }
+
+            void operator()(const std::vector<int>& input, const std::string& /* from */) {
+                benchmark::DoNotOptimize(input);
+            }
+
+            virtual void handle_finish() { }
+    }; 
+
+typedef task<sink_task<int>, int, double, std::string, std::vector<int>> sink_node;
+
+template <typename T>
+    static void process_work(benchmark::State& state, T value) {
+        using serialization::operator<<;
+
+        sink_node node("sink_node");
+        work_unit work;
+        work.work_type = work_unit::ework_type::TASK_WORK;
+        work.type_name = typeid(T).name();
+        work.data << value;
+        for(auto _: state) node.process_work(work, nullptr);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+// input types are tried in order of declaration
+BENCHMARK_CAPTURE(process_work, first_type, 7);
+BENCHMARK_CAPTURE(process_work, second_type, 7.0);
+BENCHMARK_CAPTURE(process_work, third_type, std::string("seven"));
+BENCHMARK_CAPTURE(process_work, fourth_type, std::vector<int>(7, 7));
+
+template <typename... Output>
+    class chunk_sink_task : public base_task<Output...> {
+
+        public:
+            chunk_sink_task() : base_task<Output...>("chunk_sink_task") { }
+
+            void operator()(int input, const std::string& /* from */) {
+                benchmark::DoNotOptimize(input);
+            }
+
+            void operator()(span<const int> inputs, const std::string& /* from */) {
+                int sum = 0;
+                for(int input: inputs) sum += input;
+                benchmark::DoNotOptimize(sum);
+            }
+
+            virtual void handle_finish() { }
+    }; 
+
+static const int records = 1024;
+
+// the same records as work of their own, as one chunk and as chunk taken by task record by record
+static void process_records(benchmark::State& state) {
+    using serialization::operator<<;
+
+    sink_node node("sink_node");
+    std::vector<work_unit> works(records);
+    for(int i = 0; i < records; i++) {
+        works[i].work_type = work_unit::ework_type::TASK_WORK;
+        works[i].type_name = typeid(int).name();
+        works[i].data << i;
+    }
+    for(auto _: state) for(auto& work: works) node.process_work(work, nullptr);
+    state.SetItemsProcessed(state.iterations()*records);
+}
+
+template <typename Node>
+    static void process_chunk(benchmark::State& state) {
+        std::vector<int> inputs(records);
+        for(int i = 0; i < records; i++) inputs[i] = i;
+
+        Node node("chunk_node");
+        work_unit work;
+        work.work_type = work_unit::ework_type::TASK_WORK;
+        work.type_name = typeid(int).name();
+        serialization::write_chunk(work.data, inputs.data(), inputs.size());
+        work.chunk = true;
+        for(auto _: state) node.process_work(work, nullptr);
+        state.SetItemsProcessed(state.iterations()*records);
+    }
+
+BENCHMARK(process_records);
+BENCHMARK_TEMPLATE(process_chunk, task<chunk_sink_task<int>, int>);
+BENCHMARK_TEMPLATE(process_chunk, sink_node);
+
+BOOST_CLASS_EXPORT(std::vector<int>)
+
+BENCHMARK_MAIN();
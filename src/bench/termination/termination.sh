@@ -0,0 +1,75 @@
+#!/bin/bash
+#
+# Latency of termination detection of every execution mode on growing numbers of local ranks.
+#
+# usage: termination.sh <termination_latency binary> <output dir> [ranks...]
+#
+# Environment:
+#   MPIRUN   launcher with its options (default: mpirun --oversubscribe)
+#   MODES    execution modes (default: RING BSP ASYNC)
+#   PASSES   numbers of passes started with pass_again (default: 1 8)
+#   RECORDS  input records of every process (default: 0)
+#   REPEAT   runs of every configuration (default: 5)
+#
+# Every run is a line of <output dir>/results.csv, medians of runs are in <output dir>/summary.txt.
+
+set -u
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <termination_latency binary> <output dir> [ranks...]" >&2
+    exit 1
+fi
+
+BIN=$1
+OUT=$2
+shift 2
+RANKS=${*:-2 4 8 16 32 64}
+MPIRUN=${MPIRUN:-mpirun --oversubscribe}
+MODES=${MODES:-RING BSP ASYNC}
+PASSES=${PASSES:-1 8}
+RECORDS=${RECORDS:-0}
+REPEAT=${REPEAT:-5}
+
+mkdir -p "$OUT"
+RESULTS=$OUT/results.csv
+SUMMARY=$OUT/summary.txt
+
+echo "mode,ranks,passes,tasks_us,reducers_us,finished_us,pass_us" > "$RESULTS"
+for ranks in $RANKS; do
+    for passes in $PASSES; do
+        for mode in $MODES; do
+            for (( i = 0; i < REPEAT; i++ )); do
+                if ! $MPIRUN -np "$ranks" "$BIN" "$mode" "$passes" "$RECORDS" >> "$RESULTS" 2> "$OUT/err"; then
+                    echo "$mode on $ranks ranks with $passes passes failed, see $OUT/err" >&2
+                    break
+                fi
+            done
+            echo "$mode ranks $ranks passes $passes done" >&2
+        done
+    done
+done
+
+# median of every column for each configuration
+tail -n +2 "$RESULTS" | sort -t, -k3,3n -k2,2n -k1,1 | awk -F, '
+    function median(values, n,    i, j, v) {
+        for(i = 2; i <= n; i++) {
+            v = values[i]
+            for(j = i - 1; j > 0 && values[j] > v; j--) values[j + 1] = values[j]
+            values[j + 1] = v
+        }
+        return (n % 2) ? values[(n + 1)/2] : (values[n/2] + values[n/2 + 1])/2
+    }
+    function flush() {
+        if(n == 0) return
+        printf "%-6s %6d %7d %12.1f %12.1f %12.1f %12.1f %5d\n", mode, ranks, passes,
+            median(tasks, n), median(reducers, n), median(finished, n), median(pass, n), n
+        delete tasks; delete reducers; delete finished; delete pass; n = 0
+    }
+    BEGIN { printf "%-6s %6s %7s %12s %12s %12s %12s %5s\n", "mode", "ranks", "passes",
+        "tasks us", "reducers us", "finished us", "pass us", "runs" }
+    {
+        key = $1 " " $2 " " $3
+        if(key != last) { flush(); last = key; mode = $1; ranks = $2; passes = $3 }
+        n++; tasks[n] = $4 + 0; reducers[n] = $5 + 0; finished[n] = $6 + 0; pass[n] = $7 + 0
+    }
+    END { flush() }' | tee "$SUMMARY"
@@ -0,0 +1,141 @@
+#include "../../DistributedJobs"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Latency of termination detection - pipeline of an empty task and an empty reducer,
+ * which starts K passes with pass_again. Every process measures moments its input ended,
+ * tasks and reducers were finished and executor reached WORK_END, the first one prints
+ * one CSV line:
+ *   mode,ranks,passes,tasks_us,reducers_us,finished_us,pass_us
+ * tasks_us and reducers_us are times from the end of input of the last process to the end
+ * of finish_all_tasks and finish_all_reducers of the first pass on the last process,
+ * finished_us to the end of the whole run and pass_us is the average time of every next pass.
+ * Processes have to run on a single machine, so that their steady clocks are comparable.
+ *
+ * usage: termination_latency [RING|BSP|ASYNC] [passes] [records per process]
+ */
+
+using namespace dj;
+
+template <typename... Output>
+    class empty_task : public base_task<Output...> {
+
+        public:
+            empty_task() : base_task<Output...>("empty_task") { }
+            void operator()(int /* input */, const std::string& /* from */) { }
+            virtual void handle_finish() override { }
+    };
+
+uint passes = 1;
+
+template <typename PipeInputType, typename InputType, typename OutputType>
+    class again_reducer : public base_reducer<PipeInputType, InputType, OutputType> {
+
+        public:
+            again_reducer() : base_reducer<PipeInputType, InputType, OutputType>("again_reducer") { }
+            virtual void reduce(const InputType& /* input */, const std::string& /* parent */) override { }
+            virtual void collect(const OutputType& /* data_to_collect */) override { }
+
+            virtual void handle_finish() override {
+                if(this->is_root_reducer() && ++finished < passes) this->pass_again(0);
+            }
+
+        private:
+            uint finished = 0;
+    };
+
+template <typename OutputerInput>
+    class empty_outputer : public base_outputer<OutputerInput> {
+
+        public:
+            empty_outputer() : base_outputer<OutputerInput>("empty_outputer") { }
+            virtual void operator()(const OutputerInput& /* input */, const std::string& /* parent */) override { }
+            virtual void handle_finish() override { }
+    };
+
+/**
+ * Every process adds the same number of records
+ */
+class counted_input : public input_provider {
+
+    public:
+        counted_input(uint records) : records(records) { }
+
+        virtual void operator()() {
+            for(uint i = 0; i < records; i++) add_input(static_cast<int>(i));
+            eof_callback();
+        }
+
+    private:
+        uint records;
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+int64_t since_epoch(clock_type::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+int main(int argc, char* argv[]) {
+
+    exec::eexecution_mode mode = exec::eexecution_mode::RING;
+    std::string mode_name = (argc > 1) ? argv[1] : "RING";
+    if(mode_name == "BSP") mode = exec::eexecution_mode::BSP;
+    else if(mode_name == "ASYNC") mode = exec::eexecution_mode::ASYNC;
+    else if(mode_name != "RING") {
+        std::cerr << "unknown mode " << mode_name << std::endl;
+        return 1;
+    }
+    passes = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 1;
+    uint records = (argc > 3) ? std::atoi(argv[3]) : 0;
+
+    execution_pipeline exec_pipe(std::unique_ptr<input_provider>(new counted_input(records)));
+    node_graph& graph = exec_pipe.get_node_graph();
+
+    uint task_index = graph.add(std::unique_ptr<task_node>(new task<empty_task<int>, int>("task")));
+    uint reducer_index = graph.add(std::unique_ptr<reducer_node>(
+                new reducer<again_reducer, int, int, int>("reducer", reducer_node::ereducer_type::SINGLE)));
+    uint output_index = graph.add(std::unique_ptr<output_node>(new outputer<empty_outputer, int>("out")));
+    graph.set_root(task_index);
+    graph.add_reducer_to_task(reducer_index, task_index);
+    graph.add_output_to_reducer(output_index, reducer_index);
+
+    // hostname is not passed, arguments are of the benchmark
+    char* exec_argv[] = { argv[0] };
+    exec::executor processor(1, exec_argv, exec_pipe);
+    processor.set_execution_mode(mode);
+    processor.start();
+
+    // { eof, tasks of first pass, reducers of first pass, reducers of last pass, finished }
+    const exec::termination_times& times = processor.termination();
+    if(times.tasks_finished.empty() || times.reducers_finished.empty()) {
+        std::cerr << "no pass finished on process " << processor.context().rank << std::endl;
+        return 1;
+    }
+    int64_t local[5] = {
+        since_epoch(times.eof),
+        since_epoch(times.tasks_finished.front()),
+        since_epoch(times.reducers_finished.front()),
+        since_epoch(times.reducers_finished.back()),
+        since_epoch(times.finished)
+    };
+    int64_t last[5];
+    // executor may still have a request posted on world
+    boost::mpi::communicator world;
+    boost::mpi::communicator results(world, boost::mpi::comm_duplicate);
+    boost::mpi::reduce(results, local, 5, last, boost::mpi::maximum<int64_t>(), 0);
+
+    if(results.rank() == 0) {
+        auto us = [](int64_t ns) { return ns/1000.0; };
+        std::cout << mode_name << "," << results.size() << "," << passes
+            << "," << us(last[1] - last[0])
+            << "," << us(last[2] - last[0])
+            << "," << us(last[4] - last[0])
+            << "," << ((passes > 1) ? us(last[3] - last[2])/(passes - 1) : 0.0)
+            << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "../../DistributedJobs"
+
+#include <boost/serialization/export.hpp>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/extended_type_info_no_rtti.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <climits>
+#include <istream>
+
+using namespace std;
+
+// Node structure - the same input as in map_reduce_bfs
+struct node {
+    int id;
+    vector<int> adj;
+    int dist;
+
+    friend istream& operator>>(istream& is, node& n) {
+        n.adj.clear();
+        int v = 0, e, c;
+        if(!(is >> n.id >> v)) return is;
+        for(int i = 0; i < v; i++) {
+            is >> e;
+            n.adj.push_back(e);
+        }
+        is >> n.dist;
+        if(n.dist) n.dist = INT_MAX;
+        else n.dist = 0;
+        is >> c; // color is not needed here
+        return is;
+    }
+
+    private:
+        friend class boost::serialization::access;
+        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+            ar & id;
+            ar & adj;
+            ar & dist;
+        }
+};
+
+// Tentative distance of a node
+struct visit {
+    int id;
+    int dist;
+
+    private:
+        friend class boost::serialization::access;
+        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+            ar & id;
+            ar & dist;
+        }
+};
+
+template <typename... OutputParameters>
+    class loader : public dj::base_task<OutputParameters...> { };
+
+// Sends every node to the process owning it
+template <>
+    class loader<node> : public dj::base_task<node>
+{
+
+    public:
+        loader() : dj::base_task<node>("loader") { }
+
+        void operator()(const node& input, const std::string& /* from */) {
+            emit<node, dj::enode_type::TASK>(input, "relaxer", input.id%world_size());
+        }
+
+        virtual void handle_finish() override { }
+};
+
+template <typename... OutputParameters>
+    class relaxer : public dj::base_task<OutputParameters...> { };
+
+// Keeps the best known distance of its nodes and propagates every improvement
+// to neighbours right away. Shorter distances are processed first.
+template <>
+    class relaxer<visit> : public dj::base_task<visit>
+{
+
+    public:
+        relaxer() : dj::base_task<visit>("relaxer") { }
+
+        void operator()(const node& input, const std::string& /* from */) {
+            state& st = nodes[input.id];
+            st.adj = input.adj;
+            st.loaded = true;
+            if(input.dist < st.dist) st.dist = input.dist;
+            if(st.dist != INT_MAX) propagate(st);
+        }
+
+        void operator()(const visit& input, const std::string& /* from */) {
+            state& st = nodes[input.id];
+            if(input.dist >= st.dist) return;
+            st.dist = input.dist;
+            if(st.loaded) propagate(st);
+        }
+
+        virtual void handle_finish() override {
+            for(auto& p: nodes)
+                emit<visit, dj::enode_type::OUTPUT>({ p.first, p.second.dist });
+            nodes.clear();
+        }
+
+    private:
+        struct state {
+            vector<int> adj;
+            int dist = INT_MAX;
+            bool loaded = false;
+        };
+
+        void propagate(const state& st) {
+            for(int u: st.adj)
+                emit_with_priority<visit, dj::enode_type::TASK>(
+                        { u, st.dist+1 }, st.dist+1, "relaxer", u%world_size());
+        }
+
+        unordered_map<int, state> nodes;
+};
+
+template <typename OutputerInput>
+    class outputer;
+
+template <>
+    class outputer<visit> : public dj::base_outputer<visit>
+    {
+
+        public:
+            outputer() : dj::base_outputer<visit>("outputer") { }
+
+            virtual void operator()(const visit& input, const std::string& /* parent */) override {
+                std::cout << "Node: " << input.id << " - " << input.dist << std::endl;
+            }
+
+            virtual void handle_finish() override { }
+    };
+
+typedef dj::task<loader<node>, node> ln;
+typedef dj::task<relaxer<visit>, node, visit> rn;
+typedef dj::outputer<outputer, visit> on;
+
+int main(int argc, char* argv[]) {
+    dj::execution_pipeline exec_pipe(std::unique_ptr<dj::input_provider>(
+                new dj::input::single_stdin_input<node>()));
+    dj::node_graph& graph = exec_pipe.get_node_graph();
+
+    std::unique_ptr<dj::task_node> loader_ptr(new ln("loader"));
+    std::unique_ptr<dj::task_node> relaxer_ptr(new rn("relaxer"));
+    std::unique_ptr<dj::output_node> out_ptr(new on("outputer"));
+
+    uint root_index = graph.add(std::move(loader_ptr));
+    uint relaxer_index = graph.add(std::move(relaxer_ptr));
+    uint output_index = graph.add(std::move(out_ptr));
+
+    graph.set_root(root_index);
+    graph.add_directed(root_index, relaxer_index);
+    graph.add_directed(relaxer_index, relaxer_index);
+    graph.add_output_to_task(output_index, relaxer_index);
+
+    dj::exec::executor processor(argc, argv, exec_pipe);
+    processor.set_execution_mode(dj::exec::eexecution_mode::ASYNC); // no passes, ends on quiescence
+    processor.start();
+
+    return 0;
+}
+BOOST_SERIALIZATION_FACTORY_0(node)
+BOOST_CLASS_EXPORT(node)
+BOOST_SERIALIZATION_FACTORY_0(visit)
+BOOST_CLASS_EXPORT(visit)
+BOOST_SERIALIZATION_FACTORY_0(vector<int>)
+BOOST_CLASS_EXPORT(vector<int>)
@@ -0,0 +1,66 @@
+#ifndef TRIANGLE_EDGE_HPP
+#define TRIANGLE_EDGE_HPP
+
+#include <istream>
+#include <ostream>
+#include "../../DistributedJobs"
+
+struct edge {
+
+    int u, v;
+
+    friend bool operator==(const edge& e1, const edge& e2) {
+        return (e1.u == e2.u && e1.v == e2.v) || (e1.u == e2.v && e1.v == e2.u);
+    }
+
+    friend bool operator!=(const edge& e1, const edge& e2) {
+        return !(e1 == e2);
+    }
+
+    friend  std::istream& operator>>(std::istream& is, edge& e) {
+        is >> e.u;
+        is >> e.v;
+        return is;
+    }
+
+    friend  std::ostream& operator<<(std::ostream& os, const edge& e) {
+        os << e.u << " " << e.v << std::endl;
+        return os;
+    }
+
+    private:
+        friend class boost::serialization::access;
+        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+            ar & u;
+            ar & v;
+        }
+};
+
+// edges are sent and kept in record files as their bytes
+namespace dj { namespace serialization {
+    template <> struct is_bitwise<edge> : std::true_type { };
+} }
+
+namespace dj {
+    // edges of text files are read as pairs of integers
+    template <> 
+        struct text_parser<edge> {
+
+            template <typename F>
+                static void parse(const char* begin, const char* end, F f) {
+                    text_scanner in(begin, end);
+                    edge e;
+                    while(in.next(e.u) && in.next(e.v)) f(e);
+                }
+        };
+
+    // shared with graph_generate
+    template <>
+        struct record_schema<edge> {
+            static std::string name() {
+                return "edge { int32 u; int32 v; }";
+            }
+        };
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "../../DistributedJobs"
+#include "edge.hpp"
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/extended_type_info_no_rtti.hpp>
@@ -7,6 +8,7 @@
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
+#include <algorithm>
 #include <tuple>
 #include <random>
 #include <istream>
@@ -14,37 +16,6 @@
 
 typedef std::mt19937 my_rng;
 
-struct edge {
-
-    int u, v;
-
-    friend bool operator==(const edge& e1, const edge& e2) {
-        return (e1.u == e2.u && e1.v == e2.v) || (e1.u == e2.v && e1.v == e2.u);
-    }
-
-    friend bool operator!=(const edge& e1, const edge& e2) {
-        return !(e1 == e2);
-    }
-
-    friend  std::istream& operator>>(std::istream& is, edge& e) {
-        is >> e.u;
-        is >> e.v;
-        return is;
-    }
-
-    friend  std::ostream& operator<<(std::ostream& os, const edge& e) {
-        os << e.u << " " << e.v << std::endl;
-        return os;
-    }
-
-    private:
-        friend class boost::serialization::access;
-        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
-            ar & u;
-            ar & v;
-        }
-};
-
 inline bool is_adjacent(const edge& e1, const edge& e2) {
     if(e1.u == e2.u && e1 != e2) return true;
     if(e1.v == e2.u && e1 != e2) return true;
@@ -103,6 +74,11 @@ struct site_result {
         }
 };
 
+// coordinator messages are sent as their bytes
+namespace dj { namespace serialization {
+    template <> struct is_bitwise<coordinator_message> : std::true_type { };
+} }
+
 // site node
 template <typename... OutputParameters>
     class site;
@@ -277,8 +253,14 @@ int main(int argc, char* argv[]) {
     std::vector<std::string> filenames;
     for(int i = 1; i < argc; i++) filenames.emplace_back(argv[i]);
 
-    dj::execution_pipeline exec_pipe(std::unique_ptr<dj::input_provider>(
-                new dj::input::multi_file_input_provider<edge>(filenames)));
+    // record files written by graph_generate are read without parsing
+    bool records = !filenames.empty() && std::all_of(filenames.begin(), filenames.end(), [](const std::string& name) {
+                return name.size() > 4 && name.compare(name.size() - 4, 4, ".rec") == 0;
+            });
+    std::unique_ptr<dj::input_provider> input;
+    if(records) input.reset(new dj::input::record_file_input<edge>(filenames));
+    else input.reset(new dj::input::mmap_file_input<edge>(filenames));
+    dj::execution_pipeline exec_pipe(std::move(input));
     dj::node_graph& graph = exec_pipe.get_node_graph();
 
     typedef dj::task<site<site_result, coordinator_message>, edge, coordinator_message> site_task;
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <fstream>
 #include <memory>
+#include "../edge.hpp"
 
 using namespace std;
 
@@ -33,7 +34,14 @@ int main(int argc, char* argv[]) {
     string bfname = "edges_";
     unique_ptr<ofstream> *files = new unique_ptr<ofstream>[fn];
 
-    for(int i = 0; i < fn; i++) files[i].reset(new ofstream(bfname + to_string(i+1)));
+    // record files are read by graph_stream_triangle_count without parsing
+    bool records = argc > 3 && string(argv[3]) == "records";
+    vector<unique_ptr<dj::record_writer<edge>>> record_files;
+
+    for(int i = 0; i < fn; i++) {
+        if(records) record_files.emplace_back(new dj::record_writer<edge>(bfname + to_string(i+1) + ".rec"));
+        else files[i].reset(new ofstream(bfname + to_string(i+1)));
+    }
 
     random_device rd;
     mt19937 rng(rd());
@@ -45,7 +53,10 @@ int main(int argc, char* argv[]) {
             while(v == u) v = dist(rng);
             if(!is_edge(u,v)) {
                 add_edge(u,v);
-                for(int k = 0; k < fn; k++) *files[k] << u << " " << v << endl;
+                for(int k = 0; k < fn; k++) {
+                    if(records) record_files[k]->write(edge{u, v});
+                    else *files[k] << u << " " << v << endl;
+                }
             }
         } 
     }
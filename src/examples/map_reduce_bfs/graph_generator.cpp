@@ -8,10 +8,12 @@
 #include <climits>
 #include <algorithm>
 #include <queue>
+#include "node.hpp"
+#include <boost/serialization/export.hpp>
 
 using namespace std;
 
-int main(int /*argc */, char* argv[]) {
+int main(int argc, char* argv[]) {
     int N = stoi(argv[1]);
     int E = stoi(argv[2]);
     assert(E >= N-1);
@@ -36,15 +38,21 @@ int main(int /*argc */, char* argv[]) {
         graph[v].push_back(u);
     }
 
-    std::ofstream out(argv[3]);
+    // record file is read by map_reduce_bfs without parsing
+    if(argc > 4 && string(argv[4]) == "records") {
+        dj::record_writer<node> out(argv[3]);
+        for(int i = 0; i < N; i++) out.write(node{ i, graph[i], (i) ? INT_MAX : 0, (i) ? node::WHITE : node::GREY });
+    } else {
+        std::ofstream out(argv[3]);
 
-    for(int i = 0; i < N; i++) {
-        out << i << std::endl;
-        out << graph[i].size() << " ";
-        for(auto v: graph[i]) out << v << " ";
-        out << endl;
-        out << ((i) ? INT_MAX : 0) << endl;
-        out << ((i) ? 0 : 1) << endl;
+        for(int i = 0; i < N; i++) {
+            out << i << std::endl;
+            out << graph[i].size() << " ";
+            for(auto v: graph[i]) out << v << " ";
+            out << endl;
+            out << ((i) ? INT_MAX : 0) << endl;
+            out << ((i) ? 0 : 1) << endl;
+        }
     }
 
     // bfs
@@ -71,3 +79,7 @@ int main(int /*argc */, char* argv[]) {
         cout << "Node: " << i << " - " << D[i] << endl;
     }
 }
+BOOST_SERIALIZATION_FACTORY_0(node)
+BOOST_CLASS_EXPORT(node)
+BOOST_SERIALIZATION_FACTORY_0(vector<int>)
+BOOST_CLASS_EXPORT(vector<int>)
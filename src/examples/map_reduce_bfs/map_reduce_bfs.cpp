@@ -1,4 +1,5 @@
 #include "../../DistributedJobs"
+#include "node.hpp"
 
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/serialization.hpp>
@@ -17,48 +18,6 @@
 
 using namespace std;
 
-// Node structure
-struct node {
-    int id;
-    vector<int> adj;
-    int dist;
-    enum ecolor { WHITE, GREY, BLACK } color;
-
-    friend ostream& operator<<(ostream& os, const node& n) {
-        os << "id: " << n.id << " dist: " << n.dist << " color: " << n.color <<
-            " adj: ";
-        for(int i: n.adj) os << i << " ";
-        return os;
-    }
-
-    friend istream& operator>>(istream& is, node& n) {
-        n.adj.clear();
-        is >> n.id;
-        int v, e;
-        is >> v;
-        for(int i = 0; i < v; i++) {
-            is >> e;
-            n.adj.push_back(e);
-        }
-        is >> n.dist;
-        if(n.dist) n.dist = INT_MAX;
-        else n.dist = 0;
-        int c;
-        is >> c;
-        n.color = (ecolor)c;
-        return is;
-    }
-
-    private:
-        friend class boost::serialization::access;
-        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
-            ar & id;
-            ar & adj;
-            ar & dist;
-            ar & color;
-        }
-};
-
 template <typename... OutputParameters>
     class mapper : public dj::base_task<OutputParameters...> { };
 
@@ -74,10 +33,9 @@ template <>
             if(all_black) 
                 emit<node, dj::enode_type::OUTPUT>(input);
             else {
-                a++;
+                if(input.color != node::BLACK) aggregate<int>("not_black", 1);
                 switch(input.color) {
                     case node::BLACK:
-                        b++;
                     case node::WHITE:
                         emit<node, dj::enode_type::TASK>(input, "site", input.id%world_size());
                         break;
@@ -97,13 +55,11 @@ template <>
         }
 
         virtual void handle_finish() override { 
-            if(b == a) all_black = true;
-            p++;
-            b = a = 0;
+            // the same decision on every process
+            if(aggregated<int>("not_black") == 0) all_black = true;
         }
 
     private:
-        int b = 0, a = 0, p = 0;
         bool all_black = false;
 };
 
@@ -199,9 +155,15 @@ typedef dj::reducer<node_reducer, node, node, node> rn;
 typedef dj::outputer<outputer, node> on;
 
 int main(int argc, char* argv[]) {
-    dj::execution_pipeline exec_pipe(std::unique_ptr<dj::input_provider>(
-                new dj::input::single_stdin_input<node>()));
+    // record files written by graph_generator are read without parsing, text comes on standard input
+    std::vector<std::string> filenames(argv + 1, argv + argc);
+    std::unique_ptr<dj::input_provider> input;
+    if(filenames.empty()) input.reset(new dj::input::scatter_stdin_input<node>());
+    else input.reset(new dj::input::record_file_input<node>(filenames));
+    dj::execution_pipeline exec_pipe(std::move(input));
     dj::node_graph& graph = exec_pipe.get_node_graph();
+    // nodes which are not black yet on all processes
+    exec_pipe.get_aggregators().add<int>("not_black", dj::eaggregation::SUM);
 
     std::unique_ptr<dj::task_node> mapper_ptr(new mn("mapper"));
     std::unique_ptr<dj::task_node> site_ptr(new sn("site"));
@@ -219,6 +181,7 @@ int main(int argc, char* argv[]) {
     graph.add_reducer_to_task(reducer_index, site_index);
 
     dj::exec::executor processor(argc, argv, exec_pipe);
+    processor.set_execution_mode(dj::exec::eexecution_mode::BSP); // every pass is a superstep
     processor.start();
 
     return 0;
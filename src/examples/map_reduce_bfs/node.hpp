@@ -0,0 +1,62 @@
+#ifndef BFS_NODE_HPP
+#define BFS_NODE_HPP
+
+#include <boost/serialization/vector.hpp>
+#include <climits>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "../../DistributedJobs"
+
+// Node structure
+struct node {
+    int id;
+    std::vector<int> adj;
+    int dist;
+    enum ecolor { WHITE, GREY, BLACK } color;
+
+    friend std::ostream& operator<<(std::ostream& os, const node& n) {
+        os << "id: " << n.id << " dist: " << n.dist << " color: " << n.color <<
+            " adj: ";
+        for(int i: n.adj) os << i << " ";
+        return os;
+    }
+
+    friend std::istream& operator>>(std::istream& is, node& n) {
+        n.adj.clear();
+        int v = 0, e;
+        if(!(is >> n.id >> v)) return is;
+        for(int i = 0; i < v; i++) {
+            is >> e;
+            n.adj.push_back(e);
+        }
+        is >> n.dist;
+        if(n.dist) n.dist = INT_MAX;
+        else n.dist = 0;
+        int c;
+        is >> c;
+        n.color = (ecolor)c;
+        return is;
+    }
+
+    private:
+        friend class boost::serialization::access;
+        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+            ar & id;
+            ar & adj;
+            ar & dist;
+            ar & color;
+        }
+};
+
+namespace dj {
+    // shared with graph_generator
+    template <>
+        struct record_schema<node> {
+            static std::string name() {
+                return "node { int32 id; vector<int32> adj; int32 dist; int32 color; }";
+            }
+        };
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "../../DistributedJobs"
+
+#include <boost/serialization/export.hpp>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/extended_type_info_no_rtti.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <iostream>
+#include <string>
+#include <map>
+#include <functional>
+
+using namespace std;
+
+const uint64_t window_size = 10;
+
+// Count of a word in a window
+struct window_count {
+    uint64_t start;
+    uint64_t end;
+    string word;
+    int count;
+
+    private:
+        friend class boost::serialization::access;
+        template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+            ar & start;
+            ar & end;
+            ar & word;
+            ar & count;
+        }
+};
+
+// Reads lines of "event_time word" on the first process,
+// records may be out of order by at most one window
+class event_input : public dj::input_provider {
+
+    public:
+        event_input() {
+            set_watermarks(window_size, 16);
+        }
+
+        virtual void operator()() {
+            uint64_t event_time;
+            string word;
+            if(processor->context().rank == 0)
+                while(cin >> event_time >> word)
+                    add_input(word, event_time);
+            eof_callback();
+        }
+};
+
+template <typename... OutputParameters>
+    class splitter : public dj::base_task<OutputParameters...> { };
+
+// Sends every word to the process counting it
+template <>
+    class splitter<string> : public dj::base_task<string>
+{
+
+    public:
+        splitter() : dj::base_task<string>("splitter") { }
+
+        void operator()(const string& input, const std::string& /* from */) {
+            emit<string, dj::enode_type::TASK>(input, "counter", hash<string>()(input)%world_size());
+        }
+
+        virtual void handle_finish() override { }
+};
+
+template <typename... OutputParameters>
+    class counter : public dj::base_task<OutputParameters...> { };
+
+// Counts words in tumbling windows, counts are emitted as soon as watermark passes end of window
+template <>
+    class counter<window_count> : public dj::base_task<window_count>
+{
+
+    typedef map<string, int, less<string>, dj::arena_allocator<pair<const string, int>>> counts;
+
+    public:
+        counter() : dj::base_task<window_count>("counter") {
+            set_window(dj::window_spec::tumbling(window_size));
+        }
+
+        void operator()(const string& input, const std::string& /* from */) {
+            for(const dj::window& w: current_windows())
+                window_state<counts>(w, counts::allocator_type(window_arena(w)))[input]++;
+        }
+
+        virtual void handle_window(const dj::window& w) override {
+            for(auto& p: window_state<counts>(w, counts::allocator_type(window_arena(w))))
+                emit<window_count, dj::enode_type::OUTPUT>({ w.start, w.end, p.first, p.second });
+        }
+
+        virtual void handle_finish() override { }
+};
+
+template <typename OutputerInput>
+    class outputer;
+
+template <>
+    class outputer<window_count> : public dj::base_outputer<window_count>
+    {
+
+        public:
+            outputer() : dj::base_outputer<window_count>("outputer") { }
+
+            virtual void operator()(const window_count& input, const std::string& /* parent */) override {
+                std::cout << "[" << input.start << ", " << input.end << ") "
+                    << input.word << ": " << input.count << std::endl;
+            }
+
+            virtual void handle_finish() override { }
+    };
+
+typedef dj::task<splitter<string>, string> sn;
+typedef dj::task<counter<window_count>, string> cn;
+typedef dj::outputer<outputer, window_count> on;
+
+int main(int argc, char* argv[]) {
+    dj::execution_pipeline exec_pipe(std::unique_ptr<dj::input_provider>(new event_input()));
+    dj::node_graph& graph = exec_pipe.get_node_graph();
+
+    std::unique_ptr<dj::task_node> splitter_ptr(new sn("splitter"));
+    std::unique_ptr<dj::task_node> counter_ptr(new cn("counter"));
+    std::unique_ptr<dj::output_node> out_ptr(new on("outputer"));
+
+    uint root_index = graph.add(std::move(splitter_ptr));
+    uint counter_index = graph.add(std::move(counter_ptr));
+    uint output_index = graph.add(std::move(out_ptr));
+
+    graph.set_root(root_index);
+    graph.add_directed(root_index, counter_index);
+    graph.add_output_to_task(output_index, counter_index);
+
+    dj::exec::executor processor(argc, argv, exec_pipe);
+    processor.set_target_latency(std::chrono::milliseconds(5)); // records are sent in micro-batches
+    processor.start();
+
+    if(processor.late_records() > 0)
+        std::cerr << "late records: " << processor.late_records() << std::endl;
+
+    return 0;
+}
+BOOST_SERIALIZATION_FACTORY_0(window_count)
+BOOST_CLASS_EXPORT(window_count)
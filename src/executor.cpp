@@ -1,17 +1,26 @@
 #include "executor.hpp"
+#include "mpi_transport.hpp"
 #include "message.hpp"
 #include "pipeline.hpp"
 #include "node.hpp"
 
 #include <cmath>
 #include <functional>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <fstream>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 
 namespace dj {
 
     namespace exec {
 
         inline bool is_work_tag(int tag) {
-            return (tag >= 0 && tag <= static_cast<int>(work_unit::ework_type::TASK_WORK_OUTPUT));
+            return (tag >= 0 && tag <= static_cast<int>(work_unit::ework_type::WATERMARK));
         }
 
         inline bool is_end_tag(int tag) {
@@ -19,13 +28,33 @@ namespace dj {
                     && tag <= static_cast<int>(end_message::eend_message_type::WORK_END));
         }
 
+        // names of trace events
+        const char* end_names[] = { "TASK_END", "REDUCTION_END", "WORK_END" };
+        const char* phase_names[] = { "TASKS", "REDUCTION", "PIPE_END", "WORK_END" };
+
+        inline const char* end_name(end_message::eend_message_type type) {
+            return end_names[static_cast<int>(type) - static_cast<int>(end_message::eend_message_type::TASK_END)];
+        }
+
         executor::executor(int argc, char* argv[], execution_pipeline& pipeline)
-            : qd_work(20), 
-            pipeline(pipeline)
+            : executor(std::unique_ptr<transport>(new mpi_transport()), pipeline)
         {
-            _exec_context.rank = world.rank();
-            _exec_context.size = world.size();
             if(argc >= 2) _exec_context.hostname = argv[1];
+        }
+
+        executor::executor(std::unique_ptr<transport> ranks, execution_pipeline& pipeline)
+            : _transport(std::move(ranks)),
+            qd_input(20),
+            pipeline(pipeline)
+        {
+            _exec_context.rank = _transport->rank();
+            _exec_context.size = _transport->size();
+            if(const char* prefix = std::getenv("DJ_METRICS")) metrics_prefix = prefix;
+            if(const char* prefix = std::getenv("DJ_TRACE")) trace_prefix = prefix;
+            if(const char* prefix = std::getenv("DJ_TRAFFIC")) traffic_prefix = prefix;
+            if(const char* prefix = std::getenv("DJ_LATENCY")) latency_prefix = prefix;
+            if(const char* every = std::getenv("DJ_LATENCY_EVERY")) latency_every = std::stoul(every);
+            if(const char* capacity = std::getenv("DJ_INBOUND_CAPACITY")) _inbound_capacity = std::stoul(capacity);
 
             locale_info::_context = &_exec_context;
             pipeline.provide_executor(this);
@@ -44,56 +73,186 @@ namespace dj {
             return pipeline;
         }
 
+        aggregator_registry& executor::get_aggregators() {
+            return pipeline.get_aggregators();
+        }
+
+        void executor::set_execution_mode(eexecution_mode mode) {
+            this->mode = mode;
+        }
+
+        eexecution_mode executor::execution_mode() const {
+            return mode;
+        }
+
+        void executor::set_target_latency(std::chrono::microseconds target) {
+            batching = target.count() > 0;
+            batch_size.set_target(target);
+            input_chunk.set_target(target);
+        }
+
+        void executor::set_inbound_capacity(uint records) {
+            _inbound_capacity = records;
+        }
+
+        uint executor::inbound_capacity() const {
+            return _inbound_capacity;
+        }
+
+        void executor::set_lane_weights(std::vector<uint> weights) {
+            lanes.set_weights(std::move(weights));
+        }
+
+        void executor::set_shared_memory(bool enabled, std::size_t ring_size) {
+            _transport->set_shared_memory(enabled, ring_size);
+        }
+
+        void executor::set_progress_thread(bool enabled) {
+            _transport->set_progress_thread(enabled);
+        }
+
+        transport& executor::get_transport() {
+            return *_transport;
+        }
+
+        void executor::set_metrics_output(std::string prefix) {
+            metrics_prefix = std::move(prefix);
+        }
+
+        void executor::set_trace_output(std::string prefix) {
+            trace_prefix = std::move(prefix);
+        }
+
+        void executor::set_traffic_output(std::string prefix) {
+            traffic_prefix = std::move(prefix);
+        }
+
+        void executor::set_latency_sampling(uint every, std::string prefix) {
+            latency_every = every;
+            latency_prefix = std::move(prefix);
+        }
+
         // TODO better eof handling depending on input types
         void executor::start() {
 
             if(!pipeline.get_node_graph().is_correct()) 
                 throw std::runtime_error("given graph in pipeline is not correct");
+            // next pass of ring starts only in the process its input goes to, others would never
+            // come to combine aggregators with it
+            if(mode == eexecution_mode::RING && !pipeline.get_aggregators().empty())
+                throw std::runtime_error("aggregators need BSP or ASYNC execution mode");
 
             encountered_eof = false;
-            bool had_work = false;
+            termination_moments = termination_times();
+            watermarks = pipeline.get_input_provider().emits_watermarks();
+            if(watermarks) set_watermark_routes();
+            set_node_metrics();
+            trace.clear();
+            if(!trace_prefix.empty()) trace.enable();
+            trace.set_thread_name("executor");
+            traffic.reset(_exec_context.rank, _exec_context.size);
+            latency.reset(latency_prefix.empty() ? 0 : latency_every);
+            for(auto& o: pipeline.get_node_graph().get_output_nodes()) latency.add_output(o->index(), o->name());
 
-            input_thread.reset(new std::thread([this]() { pipeline.get_input_provider()(); }));
+            input_thread.reset(new std::thread([this]() { 
+                        locale_info::_context = &_exec_context;
+                        trace.set_thread_name("input");
+                        pipeline.get_input_provider()(); 
+                    }));
             is_finished = false;
-            bool pending_request = false;
+            _transport->set_tracer(&trace);
+            _transport->start();
+            lanes.set_prioritized(mode == eexecution_mode::ASYNC);
             sent_task_end = false;
             sent_reduction_end = false;
             sent_work_end = false;
             going_again = false;
             finished = 0;
             pass_number = 0;
-            phase = ecomputation_phase::TASKS;
-
-            boost::optional<mpi::status> req_status;
+            current_pass = 0;
+            sent_work_count = 0;
+            received_work_count = 0;
+            urgent_sent.assign(_exec_context.size, 0);
+            urgent_received.assign(_exec_context.size, 0);
+            phase_started = clock::now();
+            set_phase(ecomputation_phase::TASKS);
 
             wait_end_que.clear();
+            batches.clear();
+            batches.resize(_exec_context.size);
+            batch_started.assign(_exec_context.size, clock::time_point());
+            // inbound capacity is shared by all other processes
+            credits.reset(_exec_context.size, (_inbound_capacity > 0 && _exec_context.size > 1) 
+                    ? std::max<uint64_t>(1, _inbound_capacity/(_exec_context.size-1)) : 0);
+            credit_stall_started = clock::time_point();
+            parked = std::vector<std::deque<object_pool<work_unit>::pointer>>(_exec_context.size);
+            parked_count = 0;
+            input_stall_ns = 0;
 
-            std::unique_ptr<work_unit> new_work;
-            std::unique_ptr<end_message> end_mes;
+            // nodes without inputs will not wait for anything
+            for(const node_id& node: watermark_progress.nodes())
+                if(watermark_progress.watermark(node) == max_watermark) advance_watermark(node);
 
-            while(!is_finished) {
+            switch(mode) {
+                case eexecution_mode::RING:
+                    run_ring();
+                    break;
+                case eexecution_mode::BSP:
+                    run_bsp();
+                    break;
+                case eexecution_mode::ASYNC:
+                    run_async();
+                    break;
+            }
 
-                // send request if it is not sent already
-                if(!pending_request) {
-                    request_data();
-                    pending_request = true;
-                }
+            flush_batches(false);
+            if(!metrics_prefix.empty()) {
+                record_phase_time();
+                metrics.add_input_stall(input_stall_ns);
+                struct rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+                metrics.set_peak_rss(usage.ru_maxrss);
+                dump_report(metrics_prefix, metrics, metrics_registry(), [this](const metrics_registry& m, int rank) {
+                            return m.to_json(rank, (rank == -1) ? _exec_context.size : 1);
+                        });
+            }
+            if(!traffic_prefix.empty()) {
+                traffic_matrix merged;
+                merged.reset(_exec_context.rank, _exec_context.size);
+                dump_report(traffic_prefix, traffic, std::move(merged), [](const traffic_matrix& t, int) {
+                            return t.to_json();
+                        });
+            }
+            if(!latency_prefix.empty()) {
+                dump_report(latency_prefix, latency, latency_sampler(), [this](const latency_sampler& l, int rank) {
+                            return l.to_json(rank, (rank == -1) ? _exec_context.size : 1);
+                        });
+            }
+            _transport->barrier(); // wait for others to finish
 
-                // process work in queue
-                work_unit* work_ptr;
-                had_work = false;
-                while(qd_work.pop(work_ptr)) {
-                    had_work = true;
-                    new_work.reset(work_ptr);
-                    compute_work(*new_work);
-                }
+            stop_threads();
+            if(!trace_prefix.empty()) dump_trace();
+            _transport->finish();
+        }
+
+        void executor::run_ring() {
+
+            bool had_work = false;
+            object_pool<end_message>::pointer end_mes = end_pool.wrap(nullptr);
+
+            while(!is_finished) {
+
+                // process work in queue, parked work is not done yet either
+                had_work = process_queued_work() || parked_count > 0;
                 if(going_again) {
                     going_again = false; // we started recurrence
                     reset_run();
                 }
                 // process messages related only if had no work previously
+                // end message waits for urgent messages its sender sent before it on the other channel
                 if(!had_work) {
-                    while(!end_que.empty()) {
+                    uint previous = (_exec_context.rank + _exec_context.size - 1) % _exec_context.size;
+                    while(!end_que.empty() && end_que.front()->urgent_sent <= urgent_received[previous]) {
                         end_mes.reset(end_que.front());
                         end_que.pop_front();
                         process_end_message(*end_mes.get(), had_work);
@@ -101,110 +260,354 @@ namespace dj {
                 }
 
                 // check if new messages appeard
-                req_status = receive_request.test();
-                if(req_status && !is_finished) {
-
-                    pending_request = false;
-                    // enqueue new work
-                    if(is_work_tag(req_status->tag())) {
-                        message mes = { req_status->tag(), buffer };
-                        work_ptr = new work_unit();
-                        *work_ptr << mes;
-                        qd_work.push(work_ptr);
-                    // enqueue end messages
-                    } else if(is_end_tag(req_status->tag())) {
-                        message mes = { req_status->tag(), buffer };
-                        end_message* end_ptr = new end_message();
-                        *end_ptr << mes;
-                        end_que.push_back(end_ptr);
-                    } else { // something is fucked up
-                        throw std::runtime_error("Unrecognized tag: " + std::to_string(req_status->tag()));
-                    }
+                if(!receive_message() && !is_finished) {
                 // check if we should start a "circle of death"
                 // WARNING in current implementation only process with rank = 0 can start circle of death
-                } else if(encountered_eof && !had_work && _exec_context.rank == 0) { 
-                    if(!sent_task_end && phase == ecomputation_phase::TASKS) {
-                        tell_about_the_end(end_message::eend_message_type::TASK_END, 1, _exec_context.rank, 1);
-                        sent_task_end = true;
-                    } else if(!sent_reduction_end && phase == ecomputation_phase::REDUCTION) {
-                        tell_about_the_end(end_message::eend_message_type::REDUCTION_END, 1, _exec_context.rank, 1);
-                        sent_reduction_end = true;
-                    } else if(!sent_work_end && phase == ecomputation_phase::PIPE_END) {
-                        tell_about_the_end(end_message::eend_message_type::WORK_END, 1, _exec_context.rank, 1);
-                        sent_work_end = true;
+                    if(input_finished() && !had_work && _exec_context.rank == 0) { 
+                        if(!sent_task_end && phase == ecomputation_phase::TASKS) {
+                            tell_about_the_end(end_message::eend_message_type::TASK_END, 1, _exec_context.rank, 1);
+                            sent_task_end = true;
+                        } else if(!sent_reduction_end && phase == ecomputation_phase::REDUCTION) {
+                            tell_about_the_end(end_message::eend_message_type::REDUCTION_END, 1, _exec_context.rank, 1);
+                            sent_reduction_end = true;
+                        } else if(!sent_work_end && phase == ecomputation_phase::PIPE_END) {
+                            tell_about_the_end(end_message::eend_message_type::WORK_END, 1, _exec_context.rank, 1);
+                            sent_work_end = true;
+                        }
                     }
                 }
             }
+        }
 
-            world.barrier(); // wait for others to finish
+        /**
+         * Every pass is a superstep: tasks run until there is no work left anywhere,
+         * then handle_finish is called for tasks and reducers on every process.
+         * Next pass starts immediately if any reducer used pass_again.
+         */
+        void executor::run_bsp() {
 
-            stop_threads();
+            while(!is_finished) {
+
+                auto step_start = clock::now();
+                going_again = false;
+                set_phase(ecomputation_phase::TASKS);
+
+                wait_for_quiescence();
+                finish_all_tasks();
+                set_phase(ecomputation_phase::REDUCTION);
+                auto tasks_end = clock::now();
+
+                wait_for_quiescence();
+                finish_all_reducers();
+                set_phase(ecomputation_phase::PIPE_END);
+                auto step_end = clock::now();
+
+                // { going again, tasks time, reduction time } - maximum of each over all processes
+                uint64_t local[3] = {
+                    going_again ? 1ul : 0ul,
+                    (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(tasks_end - step_start).count(),
+                    (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(step_end - tasks_end).count()
+                };
+                uint64_t global[3];
+                _transport->all_reduce(local, global, 3, ereduce_op::MAX);
+
+                if(_exec_context.rank == 0) {
+                    std::cerr << "superstep " << current_pass 
+                        << ": tasks " << global[1]/1000.0 << " ms"
+                        << ", reduction " << global[2]/1000.0 << " ms"
+                        << ", total " << (global[1]+global[2])/1000.0 << " ms" << std::endl;
+                }
+
+                current_pass++;
+                if(!global[0]) {
+                    wait_for_quiescence(); // deliver what reducers returned
+                    set_phase(ecomputation_phase::WORK_END);
+                    is_finished = true;
+                }
+            }
+        }
+
+        /**
+         * Tasks keep emitting until termination is detected without stopping anyone,
+         * then handle_finish is called for tasks and reducers on every process.
+         * Reducers can still use pass_again to start everything again.
+         */
+        void executor::run_async() {
+
+            while(!is_finished) {
+
+                going_again = false;
+                set_phase(ecomputation_phase::TASKS);
+
+                wait_for_termination();
+                finish_all_tasks();
+                set_phase(ecomputation_phase::REDUCTION);
+
+                wait_for_quiescence();
+                finish_all_reducers();
+                set_phase(ecomputation_phase::PIPE_END);
+
+                uint64_t local = going_again ? 1 : 0;
+                uint64_t global;
+                _transport->all_reduce(&local, &global, 1, ereduce_op::MAX);
+
+                current_pass++;
+                if(!global) {
+                    wait_for_quiescence(); // deliver what reducers returned
+                    set_phase(ecomputation_phase::WORK_END);
+                    is_finished = true;
+                }
+            }
+        }
+
+        bool executor::process_queued_work() {
+
+            bool had_work = false;
+            object_pool<work_unit>::pointer work = work_pool.wrap(nullptr);
+            while(pop_work(work)) {
+                had_work = true;
+                compute_work(*work);
+                // let incoming work of lower priority overtake what is already waiting
+                if(mode == eexecution_mode::ASYNC) receive_message();
+            }
+            // everything goes out when there is nothing else to do
+            if(batching) {
+                flush_expired_input();
+                flush_batches(had_work);
+            }
+            return had_work;
+        }
+
+        bool executor::receive_message() {
+            if(!_transport->receive(incoming)) return false;
+            dispatch_message(incoming);
+            return true;
+        }
+
+        void executor::dispatch_message(envelope& mes) {
+
+            int source = mes.source;
+            int tag = mes.tag;
+            std::string& data = mes.data;
+            trace_span span(trace, "mpi", "receive");
+            span.set_arg("bytes", data.size());
+            if(mes.urgent) urgent_received[source]++;
+            // work of rank of this process comes as it is
+            if(mes.has_work) {
+                if(!traffic_prefix.empty()) traffic.record_received(source, tag, mes.work.data.size());
+                object_pool<work_unit>::pointer work = work_pool.make();
+                *work = std::move(mes.work);
+                push_work(std::move(work));
+                received_work_count++;
+            // enqueue new work
+            } else if(is_work_tag(tag)) {
+                if(!traffic_prefix.empty()) traffic.record_received(source, tag, data.size());
+                object_pool<work_unit>::pointer work = work_pool.make();
+                work->read(tag, data.data(), data.size());
+                push_work(std::move(work));
+                received_work_count++;
+            } else if(tag == batch_tag) {
+                message batch(tag, std::move(data));
+                // records are read right from the batch
+                for_each_in_batch(batch, [this, source](int tag, const char* data, std::size_t size) {
+                            if(!traffic_prefix.empty()) traffic.record_received(source, tag, size);
+                            object_pool<work_unit>::pointer work = work_pool.make();
+                            work->read(tag, data, size);
+                            push_work(std::move(work));
+                            received_work_count++;
+                        });
+            } else if(tag == credit_tag) {
+                message credit(tag, std::move(data));
+                credits.granted(source, credits_of(credit));
+                send_parked(source);
+                update_credit_stall();
+            // enqueue end messages
+            } else if(is_end_tag(tag)) {
+                message end(tag, std::move(data));
+                end_message* end_ptr = end_pool.acquire();
+                *end_ptr << end;
+                end_que.push_back(end_ptr);
+            } else { // something is fucked up
+                throw std::runtime_error("Unrecognized tag: " + std::to_string(tag));
+            }
+        }
+
+        /**
+         * Returns when all processes are out of input and work, 
+         * and every work message sent was also received
+         */
+        void executor::wait_for_quiescence() {
+
+            trace_span span(trace, "sync", "wait for quiescence");
+            while(true) {
+
+                bool active = true;
+                while(active) {
+                    // eof has to be read before the queue is drained, input may still be pushed
+                    bool input_done = input_finished();
+                    // process with parked work joins the reduction, others may wait in it with its credits
+                    active = process_queued_work() || (!input_done && !input_held());
+                    while(receive_message()) active = true;
+                }
+
+                // { sent, received, input or parked work left }
+                uint64_t local[3] = { sent_work_count, received_work_count, 
+                    (input_finished() && parked_count == 0) ? 0ul : 1ul };
+                uint64_t global[3];
+                _transport->all_reduce(local, global, 3, ereduce_op::SUM);
+                if(global[0] == global[1] && global[2] == 0) return;
+            }
+        }
+
+        /**
+         * Non blocking counterpart of wait_for_quiescence - waves of counters are reduced
+         * in the background while work is processed. Every process joins a wave when it is idle
+         * and tells if it was active since the previous one. Wave in which nobody was active
+         * and all sent work messages were received means there is nothing left to do.
+         */
+        void executor::wait_for_termination() {
+
+            trace_span span(trace, "sync", "wait for termination");
+            bool wave_pending = false;
+            bool active_since_wave = true;
+            // { sent, received, active }
+            uint64_t local[3];
+            uint64_t global[3];
+
+            while(true) {
+
+                bool input_done = input_finished();
+                bool active = process_queued_work() || !input_done || parked_count > 0;
+                while(receive_message()) active = true;
+                active_since_wave |= active;
+
+                if(!wave_pending) {
+                    if(active) continue;
+                    local[0] = sent_work_count;
+                    local[1] = received_work_count;
+                    local[2] = active_since_wave ? 1 : 0;
+                    active_since_wave = false;
+                    _transport->start_all_reduce(local, global, 3, ereduce_op::SUM);
+                    wave_pending = true;
+                } else {
+                    if(!_transport->all_reduce_done()) continue;
+                    wave_pending = false;
+                    if(global[2] == 0 && global[0] == global[1]) return;
+                }
+            }
         }
 
         void executor::compute_work(work_unit& work) {
 
+            trace_span span(trace, "work", work_unit::work_type_name(work.work_type));
+            return_credits(work);
             node_graph& graph = pipeline.get_node_graph();
+            base_node* node = nullptr;
+            base_node* from = nullptr;
             switch(work.work_type) {
                 case work_unit::ework_type::INPUT_WORK:
-                    {
-                        reset_run();
-                        // index to is not important in input work
-                        work.work_type = work_unit::ework_type::TASK_WORK;
-                        task_node* task_ptr = graph.task(pipeline.get_node_graph().root()->index());
-                        task_ptr->process_work(work, nullptr);
-                    }
+                    if(mode == eexecution_mode::RING) reset_run();
+                    // index to is not important in input work
+                    work.work_type = work_unit::ework_type::TASK_WORK;
+                    node = graph.task(graph.root()->index());
                     break;
                 case work_unit::ework_type::TASK_WORK:
-                    {
-                        task_node* task_ptr = graph.task(work.index_to);
-                        task_node* from = graph.task(work.index_from);
-                        task_ptr->process_work(work, from);
-                    }
+                    node = graph.task(work.index_to);
+                    from = graph.task(work.index_from);
                     break;
                 case work_unit::ework_type::REDUCER_COLLECT:
-                    {
-                        reducer_node* reducer_ptr = graph.reducer(work.index_to);
-                        reducer_ptr->process_work(work, nullptr);
-                    }
+                    node = graph.reducer(work.index_to);
                     break;
                 case work_unit::ework_type::REDUCER_REDUCE:
-                    {
-                        reducer_node* reducer_ptr = graph.reducer(work.index_to);
-                        task_node* from = graph.task(work.index_from);
-                        reducer_ptr->process_work(work, from);
-                    }
+                    node = graph.reducer(work.index_to);
+                    from = graph.task(work.index_from);
                     break;
                 case work_unit::ework_type::COORDINATOR_COORDINATE:
-                    {
-                        coordinator_node* coordinator_ptr = graph.coordinator(work.index_to);
-                        task_node* from = graph.task(work.index_from);
-                        coordinator_ptr->process_work(work, from);
-                    }
+                    node = graph.coordinator(work.index_to);
+                    from = graph.task(work.index_from);
                     break;
                 case work_unit::ework_type::COORDINATOR_OUTPUT:
-                    {
-                        task_node* task_ptr = graph.task(work.index_to);
-                        coordinator_node* from = graph.coordinator(work.index_from);
-                        task_ptr->process_work(work, from);
-                    }
+                    node = graph.task(work.index_to);
+                    from = graph.coordinator(work.index_from);
                     break;
                 case work_unit::ework_type::REDUCER_WORK_OUTPUT:
-                    {
-                        output_node* output_ptr = graph.output(work.index_to);
-                        reducer_node* from = graph.reducer(work.index_from);
-                        output_ptr->process_work(work, from);
-                    }
+                    node = graph.output(work.index_to);
+                    from = graph.reducer(work.index_from);
                     break;
                 case work_unit::ework_type::TASK_WORK_OUTPUT:
-                    {
-                        output_node* output_ptr = graph.output(work.index_to);
-                        task_node* from = graph.task(work.index_from);
-                        output_ptr->process_work(work, from);
-                    }
+                    node = graph.output(work.index_to);
+                    from = graph.task(work.index_from);
                     break;
+                case work_unit::ework_type::WATERMARK:
+                    process_watermark(work);
+                    return;
+            }
+            // sampled record reached output
+            if(work.origin != 0 && (work.work_type == work_unit::ework_type::REDUCER_WORK_OUTPUT 
+                        || work.work_type == work_unit::ework_type::TASK_WORK_OUTPUT))
+                latency.record(work.index_to, work.origin, work.origin_host);
+
+            node_metrics* metrics = node->metrics();
+            if(metrics == nullptr) {
+                node->process_work(work, from);
+                return;
+            }
+
+            metrics->records_in += work.chunk ? serialization::chunk_size(work.data) : 1;
+            metrics->bytes_in += work.data.size();
+            uint64_t deserialization_ns = metrics->deserialization_ns;
+            auto start = clock::now();
+            node->process_work(work, from);
+            uint64_t process_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            metrics->process_ns.record(process_ns);
+            metrics->handler_ns += process_ns - (metrics->deserialization_ns - deserialization_ns);
+        }
+
+        void executor::process_watermark(const work_unit& work) {
+            // data holds types of nodes the watermark goes from and to
+            node_id from(static_cast<enode_type>(work.data[0]), work.index_from);
+            node_id to(static_cast<enode_type>(work.data[1]), work.index_to);
+            if(watermark_progress.update(to, work.locale.rank, from, work.event_time)) advance_watermark(to);
+        }
+
+        /**
+         * Closes windows of the node and forwards its watermark, results of closed windows
+         * are sent before the watermark so they are never late downstream
+         */
+        void executor::advance_watermark(const node_id& node) {
+
+            uint64_t watermark = watermark_progress.watermark(node);
+            local_node(node)->advance_watermark(watermark);
+
+            for(auto& target: watermark_targets[node]) {
+                work_unit work;
+                work.work_type = work_unit::ework_type::WATERMARK;
+                work.data = { static_cast<char>(node.first), static_cast<char>(target.second.first) };
+                work.index_from = node.second;
+                work.index_to = target.second.second;
+                work.locale = locale_info::get_basic();
+                work.event_time = watermark;
+                // in asynchronous mode everything received before is processed first
+                work.priority = std::numeric_limits<int64_t>::max();
+                send(std::move(work), target.first);
             }
         }
 
+        base_node* executor::local_node(const node_id& node) const {
+            node_graph& graph = pipeline.get_node_graph();
+            switch(node.first) {
+                case enode_type::TASK:
+                    return graph.task(node.second);
+                case enode_type::REDUCER:
+                    return graph.reducer(node.second);
+                case enode_type::COORDINATOR:
+                    return graph.coordinator(node.second);
+                case enode_type::OUTPUT:
+                    return graph.output(node.second);
+            }
+            throw node_exception("Unknown node type");
+        }
+
         void executor::stop_threads() {
             if(input_thread) {
                 input_thread->join();
@@ -250,83 +653,583 @@ namespace dj {
             node_graph& nodes = pipeline.get_node_graph();
             auto& coordinators = nodes.get_coordinator_nodes();
 
-            uint rank = 1;
+            uint rank = 1%_exec_context.size; // there may be only one process
             for(auto& co_ptr: coordinators) { // spread them equally TODO maybe something smarter
                 coordinator_ranks[co_ptr->index()] = rank;
                 rank = (rank+1)%_exec_context.size;
             }
         }
 
-        void executor::eof_callback() {
-            encountered_eof = true;
+        /**
+         * Watermarks follow edges of the graph. Edges closing a cycle (found by depth first search from root)
+         * are not followed, so results sent along them can be late. Every process computes routes
+         * of all processes to know which edges its nodes have to wait for.
+         */
+        void executor::set_watermark_routes() {
+
+            node_graph& graph = pipeline.get_node_graph();
+            auto& reducers = graph.get_reducer_nodes();
+            auto& outputs = graph.get_output_nodes();
+
+            std::vector<node_id> nodes;
+            std::unordered_map<node_id, std::vector<node_id>> downstream;
+
+            for(auto& t: graph.get_task_nodes()) {
+                node_id from(enode_type::TASK, t->index());
+                nodes.push_back(from);
+                auto& down = downstream[from];
+                for(auto& p: t->connected_tasks()) down.emplace_back(enode_type::TASK, p.first);
+                for(auto& p: t->connected_coorindators()) {
+                    down.emplace_back(enode_type::COORDINATOR, p.first);
+                    downstream[node_id(enode_type::COORDINATOR, p.first)].push_back(from); // broadcast
+                }
+                try {
+                    down.push_back(graph.sink(enode_type::TASK, t->index()));
+                } catch(const node_exception& e) {
+                    // emit without target goes to the first of them
+                    if(!reducers.empty()) down.emplace_back(enode_type::REDUCER, reducers[0]->index());
+                    if(!outputs.empty()) down.emplace_back(enode_type::OUTPUT, outputs[0]->index());
+                }
+            }
+            for(auto& r: reducers) {
+                node_id from(enode_type::REDUCER, r->index());
+                nodes.push_back(from);
+                try {
+                    downstream[from].push_back(graph.sink(enode_type::REDUCER, r->index()));
+                } catch(const node_exception& e) {
+                    if(!outputs.empty()) downstream[from].emplace_back(enode_type::OUTPUT, outputs[0]->index());
+                }
+            }
+            for(auto& c: graph.get_coordinator_nodes()) nodes.emplace_back(enode_type::COORDINATOR, c->index());
+            for(auto& o: outputs) nodes.emplace_back(enode_type::OUTPUT, o->index());
+
+            // edges to nodes on the current path of search close cycles
+            std::unordered_map<node_id, int> state; // 1 - on path, 2 - done
+            std::set<std::pair<node_id, node_id>> back_edges;
+            std::function<void(const node_id&)> search = [&](const node_id& node) {
+                state[node] = 1;
+                for(const node_id& next: downstream[node]) {
+                    if(state[next] == 1) back_edges.emplace(node, next);
+                    else if(state[next] == 0) search(next);
+                }
+                state[node] = 2;
+            };
+            search(node_id(enode_type::TASK, graph.root()->index()));
+            for(const node_id& node: nodes) if(state[node] == 0) search(node);
+
+            auto exists = [this](const node_id& node, uint rank) {
+                return node.first != enode_type::COORDINATOR || coordinator_ranks.at(node.second) == rank;
+            };
+
+            // (rank, node) receiving watermark of node on given rank
+            auto targets = [&](const node_id& node, uint rank) {
+                std::vector<std::pair<uint, node_id>> result;
+                for(const node_id& next: downstream[node]) {
+                    if(back_edges.count(std::make_pair(node, next))) continue;
+                    switch(next.first) {
+                        case enode_type::TASK:
+                            for(uint r = 0; r < _exec_context.size; r++) result.emplace_back(r, next);
+                            break;
+                        case enode_type::COORDINATOR:
+                            result.emplace_back(coordinator_ranks.at(next.second), next);
+                            break;
+                        case enode_type::REDUCER:
+                            {
+                                auto& ranks = reducers_ranks.at(next.second);
+                                result.emplace_back((ranks.size() == 1) ? ranks[0] : rank, next);
+                            }
+                            break;
+                        case enode_type::OUTPUT:
+                            result.emplace_back(rank, next);
+                            break;
+                    }
+                }
+                // partial results are collected by the root reducer
+                if(node.first == enode_type::REDUCER && reducers_ranks.at(node.second).size() > 1 
+                        && reducers_roots.at(node.second) != rank)
+                    result.emplace_back(reducers_roots.at(node.second), node);
+                return result;
+            };
+
+            std::unordered_map<node_id, std::vector<std::pair<uint, node_id>>> inputs;
+            inputs[node_id(enode_type::TASK, graph.root()->index())].emplace_back(_exec_context.rank, input_source);
+            for(const node_id& node: nodes) {
+                for(uint rank = 0; rank < _exec_context.size; rank++) {
+                    if(!exists(node, rank)) continue;
+                    for(auto& target: targets(node, rank)) 
+                        if(target.first == _exec_context.rank) inputs[target.second].emplace_back(rank, node);
+                }
+            }
+
+            watermark_progress.clear();
+            watermark_targets.clear();
+            for(const node_id& node: nodes) {
+                if(!exists(node, _exec_context.rank)) continue;
+                watermark_progress.set_inputs(node, inputs[node]);
+                watermark_targets[node] = targets(node, _exec_context.rank);
+            }
+        }
+
+        void executor::enqueue_input_work(object_pool<work_unit>::pointer work) {
+            if(!batching) {
+                push_input(std::move(work), true);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(input_buffer_mutex);
+            if(input_buffer.empty()) {
+                input_buffer_started = clock::now();
+                input_buffer_deadline = (input_buffer_started + input_chunk.target()).time_since_epoch().count();
+            }
+            input_buffer.push_back(std::move(work));
+            if(input_buffer.size() >= input_chunk.size() 
+                    || clock::now() - input_buffer_started >= input_chunk.target())
+                flush_input_chunk(true);
+        }
+
+        /**
+         * Called with input_buffer_mutex locked
+         * @param wait for room in the queue of input, only input thread waits
+         */
+        void executor::flush_input_chunk(bool wait) {
+            if(input_buffer.empty()) return;
+            trace.instant("input", "input chunk", "records", input_buffer.size());
+            for(auto& work: input_buffer) push_input(std::move(work), wait);
+            input_chunk.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        clock::now() - input_buffer_started), input_buffer.size());
+            input_buffer.clear();
+            input_buffer_deadline = 0;
+        }
+
+        /**
+         * Chunk of a slow source goes on once it waited for the target latency, 
+         * even if no other record comes. Computing thread never waits for input thread here.
+         */
+        void executor::flush_expired_input() {
+            clock::rep deadline = input_buffer_deadline.load(std::memory_order_relaxed);
+            if(deadline == 0 || clock::now().time_since_epoch().count() < deadline) return;
+            std::unique_lock<std::mutex> lock(input_buffer_mutex, std::try_to_lock);
+            if(lock.owns_lock()) flush_input_chunk(false);
+        }
+
+        void executor::add_to_batch(const work_unit& work, int to) {
+            if(to == -1) { // to all others
+                for(uint i = 0; i < _exec_context.size; i++) {
+                    if(i != _exec_context.rank) add_to_batch(work, i);
+                }
+                return;
+            }
+            auto& batch = batches[to];
+            if(batch.empty()) batch_started[to] = clock::now();
+            std::size_t size = batch.add(work);
+            if(!traffic_prefix.empty()) traffic.record_sent(to, static_cast<int>(work.work_type), size);
+            if(batch.size() >= batch_size.size()) flush_batch(to);
         }
 
-        void executor::request_data() {
-            buffer.clear();
-            receive_request = world.irecv(mpi::any_source, mpi::any_tag, buffer); 
+        /**
+         * @param expired_only sends only batches waiting for target latency already
+         */
+        void executor::flush_batches(bool expired_only) {
+            auto now = clock::now();
+            for(uint i = 0; i < batches.size(); i++) {
+                if(batches[i].empty()) continue;
+                if(!expired_only || now - batch_started[i] >= batch_size.target()) flush_batch(i);
+            }
+        }
+
+        void executor::flush_batch(uint to) {
+            auto& batch = batches[to];
+            trace_span span(trace, "mpi", "send batch");
+            span.set_arg("records", batch.size());
+            _transport->send(to, batch_tag, batch.packed(), false);
+            sent_work_count += batch.size();
+            credits.sent(to, batch.size());
+            update_credit_stall();
+            batch_size.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        clock::now() - batch_started[to]), batch.size());
+            batch.clear();
+        }
+
+        void executor::enqueue_watermark(uint64_t watermark) {
+            object_pool<work_unit>::pointer work = work_pool.make();
+            work->work_type = work_unit::ework_type::WATERMARK;
+            work->type_name = "";
+            work->data = { static_cast<char>(input_source.first), static_cast<char>(enode_type::TASK) };
+            work->index_from = input_source.second;
+            work->index_to = pipeline.get_node_graph().root()->index();
+            work->locale = locale_info::get_basic();
+            work->event_time = watermark;
+            work->priority = std::numeric_limits<int64_t>::max();
+            work->origin = 0;
+            work->chunk = false;
+            enqueue_input_work(std::move(work)); // in order with input
+        }
+
+        bool executor::watermarks_enabled() const {
+            return watermarks;
+        }
+
+        uint64_t executor::late_records() const {
+            node_graph& graph = pipeline.get_node_graph();
+            uint64_t late = 0;
+            for(auto& n: graph.get_task_nodes()) late += n->late_records();
+            for(auto& n: graph.get_reducer_nodes()) late += n->late_records();
+            for(auto& n: graph.get_coordinator_nodes()) late += n->late_records();
+            for(auto& n: graph.get_output_nodes()) late += n->late_records();
+            return late;
+        }
+
+        const termination_times& executor::termination() const {
+            return termination_moments;
+        }
+
+        void executor::set_node_metrics() {
+
+            node_graph& graph = pipeline.get_node_graph();
+            bool enabled = !metrics_prefix.empty();
+            metrics.clear();
+            for(auto& n: graph.get_task_nodes()) 
+                n->set_metrics(enabled ? metrics.add("task", n->name(), n->index()) : nullptr);
+            for(auto& n: graph.get_reducer_nodes()) 
+                n->set_metrics(enabled ? metrics.add("reducer", n->name(), n->index()) : nullptr);
+            for(auto& n: graph.get_coordinator_nodes()) 
+                n->set_metrics(enabled ? metrics.add("coordinator", n->name(), n->index()) : nullptr);
+            for(auto& n: graph.get_output_nodes()) 
+                n->set_metrics(enabled ? metrics.add("output", n->name(), n->index()) : nullptr);
+        }
+
+        void executor::record_output(const work_unit& work) {
+
+            node_graph& graph = pipeline.get_node_graph();
+            base_node* from = nullptr;
+            switch(work.work_type) {
+                case work_unit::ework_type::TASK_WORK:
+                case work_unit::ework_type::REDUCER_REDUCE:
+                case work_unit::ework_type::COORDINATOR_COORDINATE:
+                case work_unit::ework_type::TASK_WORK_OUTPUT:
+                    from = graph.task(work.index_from);
+                    break;
+                case work_unit::ework_type::INPUT_WORK:
+                case work_unit::ework_type::REDUCER_COLLECT:
+                case work_unit::ework_type::REDUCER_WORK_OUTPUT:
+                    from = graph.reducer(work.index_from);
+                    break;
+                case work_unit::ework_type::COORDINATOR_OUTPUT:
+                    from = graph.coordinator(work.index_from);
+                    break;
+                case work_unit::ework_type::WATERMARK:
+                    return;
+            }
+            node_metrics* metrics = from->metrics();
+            metrics->records_out++;
+            metrics->bytes_out += work.data.size();
+        }
+
+        /**
+         * Every process writes its trace, the first one also trace with tracks of all of them
+         */
+        void executor::dump_trace() {
+
+            std::string events = trace.events_json(_exec_context.rank);
+            std::ofstream(trace_prefix + "." + std::to_string(_exec_context.rank) + ".json") 
+                << tracer::trace_json({ events });
+
+            std::vector<std::string> all = _transport->gather(events);
+            if(_exec_context.rank == 0) std::ofstream(trace_prefix + ".json") << tracer::trace_json(all);
         }
 
-        void executor::send(work_unit& work, int to) {
+        /**
+         * Every process writes its own report, the first one also report merged from all of them
+         * @param to_json called with rank of process, -1 for merged report
+         */
+        template <typename Report, typename ToJson>
+        void executor::dump_report(const std::string& prefix, const Report& local, Report merged, ToJson to_json) {
+            using serialization::operator<<;
+            using serialization::operator>>;
 
+            std::ofstream(prefix + "." + std::to_string(_exec_context.rank) + ".json") 
+                << to_json(local, _exec_context.rank);
+
+            std::string data;
+            data << local;
+            std::vector<std::string> all = _transport->gather(data);
+            if(_exec_context.rank != 0) return;
+
+            for(const std::string& d: all) {
+                Report other;
+                d >> other;
+                merged.merge(other);
+            }
+            std::ofstream(prefix + ".json") << to_json(merged, -1);
+        }
+
+        void executor::record_phase_time() {
+            auto now = clock::now();
+            metrics.add_phase_time(static_cast<uint>(phase), 
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - phase_started).count());
+            phase_started = now;
+        }
+
+        void executor::set_phase(ecomputation_phase new_phase) {
+            if(new_phase == phase) return;
+            trace.instant("phase", phase_names[static_cast<int>(new_phase)]);
+            if(!metrics_prefix.empty()) record_phase_time();
+            // pass ends on every process when reducers are finished
+            if(new_phase == ecomputation_phase::PIPE_END && !traffic_prefix.empty()) traffic.end_pass();
+            if(new_phase == ecomputation_phase::WORK_END) termination_moments.finished = clock::now();
+            phase = new_phase;
+        }
+
+        void executor::eof_callback() {
+            // nothing more will come from this process
+            if(watermarks) enqueue_watermark(max_watermark);
+            if(batching) {
+                std::lock_guard<std::mutex> lock(input_buffer_mutex);
+                flush_input_chunk(true);
+            }
+            termination_moments.eof = clock::now();
+            encountered_eof = true;
+        }
+
+        void executor::send(work_unit&& work, int to) {
+
+            if(!metrics_prefix.empty()) record_output(work);
             // going for recursion
             if(work.work_type == work_unit::ework_type::INPUT_WORK) {
                 going_again = true;
             }
+            deliver(std::move(work), to);
+        }
+
+        /**
+         * Work is moved to the queue of this process or serialized for others
+         */
+        void executor::deliver(work_unit&& work, int to) {
+
             work.phase = phase;
             if(to != (int) _exec_context.rank) {
+                // work of coordinators goes out at once and is received before other work
+                bool urgent = lane_of(work) == ework_lane::COORDINATOR;
+                // work for a process out of credits waits for them behind work parked before it
+                if(!urgent && to != -1 && (credits.exhausted(to) || !parked[to].empty())) {
+                    park(std::move(work), to);
+                    return;
+                }
+                transmit(work, to, urgent);
+                if(to == -1) { // sent to all other, process work myself
+                    object_pool<work_unit>::pointer local = work_pool.make();
+                    *local = std::move(work);
+                    push_work(std::move(local));
+                }
+            } else {
+                object_pool<work_unit>::pointer local = work_pool.make();
+                *local = std::move(work);
+                push_work(std::move(local));
+            }
+        }
+
+        void executor::transmit(work_unit& work, int to, bool urgent) {
+            int tag = static_cast<int>(work.work_type);
+            std::size_t size = work.data.size();
+            if(batching && !urgent) {
+                add_to_batch(work, to);
+            } else if(to != -1 && _transport->pass(to, work, urgent)) {
+                // rank of this process takes work as it is
+                if(urgent) urgent_sent[to]++;
+                count_sent(to, tag, size);
+                update_credit_stall();
+            } else {
                 message mes; 
                 mes << work;
-                if(to == -1) // send to all other and process work myself
-                    qd_work.push(new work_unit(work));
+                send(mes, to, urgent);
+            }
+        }
 
-                send(mes, to); // TODO async in current implemenation generates truncate errors in mpi
-            } else {
-                qd_work.push(new work_unit(work));
+        void executor::park(work_unit&& work, uint to) {
+            if(parked[to].empty()) trace.instant("flow", "work parked", "to", to);
+            object_pool<work_unit>::pointer waiting = work_pool.make();
+            *waiting = std::move(work);
+            parked[to].push_back(std::move(waiting));
+            parked_count++;
+        }
+
+        /**
+         * Parked work goes out in order as long as credits last
+         */
+        void executor::send_parked(uint to) {
+            auto& waiting = parked[to];
+            while(!waiting.empty() && !credits.exhausted(to)) {
+                transmit(*waiting.front(), to, false);
+                waiting.pop_front();
+                parked_count--;
             }
         }
 
-        void executor::async_send(const message& mes, int to) {
+        /**
+         * Scattered input is not a new pass, unlike input work sent by reducers
+         */
+        void executor::forward_input(work_unit& work) {
+            uint to = work.index_to;
+            trace.instant("input", "forward input", "to", to);
+            deliver(std::move(work), to);
+        }
 
-            if(to == -1) { // send to all others
-                for(uint i = 0; i < _exec_context.size; i++) {
-                    if(i == _exec_context.rank) continue;
-                    world.isend(i, mes.tag, mes.data);
+        void executor::push_work(object_pool<work_unit>::pointer work) {
+            lanes.push(work.release());
+        }
+
+        /**
+         * Input is let in one record at a time, when no other input waits in its lane.
+         * Input of other processes is sent to them as it comes.
+         */
+        bool executor::pop_work(object_pool<work_unit>::pointer& work) {
+            while(lanes.empty(ework_lane::INPUT) && pop_input(work)) {
+                if(work->work_type == work_unit::ework_type::INPUT_WORK && work->index_to != _exec_context.rank) {
+                    forward_input(*work);
+                    continue;
                 }
-            } else if(to != (int)_exec_context.rank) {
-                world.isend(to, mes.tag, mes.data);
-            } else
-                throw std::runtime_error("Cannot send message to myself");
+                lanes.push(work.release());
+            }
+            work_unit* work_ptr = lanes.pop();
+            if(work_ptr == nullptr) return false;
+            work.reset(work_ptr);
+            return true;
+        }
+
+        /**
+         * Called by input thread, waits while the queue of input is full if wait is set
+         */
+        void executor::push_input(object_pool<work_unit>::pointer work, bool wait) {
+            if(wait && _inbound_capacity > 0 && queued_input >= _inbound_capacity) {
+                trace_span span(trace, "input", "wait for room");
+                auto start = clock::now();
+                std::unique_lock<std::mutex> lock(input_room_mutex);
+                input_waiting = true;
+                input_room.wait(lock, [this]() { return queued_input < _inbound_capacity; });
+                input_waiting = false;
+                lock.unlock();
+                input_stall_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            }
+            queued_input++;
+            qd_input.push(work.release());
+        }
+
+        bool executor::pop_input(object_pool<work_unit>::pointer& work) {
+            if(input_held()) return false;
+            work_unit* work_ptr;
+            if(!qd_input.pop(work_ptr)) return false;
+            queued_input--;
+            // input thread either sees the room or is already waiting when it is notified
+            if(input_waiting) {
+                std::lock_guard<std::mutex> lock(input_room_mutex);
+                input_room.notify_one();
+            }
+            work.reset(work_ptr);
+            return true;
+        }
+
+        /**
+         * @return true if input ended and all of it was taken
+         */
+        bool executor::input_finished() const {
+            return encountered_eof && queued_input == 0;
+        }
+
+        /**
+         * Input waits while a window of work is parked, other input goes on while some destinations
+         * are out of credits
+         */
+        bool executor::input_held() const {
+            return credits.window() > 0 && parked_count >= credits.window();
+        }
+
+        /**
+         * Work of other process is created there, so its locale tells where credits go
+         */
+        void executor::return_credits(const work_unit& work) {
+            if(work.locale.rank == _exec_context.rank) return;
+            if(uint64_t records = credits.processed(work.locale.rank)) 
+                send(credit_message(records), work.locale.rank, true);
+        }
+
+        void executor::update_credit_stall() {
+            bool stalled = credits.exhausted();
+            if(stalled == (credit_stall_started != clock::time_point())) return;
+            if(stalled) {
+                trace.instant("flow", "out of credits");
+                credit_stall_started = clock::now();
+            } else {
+                trace.instant("flow", "credits returned");
+                if(!metrics_prefix.empty()) metrics.add_credit_stall(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            clock::now() - credit_stall_started).count());
+                credit_stall_started = clock::time_point();
+            }
+        }
+
+        /**
+         * Sends of transport never wait for the receiver
+         */
+        void executor::async_send(const message& mes, int to) {
+            send(mes, to, false);
         }
 
         void executor::send(const message& mes, int to) {
+            send(mes, to, false);
+        }
+
+        void executor::send(const message& mes, int to, bool urgent) {
 
+            trace_span span(trace, "mpi", "send");
+            span.set_arg("bytes", mes.data.size());
             if(to == -1) { // send to all others
                 for(uint i = 0; i < _exec_context.size; i++) {
                     if(i == _exec_context.rank) continue;
-                    world.send(i, mes.tag, mes.data);
+                    _transport->send(i, mes.tag, mes.data, urgent);
+                    if(urgent) urgent_sent[i]++;
+                    if(is_work_tag(mes.tag)) count_sent(i, mes.tag, mes.data.size());
                 }
+                update_credit_stall();
             } else if(to != (int)_exec_context.rank) {
-                world.send(to, mes.tag, mes.data);
+                _transport->send(to, mes.tag, mes.data, urgent);
+                if(urgent) urgent_sent[to]++;
+                if(is_work_tag(mes.tag)) {
+                    count_sent(to, mes.tag, mes.data.size());
+                    update_credit_stall();
+                }
             } else
                 throw std::runtime_error("Cannot send message to myself");
         }
 
+        void executor::count_sent(uint to, int tag, std::size_t size) {
+            sent_work_count++;
+            credits.sent(to, 1);
+            if(!traffic_prefix.empty()) traffic.record_sent(to, tag, size);
+        }
+
         void executor::tell_about_the_end(// sounds so sad...
                 end_message::eend_message_type end_type, uint counter, uint from_rank, uint pass_number)
         {
-            end_message end_mes { from_rank, pass_number, counter, end_type }; 
+            // work produced so far goes before the end message
+            if(batching) flush_batches(false);
+
+            uint next = (_exec_context.rank+1)%_exec_context.size;
+            end_message end_mes { from_rank, pass_number, counter, end_type, urgent_sent[next] }; 
+            trace.instant("ring", end_name(end_type), "counter", counter);
             message mes;
             mes << end_mes;
 
-            if(_exec_context.size == 1) 
-                end_que.push_back(new end_message(end_mes));
-            else 
-                send(mes, (_exec_context.rank+1)%_exec_context.size);
+            if(_exec_context.size == 1) {
+                end_message* end_ptr = end_pool.acquire();
+                *end_ptr = end_mes;
+                end_que.push_back(end_ptr);
+            } else 
+                send(mes, next);
         }
 
         // TODO queue end_messages and change circle of death test
         void executor::process_end_message(end_message& mes, bool had_work) {
 
+            trace_span span(trace, "ring", end_name(mes.end_type));
+            span.set_arg("counter", mes.counter);
             switch(mes.end_type) {
                 case end_message::eend_message_type::TASK_END:
                     process_task_end_message(mes, had_work);
@@ -355,7 +1258,7 @@ namespace dj {
                 } else if(mes.counter == 2*_exec_context.size) {
                     // now we can finish all tasks - everyone is done with them
                     finish_all_tasks();
-                    phase = ecomputation_phase::REDUCTION;
+                    set_phase(ecomputation_phase::REDUCTION);
                 } else {
                     if(mes.pass_number == 1 && mes.counter == _exec_context.size) 
                         tell_about_the_end(
@@ -367,17 +1270,17 @@ namespace dj {
                 bool tell_at_the_end = false;;
                 uint counter;
                 if(mes.pass_number == 1) {
-                    if(!had_work && encountered_eof) counter = mes.counter+1;
+                    if(!had_work && input_finished()) counter = mes.counter+1;
                     else counter = mes.counter;
                     tell_at_the_end = true;
                 } else {
-                    if(!had_work && encountered_eof) {
+                    if(!had_work && input_finished()) {
                         counter = mes.counter+1;
                         tell_about_the_end(
                                 end_message::eend_message_type::TASK_END, counter, mes.from_rank, mes.pass_number);
                         if(mes.counter == _exec_context.size + abs(_exec_context.rank-mes.from_rank)) {
                             finish_all_tasks();
-                            phase = ecomputation_phase::REDUCTION;
+                            set_phase(ecomputation_phase::REDUCTION);
                         }
                     } else {
                         counter = mes.counter;
@@ -404,7 +1307,7 @@ namespace dj {
                 } else if(mes.counter == 2*_exec_context.size) {
                     // now we can finish all tasks - everyone is done with them
                     finish_all_reducers();
-                    phase = ecomputation_phase::PIPE_END;
+                    set_phase(ecomputation_phase::PIPE_END);
                 } else {
                     if(mes.pass_number == 1 && mes.counter == _exec_context.size) 
                         tell_about_the_end(
@@ -426,7 +1329,7 @@ namespace dj {
                                 end_message::eend_message_type::REDUCTION_END, counter, mes.from_rank, mes.pass_number);
                         if(mes.counter == _exec_context.size + abs(_exec_context.rank-mes.from_rank)) {
                             finish_all_reducers();
-                            phase = ecomputation_phase::PIPE_END;
+                            set_phase(ecomputation_phase::PIPE_END);
                         }
                     } else {
                         tell_at_the_end = true;
@@ -453,7 +1356,7 @@ namespace dj {
                     sent_work_end = false;
                 } else if(mes.counter == 2*_exec_context.size) {
                     is_finished = true;
-                    phase = ecomputation_phase::WORK_END;
+                    set_phase(ecomputation_phase::WORK_END);
                 } else {
                     if(mes.pass_number == 1 && mes.counter == _exec_context.size) 
                         tell_about_the_end(
@@ -470,7 +1373,7 @@ namespace dj {
                     if(!had_work) {
                         if(mes.counter == _exec_context.size + abs(_exec_context.rank-mes.from_rank)) {
                             is_finished = true;
-                            phase = ecomputation_phase::WORK_END;
+                            set_phase(ecomputation_phase::WORK_END);
                         }
                         counter = mes.counter+1;
                     } else counter = mes.counter;
@@ -578,23 +1481,60 @@ namespace dj {
             return it->second;
         }
 
+        /**
+         * Combines values of all aggregators with one all_reduce, collective - only in BSP and ASYNC modes,
+         * where every process finishes tasks of every pass
+         */
+        void executor::combine_aggregators() {
+
+            aggregator_registry& aggregators = pipeline.get_aggregators();
+            if(aggregators.empty()) return;
+
+            using serialization::operator<<;
+            using serialization::operator>>;
+
+            // values of all processes are combined in order of ranks
+            std::string data;
+            data << aggregators.local_values();
+            data = _transport->all_reduce(data, [&aggregators](const std::string& data1, const std::string& data2) {
+                        std::vector<std::string> values1, values2;
+                        data1 >> values1;
+                        data2 >> values2;
+                        std::string combined;
+                        combined << aggregators.combine(values1, values2);
+                        return combined;
+                    });
+            std::vector<std::string> global;
+            data >> global;
+            aggregators.set_global(global);
+        }
+
         void executor::finish_all_tasks() {
 
+            trace_span span(trace, "finish", "finish tasks");
+            // in BSP and ASYNC modes every process gets here at the end of tasks phase,
+            // aggregators are refused in RING mode
+            combine_aggregators();
+
             auto& tasks = pipeline.get_node_graph().get_task_nodes();
             for(auto& t: tasks) t->handle_finish();
+            termination_moments.tasks_finished.push_back(clock::now());
         }
 
         void executor::finish_all_reducers() {
+
+            trace_span span(trace, "finish", "finish reducers");
             // TODO only finishing root reducer now
             auto& reducers = pipeline.get_node_graph().get_reducer_nodes();
             for(auto& r: reducers) r->handle_finish();
+            termination_moments.reducers_finished.push_back(clock::now());
         }
 
         void executor::reset_run() {
             if(phase == ecomputation_phase::REDUCTION) {
                 finish_all_reducers(); // not elegan way to recurance TODO sth better
             }
-            phase = ecomputation_phase::TASKS;
+            set_phase(ecomputation_phase::TASKS);
             sent_task_end = false;
             sent_reduction_end = false;
             sent_work_end = false;
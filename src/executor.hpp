@@ -6,19 +6,47 @@
 #include <boost/lockfree/queue.hpp>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 #include <deque>
+#include <chrono>
 #include "message.hpp"
+#include "watermark.hpp"
+#include "batching.hpp"
+#include "flow_control.hpp"
+#include "lanes.hpp"
+#include "transport.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "pool.hpp"
 
 namespace mpi = boost::mpi;
 
 namespace dj {
 
     class execution_pipeline;
+    class aggregator_registry;
     enum class enode_type;
 
     namespace exec {
 
+        enum class eexecution_mode {
+            RING,   // phases are switched by end messages travelling around the ring of processes
+            BSP,    // every pass is a superstep closed with a global reduction of message counters
+            ASYNC   // no global passes, work is processed by priority until nothing is left anywhere
+        };
+
+        /**
+         * Moments termination of every pass was reached on this process
+         */
+        struct termination_times {
+            std::chrono::steady_clock::time_point eof; // input of this process ended
+            std::vector<std::chrono::steady_clock::time_point> tasks_finished; // handle_finish of tasks
+            std::vector<std::chrono::steady_clock::time_point> reducers_finished; // handle_finish of reducers
+            std::chrono::steady_clock::time_point finished; // WORK_END
+        };
+
         /**
          * Class responsible for executoion of pipelined tasks
          * and dispatching messages
@@ -32,17 +60,179 @@ namespace dj {
                  * @param pipeline this executor call pipeline's provide_executor with this
                  */
                 executor(int argc, char* argv[], execution_pipeline& pipeline);
+                /**
+                 * Runs as a rank of given transport, e.g. of thread_group
+                 */
+                executor(std::unique_ptr<transport> ranks, execution_pipeline& pipeline);
 
                 void start();
                 context_info context() const;
 
+                /**
+                 * Has to be set before start, RING is the default one. Pipeline with aggregators
+                 * needs BSP or ASYNC.
+                 */
+                void set_execution_mode(eexecution_mode mode);
+                eexecution_mode execution_mode() const;
+
+                /**
+                 * Turns on micro-batching - work for other processes and input are sent in batches,
+                 * sizes of which are adapted so that no record waits in a batch longer than target.
+                 * Zero (default) sends every record on its own. Has to be set before start.
+                 */
+                void set_target_latency(std::chrono::microseconds target);
+
+                /**
+                 * Bounds records waiting in this process - input thread blocks while capacity records
+                 * of input are queued and every other process keeps its own input while capacity/(processes-1)
+                 * records it sent here were not processed yet. Zero turns flow control off, 4096 is the default.
+                 * DJ_INBOUND_CAPACITY environment variable sets it as well. Has to be set before start.
+                 */
+                void set_inbound_capacity(uint records);
+                uint inbound_capacity() const;
+
+                /**
+                 * Work waits in lanes - coordinator, reducer, task and input, served in this order.
+                 * Lane with weight w gives way to the lower ones after w works, lane of weight 0 (default)
+                 * is served until it is empty. Credits and work of coordinators are also sent
+                 * on their own communicator, which is received before others.
+                 */
+                void set_lane_weights(std::vector<uint> weights);
+
+                /**
+                 * Processes on the same host send messages through rings of ring_size bytes in shared memory,
+                 * MPI carries them only while a ring is full. On by default, DJ_SHM=0 environment variable
+                 * turns it off and DJ_SHM_RING sets the size. Has to be set before start.
+                 */
+                void set_shared_memory(bool enabled, std::size_t ring_size = 1 << 18);
+
+                /**
+                 * Moves all MPI calls to a thread of their own, so that messages are received and sent
+                 * while nodes compute. Computing thread only hands messages over through lock-free queues.
+                 * Off by default as the thread takes a core, DJ_PROGRESS_THREAD=1 environment variable
+                 * turns it on as well. Has to be set before start.
+                 */
+                void set_progress_thread(bool enabled);
+
+                /**
+                 * @return transport messages of this rank go through
+                 */
+                transport& get_transport();
+
+                /**
+                 * Turns on per node metrics, at the end every process writes them as JSON
+                 * to <prefix>.<rank>.json and the first one merges all of them into <prefix>.json.
+                 * DJ_METRICS environment variable sets the prefix as well.
+                 */
+                void set_metrics_output(std::string prefix);
+
+                /**
+                 * Turns on tracing of work, messages, termination ring and phases. At the end every process
+                 * writes Chrome trace to <prefix>.<rank>.json and the first one merges them into <prefix>.json.
+                 * DJ_TRACE environment variable sets the prefix as well.
+                 */
+                void set_trace_output(std::string prefix);
+
+                /**
+                 * Turns on counting of work messages and bytes between processes per work type and pass.
+                 * At the end every process writes its counters to <prefix>.<rank>.json and the first one
+                 * writes matrices of all of them to <prefix>.json. DJ_TRAFFIC environment variable sets the prefix as well.
+                 */
+                void set_traffic_output(std::string prefix);
+
+                /**
+                 * Turns on sampling of end-to-end latency - one of every n input records carries time
+                 * it was read through all emits and time to reach output nodes is recorded. At the end
+                 * every process writes latencies of its outputs to <prefix>.<rank>.json and the first one
+                 * merged latencies to <prefix>.json. Set also by DJ_LATENCY (prefix) and DJ_LATENCY_EVERY.
+                 * Latency of records crossing machines includes the offset of their monotonic clocks.
+                 */
+                void set_latency_sampling(uint every, std::string prefix);
+
+                /**
+                 * @param event_time used by windowed nodes, time of ingestion if not given
+                 */
+                template<typename T>
+                    void enqueue_input(const T& input, uint64_t event_time) {
+                        object_pool<work_unit>::pointer work = work_pool.make();
+                        *work = work_unit::get_basic(input, work_unit::ework_type::INPUT_WORK, _exec_context.rank, 0);
+                        work->event_time = event_time;
+                        work->origin = latency.sample();
+                        work->origin_host = latency.host();
+                        enqueue_input_work(std::move(work));
+                    }
+
                 template<typename T>
                     void enqueue_input(const T& input) {
-                        qd_work.push(new work_unit(
-                                    work_unit::get_basic(input, work_unit::ework_type::INPUT_WORK, 0, 0)));
+                        enqueue_input(input, context_info::get_current_timestamp());
                     }
 
-                void send(work_unit& work, int to);
+                /**
+                 * Records are serialized into a single chunk of work, taken by root task at once
+                 */
+                template<typename T>
+                    void enqueue_inputs(span<const T> inputs, uint64_t event_time) {
+                        enqueue_inputs_to(_exec_context.rank, inputs, event_time);
+                    }
+
+                template<typename T>
+                    void enqueue_inputs(span<const T> inputs) {
+                        enqueue_inputs(inputs, context_info::get_current_timestamp());
+                    }
+
+                /**
+                 * Chunk goes to root task of given process, it is sent there in order with other input
+                 * once computing thread takes it
+                 */
+                template<typename T>
+                    void enqueue_inputs_to(uint rank, span<const T> inputs, uint64_t event_time) {
+                        if(inputs.empty()) return;
+                        if(rank >= _exec_context.size) 
+                            throw std::runtime_error("Input for process " + std::to_string(rank) + " which does not exist");
+                        object_pool<work_unit>::pointer work = work_pool.make();
+                        // index to of input work is the process taking it
+                        *work = work_unit::get_chunk(inputs.data(), inputs.size(), 
+                                work_unit::ework_type::INPUT_WORK, rank, 0);
+                        work->event_time = event_time;
+                        work->origin = latency.sample();
+                        work->origin_host = latency.host();
+                        enqueue_input_work(std::move(work));
+                    }
+
+                /**
+                 * Chunk of records already serialized by serialization::write_chunk, e.g. a block of record file
+                 */
+                template<typename T>
+                    void enqueue_chunk(const char* chunk, std::size_t size, uint64_t event_time) {
+                        object_pool<work_unit>::pointer work = work_pool.make();
+                        *work = work_unit::get_written_chunk<T>(chunk, size, 
+                                work_unit::ework_type::INPUT_WORK, _exec_context.rank, 0);
+                        work->event_time = event_time;
+                        work->origin = latency.sample();
+                        work->origin_host = latency.host();
+                        enqueue_input_work(std::move(work));
+                    }
+
+                /**
+                 * Watermark of input of this process, see input_provider::set_watermarks
+                 */
+                void enqueue_watermark(uint64_t watermark);
+                bool watermarks_enabled() const;
+                /**
+                 * @return records dropped by nodes of this process because their windows were closed
+                 */
+                uint64_t late_records() const;
+
+                /**
+                 * @return moments of termination of the last start, clocks of processes
+                 * are comparable only on a single machine
+                 */
+                const termination_times& termination() const;
+
+                /**
+                 * Work is moved to the queue of this process or serialized for others
+                 */
+                void send(work_unit&& work, int to);
                 void async_send(const message& mes, int to);
                 void send(const message& mes, int to);
 
@@ -58,13 +248,53 @@ namespace dj {
                 uint get_root_reducer_rank(uint reducer_index);
 
                 execution_pipeline& get_pipeline();
+                aggregator_registry& get_aggregators();
 
             private:
                 void set_reducers();
                 void set_coordinators();
+                void set_watermark_routes();
+                void enqueue_input_work(object_pool<work_unit>::pointer work);
+                void forward_input(work_unit& work);
+                void push_work(object_pool<work_unit>::pointer work);
+                bool pop_work(object_pool<work_unit>::pointer& work);
+                void push_input(object_pool<work_unit>::pointer work, bool wait);
+                bool pop_input(object_pool<work_unit>::pointer& work);
+                bool input_finished() const;
+                bool input_held() const;
+                void return_credits(const work_unit& work);
+                void update_credit_stall();
+                void flush_input_chunk(bool wait);
+                void flush_expired_input();
+                void add_to_batch(const work_unit& work, int to);
+                void flush_batches(bool expired_only);
+                void flush_batch(uint to);
+                void set_node_metrics();
+                void record_output(const work_unit& work);
+                void record_phase_time();
+                void dump_trace();
+                template <typename Report, typename ToJson>
+                    void dump_report(const std::string& prefix, const Report& local, Report merged, ToJson to_json);
+                void set_phase(ecomputation_phase new_phase);
                 void stop_threads();
-                void request_data();
+                void dispatch_message(envelope& mes);
+                void deliver(work_unit&& work, int to);
+                void transmit(work_unit& work, int to, bool urgent);
+                void park(work_unit&& work, uint to);
+                void send_parked(uint to);
+                void send(const message& mes, int to, bool urgent);
+                void count_sent(uint to, int tag, std::size_t size);
+                void run_ring();
+                void run_bsp();
+                void run_async();
+                bool process_queued_work();
+                bool receive_message();
+                void wait_for_quiescence();
+                void wait_for_termination();
                 void compute_work(work_unit& work);
+                void process_watermark(const work_unit& work);
+                void advance_watermark(const node_id& node);
+                base_node* local_node(const node_id& node) const;
                 void eof_callback();
                 void tell_about_the_end(// sounds so sad...
                         end_message::eend_message_type end_type, uint counter, uint from_rank, uint pass_number); 
@@ -74,27 +304,85 @@ namespace dj {
                 void process_reduction_end_message(end_message& mes, bool had_work);
                 void process_work_end_message(end_message& mes, bool had_work);
 
+                void combine_aggregators();
                 void finish_all_tasks();
                 void finish_all_reducers();
                 void reset_run();
 
             private:
 
-                ecomputation_phase phase;
-                mpi::environment env;
-                mpi::communicator world;
+                typedef std::chrono::steady_clock clock;
+
+                eexecution_mode mode = eexecution_mode::RING;
+                ecomputation_phase phase = ecomputation_phase::WORK_END;
+                // credits and work of coordinators are urgent, received before work of others
+                std::unique_ptr<transport> _transport;
+                envelope incoming;
 
-                // nonblocking queue with work to be processed
-                boost::lockfree::queue<work_unit*> qd_work;
+                // work units and end messages are recycled, so that their buffers are allocated once
+                object_pool<work_unit> work_pool;
+                object_pool<end_message> end_pool;
+                // work to be processed, in asynchronous mode ordered by priority in each lane
+                work_lanes lanes;
+                // input waits in its own bounded queue and is taken only while little work is parked,
+                // work of other processes is always processed
+                boost::lockfree::queue<work_unit*> qd_input;
+                std::atomic<uint> queued_input{ 0 };
+                uint _inbound_capacity = 4096;
+                // input thread sleeps here while the queue of input is full
+                std::mutex input_room_mutex;
+                std::condition_variable input_room;
+                std::atomic<bool> input_waiting{ false };
+                credit_window credits;
+                clock::time_point credit_stall_started; // zero if not out of credits
+                // work for a process out of credits waits here in order until they come back
+                std::vector<std::deque<object_pool<work_unit>::pointer>> parked; // for each process
+                uint64_t parked_count = 0;
+                std::atomic<uint64_t> input_stall_ns{ 0 }; // written by input thread
                 uint finished;
                 uint current_pass;
 
                 std::deque<end_message*> end_que;
                 std::deque<end_message*> wait_end_que;
-                // mpi request
-                boost::mpi::request receive_request;
-                // buffer
-                std::string buffer; 
+                // work messages exchanged with other processes, used to detect end of superstep
+                uint64_t sent_work_count;
+                uint64_t received_work_count;
+                // urgent messages sent to and received from every process, they may overtake end messages
+                std::vector<uint64_t> urgent_sent;
+                std::vector<uint64_t> urgent_received;
+
+                // micro-batching, batches are written only by computing thread and chunks by input thread,
+                // chunk waiting for its target latency is flushed by computing thread
+                bool batching = false;
+                adaptive_batch batch_size;
+                adaptive_batch input_chunk;
+                std::vector<batch_buffer> batches; // for each process
+                std::vector<clock::time_point> batch_started;
+                std::mutex input_buffer_mutex;
+                std::vector<object_pool<work_unit>::pointer> input_buffer;
+                clock::time_point input_buffer_started;
+                std::atomic<clock::rep> input_buffer_deadline{ 0 }; // 0 if nothing is buffered
+
+                std::string metrics_prefix;
+                metrics_registry metrics;
+                clock::time_point phase_started;
+
+                std::string trace_prefix;
+                tracer trace;
+
+                std::string traffic_prefix;
+                traffic_matrix traffic;
+
+                std::string latency_prefix;
+                uint latency_every = 1024;
+                latency_sampler latency;
+
+                termination_times termination_moments;
+
+                // watermarks of local nodes and (rank, node) they are forwarded to
+                bool watermarks = false;
+                watermark_tracker watermark_progress;
+                std::unordered_map<node_id, std::vector<std::pair<uint, node_id>>> watermark_targets;
 
                 // input thread
                 std::unique_ptr<std::thread> input_thread;
@@ -0,0 +1,74 @@
+#include "file_input.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dj {
+
+    mapped_file::mapped_file(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0) throw std::runtime_error("Cannot open " + filename + ": " + std::strerror(errno));
+        struct stat info;
+        if(fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + filename + ": " + std::strerror(errno));
+        }
+        _size = info.st_size;
+        if(_size > 0) {
+            void* at = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(at == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + filename + ": " + std::strerror(errno));
+            }
+            // read once from the beginning to the end
+            madvise(at, _size, MADV_SEQUENTIAL);
+            _data = static_cast<char*>(at);
+        }
+        ::close(fd);
+    }
+
+    mapped_file::~mapped_file() {
+        if(_data) munmap(_data, _size);
+    }
+
+    const char* mapped_file::data() const {
+        return _data;
+    }
+
+    std::size_t mapped_file::size() const {
+        return _size;
+    }
+
+    namespace {
+        /**
+         * @return beginning of the first line starting at or after at
+         */
+        std::size_t line_start(const char* data, std::size_t size, std::size_t at) {
+            if(at == 0 || at >= size) return std::min(at, size);
+            const void* newline = std::memchr(data + at - 1, '\n', size - at + 1);
+            return newline ? static_cast<const char*>(newline) - data + 1 : size;
+        }
+    }
+
+    byte_range line_range(const char* data, std::size_t size, uint part, uint parts) {
+        uint64_t begin = static_cast<uint64_t>(size)*part/parts;
+        uint64_t end = static_cast<uint64_t>(size)*(part + 1)/parts;
+        return { line_start(data, size, begin), line_start(data, size, end) };
+    }
+
+    text_scanner::text_scanner(const char* begin, const char* end)
+        : pos(begin), end(end)
+    { }
+
+    const char* text_scanner::position() const {
+        return pos;
+    }
+
+    void text_scanner::fail() const {
+        throw std::runtime_error("Expected integer at '" + std::string(pos, std::min<std::size_t>(end - pos, 16)) + "'");
+    }
+}
@@ -0,0 +1,342 @@
+#ifndef FILE_INPUT_HPP
+#define FILE_INPUT_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include "pipeline.hpp"
+
+namespace dj {
+
+    /**
+     * File mapped read-only into memory, empty file is not mapped
+     */
+    class mapped_file {
+
+        public:
+            /**
+             * @throws runtime_error if file cannot be opened or mapped
+             */
+            explicit mapped_file(const std::string& filename);
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+            ~mapped_file();
+
+            const char* data() const;
+            std::size_t size() const;
+
+        private:
+            char* _data = nullptr;
+            std::size_t _size = 0;
+    };
+
+    struct byte_range {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    /**
+     * Part of text split into parts of about the same size, every line belongs to the part
+     * its first byte falls into. Parts together cover the whole text.
+     */
+    byte_range line_range(const char* data, std::size_t size, uint part, uint parts);
+
+    /**
+     * Reads whitespace separated integers from text
+     */
+    class text_scanner {
+
+        public:
+            text_scanner(const char* begin, const char* end);
+
+            /**
+             * @return false at the end of text
+             * @throws runtime_error if anything but an integer comes
+             */
+            template <typename T>
+                bool next(T& value) {
+                    static_assert(std::is_integral<T>::value, "text_scanner reads only integers");
+                    if(!skip_whitespace()) return false;
+                    bool negative = (*pos == '-');
+                    if(negative || *pos == '+') pos++;
+                    if(pos == end || static_cast<unsigned>(*pos - '0') > 9) fail();
+                    typename std::make_unsigned<T>::type result = 0;
+                    while(pos != end && static_cast<unsigned>(*pos - '0') <= 9) result = result*10 + (*pos++ - '0');
+                    value = static_cast<T>(negative ? 0 - result : result);
+                    return true;
+                }
+
+            /**
+             * @return false if only whitespace is left
+             */
+            bool skip_whitespace() {
+                while(pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\t' || *pos == '\r')) pos++;
+                return pos != end;
+            }
+
+            const char* position() const;
+
+        private:
+            [[noreturn]] void fail() const;
+
+            const char* pos;
+            const char* end;
+    };
+
+    /**
+     * Base of parsers reading records by operator>>, which may span lines
+     */
+    struct stream_text_parser { };
+
+    /**
+     * Parses records of text. Integers are read by text_scanner, other types by operator>>.
+     * Specialize it to read a type faster, e.g. with text_scanner. Text is split between lines,
+     * so records of specializations have to lie on single lines.
+     */
+    template <typename T, typename Enable = void>
+        struct text_parser : stream_text_parser {
+
+            template <typename F>
+                static void parse(const char* begin, const char* end, F f) {
+                    ::boost::iostreams::stream<::boost::iostreams::array_source> is(begin, end - begin);
+                    T record;
+                    while(is >> record) f(record);
+                }
+        };
+
+    template <typename T>
+        struct text_parser<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+
+            template <typename F>
+                static void parse(const char* begin, const char* end, F f) {
+                    text_scanner in(begin, end);
+                    T record;
+                    while(in.next(record)) f(record);
+                }
+        };
+
+    namespace input {
+
+        /**
+         * Every file is mapped by every process and split into newline aligned byte ranges, one for every
+         * reader thread of every process. Readers parse their ranges with text_parser and records are
+         * added in chunks (see input_provider::add_inputs) by input thread. Records have to lie on single lines.
+         */
+        template <typename T>
+            class mmap_file_input : public input_provider {
+
+                public:
+                    /**
+                     * @param readers threads parsing files in every process
+                     * @param chunk_size records added at once
+                     */
+                    mmap_file_input(std::vector<std::string> filenames, uint readers = 1, uint chunk_size = 1024)
+                        : filenames(std::move(filenames)),
+                        readers(std::max(readers, 1u)),
+                        chunk_size(std::max(chunk_size, 1u))
+                    { }
+
+                    virtual void operator()() override {
+                        std::vector<std::unique_ptr<mapped_file>> files;
+                        for(auto& filename: filenames) files.emplace_back(new mapped_file(filename));
+
+                        if(readers == 1) {
+                            read(files, 0, [this](std::vector<T>& chunk) { add_inputs(chunk); });
+                        } else {
+                            run_readers(files);
+                        }
+                        eof_callback();
+                    }
+
+                private:
+                    /**
+                     * Calls take with every full chunk of records of given reader and with the rest at the end
+                     */
+                    template <typename F>
+                        void read(const std::vector<std::unique_ptr<mapped_file>>& files, uint reader, F take) {
+                            context_info context = processor->context();
+                            uint parts = context.size*readers;
+                            uint part = context.rank*readers + reader;
+                            std::vector<T> chunk;
+                            chunk.reserve(chunk_size);
+                            for(auto& file: files) {
+                                byte_range range = line_range(file->data(), file->size(), part, parts);
+                                text_parser<T>::parse(file->data() + range.begin, file->data() + range.end,
+                                        [this, &chunk, &take](const T& record) {
+                                            chunk.push_back(record);
+                                            if(chunk.size() < chunk_size) return;
+                                            take(chunk);
+                                            chunk.clear();
+                                        });
+                            }
+                            if(!chunk.empty()) take(chunk);
+                        }
+
+                    /**
+                     * Readers hand chunks over to input thread, which adds them - work is created
+                     * only by input thread. Readers wait while readers*2 chunks are waiting.
+                     */
+                    void run_readers(const std::vector<std::unique_ptr<mapped_file>>& files) {
+                        std::mutex mutex;
+                        std::condition_variable changed;
+                        std::deque<std::vector<T>> ready;
+                        uint running = readers;
+                        std::exception_ptr failure;
+
+                        std::vector<std::thread> threads;
+                        for(uint r = 0; r < readers; r++) {
+                            threads.emplace_back([&, r]() {
+                                        try {
+                                            read(files, r, [&](std::vector<T>& chunk) {
+                                                        std::unique_lock<std::mutex> lock(mutex);
+                                                        changed.wait(lock, [&]() {
+                                                                    return ready.size() < 2*readers || failure;
+                                                                });
+                                                        if(failure) throw std::runtime_error("Input failed");
+                                                        ready.emplace_back(chunk);
+                                                        changed.notify_all();
+                                                    });
+                                        } catch(...) {
+                                            std::lock_guard<std::mutex> lock(mutex);
+                                            if(!failure) failure = std::current_exception();
+                                        }
+                                        std::lock_guard<std::mutex> lock(mutex);
+                                        running--;
+                                        changed.notify_all();
+                                    });
+                        }
+
+                        try {
+                            std::vector<T> chunk;
+                            while(true) {
+                                {
+                                    std::unique_lock<std::mutex> lock(mutex);
+                                    changed.wait(lock, [&]() { return !ready.empty() || running == 0 || failure; });
+                                    if(failure || ready.empty()) break;
+                                    chunk.swap(ready.front());
+                                    ready.pop_front();
+                                    changed.notify_all();
+                                }
+                                add_inputs(chunk);
+                            }
+                        } catch(...) {
+                            // readers waiting for room give up
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if(!failure) failure = std::current_exception();
+                            changed.notify_all();
+                        }
+                        for(auto& t: threads) t.join();
+                        if(failure) std::rethrow_exception(failure);
+                    }
+
+                    std::vector<std::string> filenames;
+                    uint readers;
+                    uint chunk_size;
+            };
+
+        /**
+         * The first process reads input in blocks, parses them with text_parser and scatters
+         * chunks of records to root tasks of all processes - in turns, or to the process partitioner
+         * gives for every record. Chunks are sent by computing thread as it takes them,
+         * while records of the next ones are read. Records read by operator>> are read one by one,
+         * as they may span lines.
+         */
+        template <typename T>
+            class scatter_stdin_input : public input_provider {
+
+                public:
+                    /**
+                     * @return process of the record, taken modulo number of processes
+                     */
+                    typedef std::function<uint(const T&)> partitioner;
+
+                    /**
+                     * @param chunk_size records sent at once
+                     */
+                    scatter_stdin_input(uint chunk_size = 1024, partitioner partition = partitioner(), 
+                            std::istream& in = std::cin)
+                        : chunk_size(std::max(chunk_size, 1u)), partition(std::move(partition)), in(in)
+                    { }
+
+                    virtual void operator()() override {
+                        context_info context = processor->context();
+                        if(context.rank == 0) scatter(context.size);
+                        eof_callback();
+                    }
+
+                private:
+                    static const std::size_t block_size = 1 << 20;
+
+                    void scatter(uint processes) {
+                        std::vector<std::vector<T>> chunks(partition ? processes : 1);
+                        for(auto& chunk: chunks) chunk.reserve(chunk_size);
+                        uint next = 0; // in turns
+
+                        auto take = [&](const T& record) {
+                            uint rank = partition ? partition(record) % processes : 0;
+                            std::vector<T>& chunk = chunks[rank];
+                            chunk.push_back(record);
+                            if(chunk.size() < chunk_size) return;
+                            add_inputs_to(partition ? rank : next++ % processes, chunk);
+                            chunk.clear();
+                        };
+
+                        read(take, std::is_base_of<stream_text_parser, text_parser<T>>());
+
+                        for(uint rank = 0; rank < chunks.size(); rank++) {
+                            if(!chunks[rank].empty()) add_inputs_to(partition ? rank : next++ % processes, chunks[rank]);
+                        }
+                    }
+
+                    template <typename F>
+                        void read(F take, std::true_type /* by operator>> */) {
+                            T record;
+                            while(in >> record) take(record);
+                        }
+
+                    /**
+                     * Block is parsed up to its last line, the rest is moved to the next one
+                     */
+                    template <typename F>
+                        void read(F take, std::false_type /* by operator>> */) {
+                            std::vector<char> block(block_size);
+                            std::size_t kept = 0;
+                            while(in) {
+                                if(kept == block.size()) block.resize(2*block.size()); // line longer than block
+                                in.read(block.data() + kept, block.size() - kept);
+                                std::size_t size = kept + in.gcount();
+                                std::size_t parsed = size;
+                                if(in) {
+                                    while(parsed > 0 && block[parsed - 1] != '\n') parsed--;
+                                    if(parsed == 0) {
+                                        kept = size;
+                                        continue;
+                                    }
+                                }
+                                text_parser<T>::parse(block.data(), block.data() + parsed, take);
+                                kept = size - parsed;
+                                std::copy(block.begin() + parsed, block.begin() + size, block.begin());
+                            }
+                        }
+
+                    uint chunk_size;
+                    partitioner partition;
+                    std::istream& in;
+            };
+    }
+}
+
+#endif
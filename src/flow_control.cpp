@@ -0,0 +1,64 @@
+#include "flow_control.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace dj {
+
+    message credit_message(uint64_t records) {
+        return message(credit_tag, std::string(reinterpret_cast<const char*>(&records), sizeof(records)));
+    }
+
+    uint64_t credits_of(const message& mes) {
+        uint64_t records;
+        if(mes.data.size() != sizeof(records)) throw std::runtime_error("Malformed credit message");
+        std::memcpy(&records, mes.data.data(), sizeof(records));
+        return records;
+    }
+
+    void credit_window::reset(uint ranks, uint64_t window) {
+        _window = window;
+        _in_flight.assign(ranks, 0);
+        not_returned.assign(ranks, 0);
+        exhausted_count = 0;
+    }
+
+    uint64_t credit_window::window() const {
+        return _window;
+    }
+
+    void credit_window::sent(uint to, uint64_t records) {
+        if(_window == 0) return;
+        bool was_exhausted = _in_flight[to] >= _window;
+        _in_flight[to] += records;
+        if(!was_exhausted && _in_flight[to] >= _window) exhausted_count++;
+    }
+
+    void credit_window::granted(uint from, uint64_t records) {
+        if(_window == 0) return;
+        bool was_exhausted = _in_flight[from] >= _window;
+        _in_flight[from] -= std::min(records, _in_flight[from]);
+        if(was_exhausted && _in_flight[from] < _window) exhausted_count--;
+    }
+
+    bool credit_window::exhausted() const {
+        return exhausted_count > 0;
+    }
+
+    bool credit_window::exhausted(uint to) const {
+        return _window > 0 && _in_flight[to] >= _window;
+    }
+
+    uint64_t credit_window::in_flight(uint to) const {
+        return _in_flight[to];
+    }
+
+    uint64_t credit_window::processed(uint from) {
+        if(_window == 0) return 0;
+        if(++not_returned[from] < std::max<uint64_t>(1, _window/2)) return 0;
+        uint64_t records = not_returned[from];
+        not_returned[from] = 0;
+        return records;
+    }
+}
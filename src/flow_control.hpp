@@ -0,0 +1,60 @@
+#ifndef FLOW_CONTROL_HPP
+#define FLOW_CONTROL_HPP
+
+#include <cstdint>
+#include <vector>
+#include "message.hpp"
+#include "batching.hpp"
+
+namespace dj {
+
+    /**
+     * Tag of message returning credits to a process that sent work
+     */
+    const int credit_tag = batch_tag + 1;
+
+    message credit_message(uint64_t records);
+    uint64_t credits_of(const message& mes);
+
+    /**
+     * Credits for work sent between processes. Every process may have at most window records
+     * sent to another one and not processed there yet, receiver returns credits in bulks
+     * of half a window as it processes them. Work for a destination out of credits waits
+     * in the sender until they come back.
+     */
+    class credit_window {
+
+        public:
+            /**
+             * @param window zero turns flow control off
+             */
+            void reset(uint ranks, uint64_t window);
+            uint64_t window() const;
+
+            void sent(uint to, uint64_t records);
+            void granted(uint from, uint64_t records);
+            /**
+             * @return true if records sent to some process reached the window
+             */
+            bool exhausted() const;
+            /**
+             * @return true if records sent to the process reached the window
+             */
+            bool exhausted(uint to) const;
+            uint64_t in_flight(uint to) const;
+
+            /**
+             * Counts processed record received from the process
+             * @return credits to be returned to it, 0 if not enough records were processed yet
+             */
+            uint64_t processed(uint from);
+
+        private:
+            uint64_t _window = 0;
+            std::vector<uint64_t> _in_flight; // for each destination
+            std::vector<uint64_t> not_returned; // for each source
+            uint exhausted_count = 0;
+    };
+}
+
+#endif
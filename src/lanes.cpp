@@ -0,0 +1,94 @@
+#include "lanes.hpp"
+
+#include <algorithm>
+
+namespace dj {
+
+    ework_lane lane_of(const work_unit& work) {
+        switch(work.work_type) {
+            case work_unit::ework_type::INPUT_WORK:
+                return ework_lane::INPUT;
+            case work_unit::ework_type::TASK_WORK:
+            case work_unit::ework_type::TASK_WORK_OUTPUT:
+                return ework_lane::TASK;
+            case work_unit::ework_type::REDUCER_COLLECT:
+            case work_unit::ework_type::REDUCER_REDUCE:
+            case work_unit::ework_type::REDUCER_WORK_OUTPUT:
+                return ework_lane::REDUCER;
+            case work_unit::ework_type::COORDINATOR_COORDINATE:
+            case work_unit::ework_type::COORDINATOR_OUTPUT:
+                return ework_lane::COORDINATOR;
+            case work_unit::ework_type::WATERMARK:
+                break;
+        }
+        // data holds types of nodes the watermark goes from and to
+        enode_type from = static_cast<enode_type>(work.data[0]);
+        enode_type to = static_cast<enode_type>(work.data[1]);
+        if(from == input_source.first && work.index_from == input_source.second) return ework_lane::INPUT;
+        if(from == enode_type::COORDINATOR || to == enode_type::COORDINATOR) return ework_lane::COORDINATOR;
+        if(from == enode_type::REDUCER || to == enode_type::REDUCER) return ework_lane::REDUCER;
+        return ework_lane::TASK;
+    }
+
+    work_lanes::work_lanes()
+        : lanes(lanes_count), weights(lanes_count, 0), served(lanes_count, 0)
+    { }
+
+    void work_lanes::set_weights(std::vector<uint> weights) {
+        weights.resize(lanes_count, 0);
+        this->weights = std::move(weights);
+        served.assign(lanes_count, 0);
+    }
+
+    void work_lanes::set_prioritized(bool prioritized) {
+        this->prioritized = prioritized;
+    }
+
+    void work_lanes::push(work_unit* work) {
+        auto& lane = lanes[static_cast<uint>(lane_of(*work))];
+        lane.push_back(work);
+        if(prioritized) std::push_heap(begin(lane), end(lane), lower_priority_first());
+    }
+
+    work_unit* work_lanes::pop() {
+        int chosen = -1;
+        for(int round = 0; round < 2 && chosen == -1; round++) {
+            for(uint i = 0; i < lanes_count; i++) {
+                if(lanes[i].empty()) continue;
+                if(weights[i] == 0 || served[i] < weights[i]) {
+                    chosen = i;
+                    break;
+                }
+            }
+            // every lane with work used its share, next round starts
+            if(chosen == -1) served.assign(lanes_count, 0);
+        }
+        if(chosen == -1) return nullptr;
+
+        served[chosen]++;
+        auto& lane = lanes[chosen];
+        work_unit* work;
+        if(prioritized) {
+            std::pop_heap(begin(lane), end(lane), lower_priority_first());
+            work = lane.back();
+            lane.pop_back();
+        } else {
+            work = lane.front();
+            lane.pop_front();
+        }
+        return work;
+    }
+
+    bool work_lanes::empty() const {
+        for(auto& lane: lanes) if(!lane.empty()) return false;
+        return true;
+    }
+
+    bool work_lanes::empty(ework_lane lane) const {
+        return lanes[static_cast<uint>(lane)].empty();
+    }
+
+    std::size_t work_lanes::size(ework_lane lane) const {
+        return lanes[static_cast<uint>(lane)].size();
+    }
+}
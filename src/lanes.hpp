@@ -0,0 +1,69 @@
+#ifndef LANES_HPP
+#define LANES_HPP
+
+#include <deque>
+#include <vector>
+#include "message.hpp"
+#include "watermark.hpp"
+
+namespace dj {
+
+    /**
+     * Lanes of work in order of priority
+     */
+    enum class ework_lane {
+        COORDINATOR,
+        REDUCER,
+        TASK,
+        INPUT
+    };
+
+    const uint lanes_count = static_cast<uint>(ework_lane::INPUT) + 1;
+
+    /**
+     * Watermark goes in lane of work on its edge, so that it never overtakes it
+     */
+    ework_lane lane_of(const work_unit& work);
+
+    /**
+     * Queues of work of computing thread, one for each lane. Lanes are served in order of priority,
+     * lane with weight w gives way to the next ones after w works while they have any, lane of weight 0
+     * is served until it is empty (default). Work of each lane is taken in order it came in,
+     * or with lower priority first if lanes are prioritized.
+     */
+    class work_lanes {
+
+        public:
+            work_lanes();
+
+            /**
+             * @param weights for each lane, missing ones are 0
+             */
+            void set_weights(std::vector<uint> weights);
+            void set_prioritized(bool prioritized);
+
+            void push(work_unit* work);
+            /**
+             * @return next work to be processed, nullptr if there is none
+             */
+            work_unit* pop();
+
+            bool empty() const;
+            bool empty(ework_lane lane) const;
+            std::size_t size(ework_lane lane) const;
+
+        private:
+            struct lower_priority_first {
+                bool operator()(const work_unit* w1, const work_unit* w2) const {
+                    return w1->priority > w2->priority;
+                }
+            };
+
+            std::vector<std::deque<work_unit*>> lanes;
+            std::vector<uint> weights;
+            std::vector<uint> served; // in the current round
+            bool prioritized = false;
+    };
+}
+
+#endif
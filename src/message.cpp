@@ -1,5 +1,7 @@
 #include <cassert>
 #include <chrono>
+#include <mutex>
+#include <unordered_set>
 
 #include "message.hpp"
 
@@ -14,27 +16,16 @@ namespace dj {
         : tag(tag), data(std::move(data)) 
     { }
 
-    message::message(message&& other) : tag(other.tag), data(std::move(other.data)) { }
-
-    message& message::operator=(message&& other) {
-        tag = other.tag;
-        data = std::move(other.data);
-        return *this;
+    const char* work_unit::work_type_name(ework_type type) {
+        static const char* names[] = { "INPUT_WORK", "TASK_WORK", "REDUCER_COLLECT", "REDUCER_REDUCE",
+            "COORDINATOR_COORDINATE", "COORDINATOR_OUTPUT", "REDUCER_WORK_OUTPUT", "TASK_WORK_OUTPUT", "WATERMARK" };
+        return names[static_cast<int>(type)];
     }
 
     message& message::operator<<(const work_unit& work) {
-
-        std::ostringstream os;
-        ::boost::archive::binary_oarchive archive(os, ::boost::archive::no_header);
         tag = static_cast<int>(work.work_type);
-        archive << work.type_name;
-        archive << work.data;
-        archive << work.locale;
-        archive << work.index_to;
-        archive << work.index_from;
-        archive << work.phase;
-
-        data = os.str();
+        data.clear();
+        work.write(data);
         return *this;
     }
 
@@ -45,6 +36,7 @@ namespace dj {
         archive << mes.from_rank;
         archive << mes.pass_number;
         archive << mes.counter;
+        archive << mes.urgent_sent;
 
         data = os.str();
         return *this;
@@ -54,70 +46,145 @@ namespace dj {
         : rank(rank), hostname(std::move(hostname)), timestamp(timestamp) 
     { }
 
-    locale_info::locale_info(locale_info&& other) 
-        : rank(other.rank), hostname(std::move(other.hostname)), timestamp(other.timestamp) 
-    { }
-
-    locale_info& locale_info::operator=(locale_info&& other) {
-        rank = other.rank;
-        hostname = std::move(other.hostname);
-        timestamp = other.timestamp;
-        return *this;
-    }
-
     locale_info locale_info::get_basic() {
         assert(_context != nullptr);
         return { _context->rank, _context->hostname, context_info::get_current_timestamp() };
     }
 
-    const context_info* locale_info::_context = nullptr;
+    thread_local const context_info* locale_info::_context = nullptr;
+
+    const char* intern_type_name(const char* name, std::size_t size) {
+        static std::mutex names_mutex;
+        static std::unordered_set<std::string> names;
+        // records in a row are mostly of the same type
+        static thread_local const char* last = nullptr;
+        if(last != nullptr && std::strncmp(last, name, size) == 0 && last[size] == '\0') return last;
+
+        static thread_local std::string key;
+        key.assign(name, size);
+        std::lock_guard<std::mutex> lock(names_mutex);
+        last = names.insert(key).first->c_str();
+        return last;
+    }
 
     work_unit::work_unit(ework_type work_type, 
-            std::string data, 
-            std::string type_name, 
+            payload data, 
+            const char* type_name, 
             locale_info locale,
             int index_to,
             int index_from)
         : work_type(work_type),
-        type_name(std::move(type_name)),
+        type_name(type_name),
         data(std::move(data)),
         index_to(index_to),
         index_from(index_from),
         locale(std::move(locale))
     { }
 
-    work_unit& work_unit::operator=(work_unit&& other) {
-        work_type = other.work_type;
-        type_name = std::move(other.type_name);
-        data = std::move(other.data);
-        locale = std::move(other.locale);
-
-        return *this;
+    namespace {
+
+        // work is written field by field in the byte order of the machine, processes run the same binary
+
+        const uint8_t sampled_flag = 1;
+        const uint8_t chunk_flag = 2;
+
+        template <typename T>
+            void put(std::string& out, const T& t) {
+                out.append(reinterpret_cast<const char*>(&t), sizeof(T));
+            }
+
+        void put_bytes(std::string& out, const char* data, uint32_t size) {
+            put(out, size);
+            out.append(data, size);
+        }
+
+        struct reader {
+            const char* pos;
+            const char* end;
+
+            const char* take(std::size_t size) {
+                if(static_cast<std::size_t>(end - pos) < size) 
+                    throw serialization::serialization_exception("Truncated work message");
+                const char* taken = pos;
+                pos += size;
+                return taken;
+            }
+
+            template <typename T>
+                void get(T& t) {
+                    std::memcpy(&t, take(sizeof(T)), sizeof(T));
+                }
+
+            std::pair<const char*, uint32_t> get_bytes() {
+                uint32_t size;
+                get(size);
+                return { take(size), size };
+            }
+        };
     }
 
-    work_unit& work_unit::operator<<(const message& mes) {
+    void work_unit::write(std::string& out) const {
+        put_bytes(out, type_name, std::strlen(type_name));
+        put_bytes(out, data.data(), data.size());
+        put(out, locale.rank);
+        put_bytes(out, locale.hostname.data(), locale.hostname.size());
+        put(out, locale.timestamp);
+        put(out, index_to);
+        put(out, index_from);
+        put(out, phase);
+        put(out, priority);
+        put(out, event_time);
+        // most records are not sampled, they pay only for the flags
+        uint8_t flags = (origin != 0 ? sampled_flag : 0) | (chunk ? chunk_flag : 0);
+        put(out, flags);
+        if(origin != 0) {
+            put(out, origin);
+            put(out, origin_host);
+        }
+    }
 
-        std::istringstream is(mes.data);
-        ::boost::archive::binary_iarchive archive(is, ::boost::archive::no_header);
-        work_type = static_cast<work_unit::ework_type>(mes.tag);
-        archive >> type_name;
-        archive >> data;
-        archive >> locale;
-        archive >> index_to;
-        archive >> index_from;
-        archive >> phase;
+    work_unit& work_unit::read(int tag, const char* data, std::size_t size) {
+
+        reader in{ data, data + size };
+        work_type = static_cast<work_unit::ework_type>(tag);
+        auto name = in.get_bytes();
+        type_name = intern_type_name(name.first, name.second);
+        auto bytes = in.get_bytes();
+        this->data.assign(bytes.first, bytes.second);
+        in.get(locale.rank);
+        auto host = in.get_bytes();
+        locale.hostname.assign(host.first, host.second);
+        in.get(locale.timestamp);
+        in.get(index_to);
+        in.get(index_from);
+        in.get(phase);
+        in.get(priority);
+        in.get(event_time);
+        uint8_t flags;
+        in.get(flags);
+        origin = 0;
+        if(flags & sampled_flag) {
+            in.get(origin);
+            in.get(origin_host);
+        }
+        chunk = flags & chunk_flag;
 
         return *this;
     }
 
+    work_unit& work_unit::operator<<(const message& mes) {
+        return read(mes.tag, mes.data.data(), mes.data.size());
+    }
+
     end_message& end_message::operator<<(const message& mes) {
 
-        std::istringstream is(mes.data);
+        ::boost::iostreams::stream<::boost::iostreams::array_source> is(mes.data.data(), mes.data.size());
         ::boost::archive::binary_iarchive archive(is, ::boost::archive::no_header);
         end_type = static_cast<end_message::eend_message_type>(mes.tag);
         archive >> from_rank;
         archive >> pass_number;
         archive >> counter;
+        archive >> urgent_sent;
 
         return *this;
     }
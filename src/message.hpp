@@ -1,8 +1,13 @@
 #ifndef MESSAGE_HPP 
 #define MESSAGE_HPP 
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <typeinfo>
+#include <type_traits>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/extended_type_info_no_rtti.hpp>
@@ -11,6 +16,8 @@
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
+#include "payload.hpp"
+#include "template_utils.hpp"
 
 namespace dj {
 
@@ -39,8 +46,8 @@ namespace dj {
     struct message {
         message() = default;
         message(int tag, std::string data);
-        message(message&& other);
-        message& operator=(message&& other);
+        message(message&& other) noexcept = default;
+        message& operator=(message&& other) noexcept = default;
 
         message& operator<<(const work_unit& work); 
         message& operator<<(const end_message& end_mes); 
@@ -56,10 +63,10 @@ namespace dj {
 
         locale_info() = default;
         locale_info(uint rank, std::string hostname, uint64_t timestamp);
-        locale_info(locale_info&& other);
+        locale_info(locale_info&& other) noexcept = default;
         locale_info(const locale_info& other) = default;
         locale_info& operator=(const locale_info& other) = default;
-        locale_info& operator=(locale_info&& other);
+        locale_info& operator=(locale_info&& other) noexcept = default;
 
         static locale_info get_basic();
 
@@ -68,7 +75,7 @@ namespace dj {
         uint64_t timestamp;
 
         private:
-            static const context_info* _context;
+            static thread_local const context_info* _context;
 
             friend class boost::serialization::access;
             template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
@@ -78,68 +85,6 @@ namespace dj {
             }
     };
 
-    struct work_unit {
-
-        enum class ework_type {
-            INPUT_WORK,
-            TASK_WORK,
-            REDUCER_COLLECT,
-            REDUCER_REDUCE,
-            COORDINATOR_COORDINATE,
-            COORDINATOR_OUTPUT,
-            REDUCER_WORK_OUTPUT,
-            TASK_WORK_OUTPUT
-        };
-
-        work_unit(ework_type work_type, 
-                std::string data, 
-                std::string type_name, 
-                locale_info locale, 
-                int index_to, 
-                int index_from);
-
-        work_unit() = default;
-        work_unit(const work_unit& other) = default;
-        work_unit(work_unit&& other);
-        ~work_unit() = default;
-
-        work_unit& operator<<(const message& mes);
-
-        work_unit& operator=(work_unit&& other);
-        work_unit& operator=(const work_unit& other) = default;
-
-        ework_type work_type;
-        std::string type_name;
-        std::string data;
-        uint index_to;
-        uint index_from;
-        locale_info locale;
-        ecomputation_phase phase;
-
-        template <typename T>
-            static work_unit get_basic(const T& t, work_unit::ework_type work_type, int index_to, int index_from) {
-
-                std::ostringstream os;
-                boost::archive::binary_oarchive archive(os, boost::archive::no_header);
-                archive << t;
-                return work_unit(work_type, os.str(), typeid(T).name(), locale_info::get_basic(), index_to, index_from);
-            }
-    };
-
-    struct end_message {
-        uint from_rank;
-        uint pass_number; 
-        uint counter; 
-        enum class eend_message_type {
-            TASK_END = static_cast<int>(work_unit::ework_type::TASK_WORK_OUTPUT)+1,
-            REDUCTION_END,
-            WORK_END
-        };
-        eend_message_type end_type;
-
-        end_message& operator<<(const message& mes);
-    };
-
     namespace serialization {
 
         class serialization_exception : std::exception {
@@ -192,7 +137,269 @@ namespace dj {
 
                 return t;
             }
+
+        /**
+         * Types written into payload as their bytes, without an archive. Specialize it
+         * for trivially copyable structs sent between processes of the same binary.
+         */
+        template <typename T>
+            struct is_bitwise : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> { };
+
+        template <typename T>
+            typename std::enable_if<is_bitwise<T>::value, payload&>::type operator<<(payload& data, const T& t) {
+                static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be bitwise");
+                data.assign(reinterpret_cast<const char*>(&t), sizeof(T));
+                return data;
+            }
+
+        template <typename T>
+            typename std::enable_if<!is_bitwise<T>::value, payload&>::type operator<<(payload& data, const T& t) {
+
+                try {
+                    std::ostringstream os;
+                    boost::archive::binary_oarchive archive(os, boost::archive::no_header);
+                    archive << t;
+                    data = os.str();
+
+                } catch(boost::archive::archive_exception& ae) {
+                    throw serialization_exception(ae.what());
+                }
+
+                return data;
+            }
+
+        template <typename T>
+            typename std::enable_if<is_bitwise<T>::value, T&>::type operator>>(const payload& data, T& t) {
+                if(data.size() != sizeof(T)) 
+                    throw serialization_exception("Payload of " + std::to_string(data.size()) 
+                            + " bytes does not hold " + typeid(T).name());
+                std::memcpy(&t, data.data(), sizeof(T));
+                return t;
+            }
+
+        template <typename T>
+            typename std::enable_if<!is_bitwise<T>::value, T&>::type operator>>(const payload& data, T& t) {
+
+                try {
+                    ::boost::iostreams::stream<::boost::iostreams::array_source> is(data.data(), data.size());
+                    boost::archive::binary_iarchive archive(is, boost::archive::no_header);
+                    archive >> t;
+
+                } catch(boost::archive::archive_exception& ae) {
+                    throw serialization_exception(ae.what());
+                }
+
+                return t;
+            }
+
+        /**
+         * Chunk of records is their count followed by their bytes if they are bitwise,
+         * or by a single archive of all of them otherwise
+         */
+        template <typename T>
+            typename std::enable_if<is_bitwise<T>::value>::type write_chunk(payload& data, const T* records, std::size_t count) {
+                static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be bitwise");
+                uint64_t n = count;
+                char* out = data.prepare(sizeof(n) + count*sizeof(T));
+                std::memcpy(out, &n, sizeof(n));
+                if(count > 0) std::memcpy(out + sizeof(n), records, count*sizeof(T));
+            }
+
+        template <typename T>
+            typename std::enable_if<!is_bitwise<T>::value>::type write_chunk(payload& data, const T* records, std::size_t count) {
+
+                try {
+                    std::ostringstream os;
+                    uint64_t n = count;
+                    os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+                    boost::archive::binary_oarchive archive(os, boost::archive::no_header);
+                    for(std::size_t i = 0; i < count; i++) archive << records[i];
+                    data = os.str();
+
+                } catch(boost::archive::archive_exception& ae) {
+                    throw serialization_exception(ae.what());
+                }
+            }
+
+        /**
+         * @return number of records in chunk
+         */
+        inline uint64_t chunk_size(const payload& data) {
+            if(data.size() < sizeof(uint64_t)) throw serialization_exception("Payload does not hold a chunk");
+            uint64_t n;
+            std::memcpy(&n, data.data(), sizeof(n));
+            return n;
+        }
+
+        /**
+         * @param buffer keeps records which could not be read in place
+         * @return records of chunk, bitwise ones point right into data when it is aligned for them
+         */
+        template <typename T>
+            typename std::enable_if<is_bitwise<T>::value, span<const T>>::type read_chunk(const payload& data, 
+                    std::vector<T>& buffer) {
+                uint64_t n = chunk_size(data);
+                if(data.size() != sizeof(n) + n*sizeof(T)) 
+                    throw serialization_exception("Payload of " + std::to_string(data.size()) 
+                            + " bytes does not hold chunk of " + typeid(T).name());
+                const char* records = data.data() + sizeof(n);
+                if(reinterpret_cast<std::uintptr_t>(records) % alignof(T) == 0) 
+                    return span<const T>(reinterpret_cast<const T*>(records), n);
+                buffer.resize(n);
+                std::memcpy(buffer.data(), records, n*sizeof(T));
+                return span<const T>(buffer.data(), n);
+            }
+
+        template <typename T>
+            typename std::enable_if<!is_bitwise<T>::value, span<const T>>::type read_chunk(const payload& data, 
+                    std::vector<T>& buffer) {
+                uint64_t n = chunk_size(data);
+
+                try {
+                    ::boost::iostreams::stream<::boost::iostreams::array_source> is(
+                            data.data() + sizeof(n), data.size() - sizeof(n));
+                    boost::archive::binary_iarchive archive(is, boost::archive::no_header);
+                    buffer.resize(n);
+                    for(auto& record: buffer) archive >> record;
+
+                } catch(boost::archive::archive_exception& ae) {
+                    throw serialization_exception(ae.what());
+                }
+
+                return span<const T>(buffer.data(), n);
+            }
+    }
+
+    /**
+     * @return pointer to the same name for every equal name, names of types of received work are kept once
+     */
+    const char* intern_type_name(const char* name, std::size_t size);
+
+    inline bool same_type_name(const char* name1, const char* name2) {
+        return name1 == name2 || std::strcmp(name1, name2) == 0;
     }
+
+    struct work_unit {
+
+        enum class ework_type {
+            INPUT_WORK,
+            TASK_WORK,
+            REDUCER_COLLECT,
+            REDUCER_REDUCE,
+            COORDINATOR_COORDINATE,
+            COORDINATOR_OUTPUT,
+            REDUCER_WORK_OUTPUT,
+            TASK_WORK_OUTPUT,
+            WATERMARK           // no record with lower event time will follow from the sending node
+        };
+
+        work_unit(ework_type work_type, 
+                payload data, 
+                const char* type_name, 
+                locale_info locale, 
+                int index_to, 
+                int index_from);
+
+        work_unit() = default;
+        work_unit(const work_unit& other) = default;
+        work_unit(work_unit&& other) noexcept = default;
+        ~work_unit() = default;
+
+        work_unit& operator<<(const message& mes);
+        /**
+         * Reads work serialized by write
+         */
+        work_unit& read(int tag, const char* data, std::size_t size);
+        /**
+         * Appends serialized work (without its type, which is a tag of message) to out
+         */
+        void write(std::string& out) const;
+
+        /**
+         * @return name of work type for traces and reports
+         */
+        static const char* work_type_name(ework_type type);
+
+        work_unit& operator=(work_unit&& other) noexcept = default;
+        work_unit& operator=(const work_unit& other) = default;
+
+        ework_type work_type;
+        const char* type_name = ""; // typeid name of sent type, interned when received
+        payload data;
+        uint index_to;
+        uint index_from;
+        locale_info locale;
+        ecomputation_phase phase;
+        int64_t priority = 0; // in asynchronous mode work with lower priority is processed first
+        uint64_t event_time = 0; // time of the input record this work results from
+        uint64_t origin = 0; // monotonic time the sampled input record entered pipeline, 0 if not sampled
+        uint64_t origin_host = 0; // machine whose clock origin comes from, see latency_sampler::host
+        bool chunk = false; // data holds a chunk of records, see serialization::write_chunk
+
+        template <typename T>
+            static work_unit get_basic(const T& t, work_unit::ework_type work_type, int index_to, int index_from) {
+
+                using serialization::operator<<;
+                work_unit work;
+                work.work_type = work_type;
+                work.data << t;
+                work.type_name = typeid(T).name();
+                work.locale = locale_info::get_basic();
+                work.index_to = index_to;
+                work.index_from = index_from;
+                return work;
+            }
+
+        template <typename T>
+            static work_unit get_chunk(const T* records, std::size_t count, 
+                    work_unit::ework_type work_type, int index_to, int index_from) {
+
+                work_unit work;
+                work.work_type = work_type;
+                serialization::write_chunk(work.data, records, count);
+                work.chunk = true;
+                work.type_name = typeid(T).name();
+                work.locale = locale_info::get_basic();
+                work.index_to = index_to;
+                work.index_from = index_from;
+                return work;
+            }
+
+        /**
+         * @param chunk records of type T written before by serialization::write_chunk, copied as they are
+         */
+        template <typename T>
+            static work_unit get_written_chunk(const char* chunk, std::size_t size, 
+                    work_unit::ework_type work_type, int index_to, int index_from) {
+
+                work_unit work;
+                work.work_type = work_type;
+                work.data.assign(chunk, size);
+                serialization::chunk_size(work.data); // at least holds a count
+                work.chunk = true;
+                work.type_name = typeid(T).name();
+                work.locale = locale_info::get_basic();
+                work.index_to = index_to;
+                work.index_from = index_from;
+                return work;
+            }
+    };
+
+    struct end_message {
+        uint from_rank;
+        uint pass_number; 
+        uint counter; 
+        enum class eend_message_type {
+            TASK_END = static_cast<int>(work_unit::ework_type::WATERMARK)+1,
+            REDUCTION_END,
+            WORK_END
+        };
+        eend_message_type end_type;
+        // urgent messages the sender sent to the receiver before this one, end message waits for them
+        uint64_t urgent_sent;
+
+        end_message& operator<<(const message& mes);
+    };
 }
 
 #endif
@@ -0,0 +1,374 @@
+#include "metrics.hpp"
+#include "message.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace dj {
+
+    // values below sub_buckets have their own buckets, then every power of two has sub_buckets
+    latency_histogram::latency_histogram() : buckets(sub_buckets + (64-4)*sub_buckets, 0) { }
+
+    uint latency_histogram::bucket(uint64_t value) {
+        if(value < sub_buckets) return value;
+        uint exponent = 63 - __builtin_clzll(value);
+        uint shift = exponent - 4;
+        return sub_buckets + shift*sub_buckets + ((value >> shift) - sub_buckets);
+    }
+
+    uint64_t latency_histogram::lowest(uint bucket) {
+        if(bucket < sub_buckets) return bucket;
+        uint shift = (bucket - sub_buckets)/sub_buckets;
+        uint64_t sub = (bucket - sub_buckets)%sub_buckets;
+        return (sub_buckets + sub) << shift;
+    }
+
+    void latency_histogram::record(uint64_t value) {
+        buckets[bucket(value)]++;
+        _count++;
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+        sum += value;
+    }
+
+    void latency_histogram::merge(const latency_histogram& other) {
+        for(uint i = 0; i < buckets.size(); i++) buckets[i] += other.buckets[i];
+        _count += other._count;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+        sum += other.sum;
+    }
+
+    uint64_t latency_histogram::count() const {
+        return _count;
+    }
+
+    uint64_t latency_histogram::min() const {
+        return _count ? _min : 0;
+    }
+
+    uint64_t latency_histogram::max() const {
+        return _max;
+    }
+
+    double latency_histogram::mean() const {
+        return _count ? sum/_count : 0;
+    }
+
+    uint64_t latency_histogram::percentile(double p) const {
+        if(_count == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, std::ceil(p*_count));
+        uint64_t seen = 0;
+        for(uint i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if(seen < rank) continue;
+            if(seen == _count) return _max; // last bucket holds the maximum
+            return std::max(lowest(i), _min);
+        }
+        return _max;
+    }
+
+    void node_metrics::merge(const node_metrics& other) {
+        records_in += other.records_in;
+        records_out += other.records_out;
+        bytes_in += other.bytes_in;
+        bytes_out += other.bytes_out;
+        deserialization_ns += other.deserialization_ns;
+        handler_ns += other.handler_ns;
+        process_ns.merge(other.process_ns);
+    }
+
+    node_metrics* metrics_registry::add(std::string type, std::string name, uint index) {
+        nodes.emplace_back(new node_metrics());
+        node_metrics* m = nodes.back().get();
+        m->type = std::move(type);
+        m->name = std::move(name);
+        m->index = index;
+        return m;
+    }
+
+    void metrics_registry::merge(const metrics_registry& other) {
+        for(auto& o: other.nodes) {
+            auto it = std::find_if(begin(nodes), end(nodes), [&o](const std::unique_ptr<node_metrics>& n) {
+                        return n->type == o->type && n->index == o->index;
+                    });
+            if(it == end(nodes)) {
+                nodes.emplace_back(new node_metrics(*o));
+            } else {
+                (*it)->merge(*o);
+            }
+        }
+        for(uint i = 0; i < phase_ns.size(); i++) phase_ns[i] = std::max(phase_ns[i], other.phase_ns[i]);
+        peak_rss_kb = std::max(peak_rss_kb, other.peak_rss_kb);
+        input_stall_ns = std::max(input_stall_ns, other.input_stall_ns);
+        credit_stall_ns = std::max(credit_stall_ns, other.credit_stall_ns);
+    }
+
+    void metrics_registry::add_phase_time(uint phase, uint64_t ns) {
+        phase_ns.at(phase) += ns;
+    }
+
+    uint64_t metrics_registry::phase_time(uint phase) const {
+        return phase_ns.at(phase);
+    }
+
+    void metrics_registry::set_peak_rss(uint64_t kb) {
+        peak_rss_kb = kb;
+    }
+
+    uint64_t metrics_registry::peak_rss() const {
+        return peak_rss_kb;
+    }
+
+    void metrics_registry::add_input_stall(uint64_t ns) {
+        input_stall_ns += ns;
+    }
+
+    uint64_t metrics_registry::input_stall() const {
+        return input_stall_ns;
+    }
+
+    void metrics_registry::add_credit_stall(uint64_t ns) {
+        credit_stall_ns += ns;
+    }
+
+    uint64_t metrics_registry::credit_stall() const {
+        return credit_stall_ns;
+    }
+
+    std::string metrics_registry::to_json(int rank, int ranks) const {
+        std::ostringstream os;
+        os << "{\"rank\": " << rank << ", \"ranks\": " << ranks << ", \"peak_rss_kb\": " << peak_rss_kb
+            << ", \"phase_ns\": {\"TASKS\": " << phase_ns[0] << ", \"REDUCTION\": " << phase_ns[1]
+            << ", \"PIPE_END\": " << phase_ns[2] << ", \"WORK_END\": " << phase_ns[3] << "}"
+            << ", \"stall_ns\": {\"input\": " << input_stall_ns << ", \"credits\": " << credit_stall_ns << "}, \"nodes\": [";
+        for(uint i = 0; i < nodes.size(); i++) {
+            const node_metrics& n = *nodes[i];
+            const latency_histogram& h = n.process_ns;
+            os << (i ? ",\n" : "\n")
+                << "  {\"type\": \"" << n.type << "\", \"name\": \"" << n.name << "\", \"index\": " << n.index
+                << ", \"records_in\": " << n.records_in << ", \"records_out\": " << n.records_out
+                << ", \"bytes_in\": " << n.bytes_in << ", \"bytes_out\": " << n.bytes_out
+                << ", \"deserialization_ns\": " << n.deserialization_ns << ", \"handler_ns\": " << n.handler_ns
+                << ", \"process_ns\": {\"count\": " << h.count() << ", \"min\": " << h.min()
+                << ", \"mean\": " << h.mean() << ", \"p50\": " << h.percentile(0.5)
+                << ", \"p90\": " << h.percentile(0.9) << ", \"p99\": " << h.percentile(0.99)
+                << ", \"p999\": " << h.percentile(0.999) << ", \"max\": " << h.max() << "}}";
+        }
+        os << "\n]}\n";
+        return os.str();
+    }
+
+    void metrics_registry::clear() {
+        nodes.clear();
+        phase_ns.assign(phase_ns.size(), 0);
+        peak_rss_kb = 0;
+        input_stall_ns = 0;
+        credit_stall_ns = 0;
+    }
+
+    namespace {
+        const uint work_types = static_cast<uint>(work_unit::ework_type::WATERMARK) + 1;
+    }
+
+    void traffic_matrix::reset(uint rank, uint ranks) {
+        this->rank = rank;
+        this->ranks = ranks;
+        _passes.assign(1, empty_pass());
+        sizes.assign(ranks*ranks, latency_histogram());
+    }
+
+    uint traffic_matrix::cell(uint from, uint to, int work_type) const {
+        return (from*ranks + to)*work_types + work_type;
+    }
+
+    traffic_matrix::pass_counts traffic_matrix::empty_pass() const {
+        pass_counts pass;
+        pass.sent.resize(ranks*ranks*work_types);
+        pass.received.resize(ranks*ranks*work_types);
+        return pass;
+    }
+
+    void traffic_matrix::record_sent(uint to, int work_type, uint64_t bytes) {
+        counts& c = _passes.back().sent[cell(rank, to, work_type)];
+        c.messages++;
+        c.bytes += bytes;
+        sizes[rank*ranks + to].record(bytes);
+    }
+
+    void traffic_matrix::record_received(uint from, int work_type, uint64_t bytes) {
+        counts& c = _passes.back().received[cell(from, rank, work_type)];
+        c.messages++;
+        c.bytes += bytes;
+    }
+
+    void traffic_matrix::end_pass() {
+        _passes.push_back(empty_pass());
+    }
+
+    uint traffic_matrix::passes() const {
+        return _passes.size();
+    }
+
+    uint64_t traffic_matrix::sent_messages(uint pass, uint from, uint to) const {
+        uint64_t messages = 0;
+        for(uint t = 0; t < work_types; t++) messages += _passes.at(pass).sent[cell(from, to, t)].messages;
+        return messages;
+    }
+
+    uint64_t traffic_matrix::sent_bytes(uint pass, uint from, uint to) const {
+        uint64_t bytes = 0;
+        for(uint t = 0; t < work_types; t++) bytes += _passes.at(pass).sent[cell(from, to, t)].bytes;
+        return bytes;
+    }
+
+    const latency_histogram& traffic_matrix::message_sizes(uint from, uint to) const {
+        return sizes.at(from*ranks + to);
+    }
+
+    void traffic_matrix::merge(const traffic_matrix& other) {
+        if(other.ranks != ranks) throw std::runtime_error("Merging traffic of different number of processes");
+        while(_passes.size() < other._passes.size()) _passes.push_back(empty_pass());
+        for(uint p = 0; p < other._passes.size(); p++) {
+            for(uint i = 0; i < other._passes[p].sent.size(); i++) {
+                _passes[p].sent[i].messages += other._passes[p].sent[i].messages;
+                _passes[p].sent[i].bytes += other._passes[p].sent[i].bytes;
+                _passes[p].received[i].messages += other._passes[p].received[i].messages;
+                _passes[p].received[i].bytes += other._passes[p].received[i].bytes;
+            }
+        }
+        for(uint i = 0; i < sizes.size(); i++) sizes[i].merge(other.sizes[i]);
+    }
+
+    std::string traffic_matrix::to_json() const {
+        std::ostringstream os;
+        os << "{\"ranks\": " << ranks << ", \"passes\": [";
+        for(uint p = 0; p < _passes.size(); p++) {
+            os << (p ? ",\n" : "\n") << "  {\"pass\": " << p << ", \"messages\": [";
+            for(uint from = 0; from < ranks; from++) {
+                os << (from ? ", [" : "[");
+                for(uint to = 0; to < ranks; to++) os << (to ? ", " : "") << sent_messages(p, from, to);
+                os << "]";
+            }
+            os << "], \"bytes\": [";
+            for(uint from = 0; from < ranks; from++) {
+                os << (from ? ", [" : "[");
+                for(uint to = 0; to < ranks; to++) os << (to ? ", " : "") << sent_bytes(p, from, to);
+                os << "]";
+            }
+            os << "], \"cells\": [";
+            bool first = true;
+            for(uint from = 0; from < ranks; from++) for(uint to = 0; to < ranks; to++) for(uint t = 0; t < work_types; t++) {
+                const counts& sent = _passes[p].sent[cell(from, to, t)];
+                const counts& received = _passes[p].received[cell(from, to, t)];
+                if(sent.messages == 0 && received.messages == 0) continue;
+                os << (first ? "\n" : ",\n") << "    {\"from\": " << from << ", \"to\": " << to 
+                    << ", \"type\": \"" << work_unit::work_type_name(static_cast<work_unit::ework_type>(t)) << "\""
+                    << ", \"sent_messages\": " << sent.messages << ", \"sent_bytes\": " << sent.bytes
+                    << ", \"received_messages\": " << received.messages << ", \"received_bytes\": " << received.bytes << "}";
+                first = false;
+            }
+            os << "]}";
+        }
+        os << "\n], \"message_sizes\": [";
+        bool first = true;
+        for(uint from = 0; from < ranks; from++) for(uint to = 0; to < ranks; to++) {
+            const latency_histogram& h = sizes[from*ranks + to];
+            if(h.count() == 0) continue;
+            os << (first ? "\n" : ",\n") << "  {\"from\": " << from << ", \"to\": " << to 
+                << ", \"count\": " << h.count() << ", \"min\": " << h.min() << ", \"mean\": " << h.mean()
+                << ", \"p50\": " << h.percentile(0.5) << ", \"p90\": " << h.percentile(0.9)
+                << ", \"p99\": " << h.percentile(0.99) << ", \"max\": " << h.max() << "}";
+            first = false;
+        }
+        os << "\n]}\n";
+        return os.str();
+    }
+
+    void latency_sampler::reset(uint every) {
+        this->every = every;
+        until_sample = 1; // the first record is sampled
+        outputs.clear();
+        char name[256] = { 0 };
+        gethostname(name, sizeof(name) - 1);
+        this_host = std::hash<std::string>()(name);
+    }
+
+    void latency_sampler::add_output(uint index, std::string name) {
+        outputs.emplace_back();
+        outputs.back().index = index;
+        outputs.back().name = std::move(name);
+    }
+
+    uint64_t latency_sampler::sample() {
+        if(every == 0 || --until_sample) return 0;
+        until_sample = every;
+        return now();
+    }
+
+    latency_sampler::output_latency& latency_sampler::output(uint index) {
+        for(auto& o: outputs) if(o.index == index) return o;
+        throw std::runtime_error("No output with index: " + std::to_string(index));
+    }
+
+    uint64_t latency_sampler::host() const {
+        return this_host;
+    }
+
+    void latency_sampler::record(uint output, uint64_t origin, uint64_t origin_host) {
+        uint64_t now = latency_sampler::now();
+        output_latency& o = this->output(output);
+        if(origin_host != this_host) o.other_host++;
+        else o.ns.record(now > origin ? now - origin : 0);
+    }
+
+    const latency_histogram& latency_sampler::latencies(uint output) const {
+        return const_cast<latency_sampler*>(this)->output(output).ns;
+    }
+
+    uint64_t latency_sampler::other_host_samples(uint output) const {
+        return const_cast<latency_sampler*>(this)->output(output).other_host;
+    }
+
+    uint64_t latency_sampler::now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void latency_sampler::merge(const latency_sampler& other) {
+        every = other.every;
+        for(auto& o: other.outputs) {
+            auto it = std::find_if(begin(outputs), end(outputs), [&o](const output_latency& l) {
+                        return l.index == o.index;
+                    });
+            if(it == end(outputs)) outputs.push_back(o);
+            else {
+                it->ns.merge(o.ns);
+                it->other_host += o.other_host;
+            }
+        }
+    }
+
+    std::string latency_sampler::to_json(int rank, int ranks) const {
+        std::ostringstream os;
+        os << "{\"rank\": " << rank << ", \"ranks\": " << ranks << ", \"sampled_every\": " << every 
+            << ", \"outputs\": [";
+        for(uint i = 0; i < outputs.size(); i++) {
+            const latency_histogram& h = outputs[i].ns;
+            os << (i ? ",\n" : "\n")
+                << "  {\"name\": \"" << outputs[i].name << "\", \"index\": " << outputs[i].index
+                << ", \"latency_ns\": {\"count\": " << h.count() << ", \"min\": " << h.min()
+                << ", \"mean\": " << h.mean() << ", \"p50\": " << h.percentile(0.5)
+                << ", \"p90\": " << h.percentile(0.9) << ", \"p99\": " << h.percentile(0.99)
+                << ", \"p999\": " << h.percentile(0.999) << ", \"max\": " << h.max() << "}"
+                << ", \"other_host_samples\": " << outputs[i].other_host << "}";
+        }
+        os << "\n]}\n";
+        return os.str();
+    }
+}
@@ -0,0 +1,305 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <boost/serialization/extended_type_info_typeid.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/split_member.hpp>
+
+namespace dj {
+
+    /**
+     * Histogram with buckets growing exponentially and linearly divided inside,
+     * every value is recorded with relative error below 1/sub_buckets (as in HdrHistogram)
+     */
+    class latency_histogram {
+
+        public:
+            static const uint sub_buckets = 16;
+
+            latency_histogram();
+
+            void record(uint64_t value);
+            void merge(const latency_histogram& other);
+
+            uint64_t count() const;
+            uint64_t min() const;
+            uint64_t max() const;
+            double mean() const;
+            /**
+             * @param p from [0, 1]
+             * @return the smallest value of bucket below which p of recorded values are (maximum for the last one)
+             */
+            uint64_t percentile(double p) const;
+
+        private:
+            static uint bucket(uint64_t value);
+            static uint64_t lowest(uint bucket);
+
+            std::vector<uint64_t> buckets;
+            uint64_t _count = 0;
+            uint64_t _min = std::numeric_limits<uint64_t>::max();
+            uint64_t _max = 0;
+            double sum = 0;
+
+            friend class boost::serialization::access;
+            template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                ar & buckets;
+                ar & _count;
+                ar & _min;
+                ar & _max;
+                ar & sum;
+            }
+    };
+
+    /**
+     * Counters of a node, written only by the thread computing work of the node
+     */
+    struct node_metrics {
+        std::string type;
+        std::string name;
+        uint index = 0;
+
+        uint64_t records_in = 0;
+        uint64_t records_out = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t deserialization_ns = 0;
+        uint64_t handler_ns = 0;
+        latency_histogram process_ns; // whole process_work call
+
+        void merge(const node_metrics& other);
+
+        private:
+            friend class boost::serialization::access;
+            template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                ar & type;
+                ar & name;
+                ar & index;
+                ar & records_in;
+                ar & records_out;
+                ar & bytes_in;
+                ar & bytes_out;
+                ar & deserialization_ns;
+                ar & handler_ns;
+                ar & process_ns;
+            }
+    };
+
+    class metrics_registry {
+
+        public:
+            /**
+             * @return counters of the node kept for the lifetime of registry
+             */
+            node_metrics* add(std::string type, std::string name, uint index);
+
+            /**
+             * Adds counters of nodes of other process, nodes are matched by type and index
+             */
+            void merge(const metrics_registry& other);
+
+            /**
+             * Time spent in phase over all passes, phase is index of ecomputation_phase
+             */
+            void add_phase_time(uint phase, uint64_t ns);
+            uint64_t phase_time(uint phase) const;
+            /**
+             * Peak resident memory of process, merged registry keeps the largest one
+             */
+            void set_peak_rss(uint64_t kb);
+            uint64_t peak_rss() const;
+            /**
+             * Time producers were held back by flow control - input thread waiting for room
+             * in the queue of input and this process keeping its input while out of credits
+             */
+            void add_input_stall(uint64_t ns);
+            uint64_t input_stall() const;
+            void add_credit_stall(uint64_t ns);
+            uint64_t credit_stall() const;
+
+            /**
+             * @param ranks number of processes merged into this registry
+             */
+            std::string to_json(int rank, int ranks) const;
+
+            void clear();
+
+        private:
+            std::vector<std::unique_ptr<node_metrics>> nodes;
+            std::vector<uint64_t> phase_ns = std::vector<uint64_t>(4, 0); // merged as maximum of processes
+            uint64_t peak_rss_kb = 0;
+            uint64_t input_stall_ns = 0; // merged as maximum of processes
+            uint64_t credit_stall_ns = 0;
+
+            friend class boost::serialization::access;
+            template<class Archive> void save(Archive& ar, const unsigned int /* version */) const {
+                uint size = nodes.size();
+                ar & size;
+                for(auto& n: nodes) ar & *n;
+                ar & phase_ns;
+                ar & peak_rss_kb;
+                ar & input_stall_ns;
+                ar & credit_stall_ns;
+            }
+            template<class Archive> void load(Archive& ar, const unsigned int /* version */) {
+                uint size;
+                ar & size;
+                nodes.clear();
+                for(uint i = 0; i < size; i++) {
+                    nodes.emplace_back(new node_metrics());
+                    ar & *nodes.back();
+                }
+                ar & phase_ns;
+                ar & peak_rss_kb;
+                ar & input_stall_ns;
+                ar & credit_stall_ns;
+            }
+            BOOST_SERIALIZATION_SPLIT_MEMBER()
+    };
+
+    /**
+     * Messages and bytes of work exchanged between processes for each (source, destination, work type)
+     * in every pass, and sizes of messages sent to each destination. Every process fills only its own
+     * row (sent) and column (received), merged matrix has all of them.
+     */
+    class traffic_matrix {
+
+        public:
+            /**
+             * Clears everything, first pass is open
+             */
+            void reset(uint rank, uint ranks);
+
+            void record_sent(uint to, int work_type, uint64_t bytes);
+            void record_received(uint from, int work_type, uint64_t bytes);
+            /**
+             * Closes the current pass, following messages are counted in the next one
+             */
+            void end_pass();
+            uint passes() const;
+
+            uint64_t sent_messages(uint pass, uint from, uint to) const;
+            uint64_t sent_bytes(uint pass, uint from, uint to) const;
+            const latency_histogram& message_sizes(uint from, uint to) const;
+
+            /**
+             * Adds rows and columns of other process, passes are matched by number
+             */
+            void merge(const traffic_matrix& other);
+            std::string to_json() const;
+
+        private:
+            struct counts {
+                uint64_t messages = 0;
+                uint64_t bytes = 0;
+
+                template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                    ar & messages;
+                    ar & bytes;
+                }
+            };
+
+            struct pass_counts {
+                // index of (from, to, work type) is (from*ranks + to)*work_types + work type
+                std::vector<counts> sent;
+                std::vector<counts> received;
+
+                template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                    ar & sent;
+                    ar & received;
+                }
+            };
+
+            uint cell(uint from, uint to, int work_type) const;
+            pass_counts empty_pass() const;
+
+            uint rank = 0;
+            uint ranks = 0;
+            std::vector<pass_counts> _passes; // the last one is open
+            std::vector<latency_histogram> sizes; // for (from*ranks + to)
+
+            friend class boost::serialization::access;
+            template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                ar & rank;
+                ar & ranks;
+                ar & _passes;
+                ar & sizes;
+            }
+    };
+
+    /**
+     * Samples one of every n input records, monotonic time of its input travels with everything
+     * emitted for it and latency is recorded when it reaches an output node. Monotonic clocks
+     * of different machines cannot be compared, so records reaching output on another machine
+     * than they were sampled on are only counted. Records are sampled by input thread
+     * and latencies recorded by computing thread.
+     */
+    class latency_sampler {
+
+        public:
+            /**
+             * @param every one of this many input records is sampled, 0 turns sampling off
+             */
+            void reset(uint every);
+            void add_output(uint index, std::string name);
+
+            /**
+             * @return origin of the next input record, 0 if it is not sampled
+             */
+            uint64_t sample();
+            /**
+             * @return id of the machine of this process, sampled records carry it with their origin
+             */
+            uint64_t host() const;
+            void record(uint output, uint64_t origin, uint64_t origin_host);
+            const latency_histogram& latencies(uint output) const;
+            /**
+             * @return sampled records which reached the output on another machine, their latency is unknown
+             */
+            uint64_t other_host_samples(uint output) const;
+
+            /**
+             * Monotonic clock shared by processes of one machine, in nanoseconds
+             */
+            static uint64_t now();
+
+            void merge(const latency_sampler& other);
+            std::string to_json(int rank, int ranks) const;
+
+        private:
+            struct output_latency {
+                uint index = 0;
+                std::string name;
+                latency_histogram ns;
+                uint64_t other_host = 0;
+
+                template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                    ar & index;
+                    ar & name;
+                    ar & ns;
+                    ar & other_host;
+                }
+            };
+
+            output_latency& output(uint index);
+
+            uint every = 0;
+            uint until_sample = 0;
+            uint64_t this_host = 0;
+            std::vector<output_latency> outputs;
+
+            friend class boost::serialization::access;
+            template<class Archive> void serialize(Archive& ar, const unsigned int /* version */) {
+                ar & every;
+                ar & outputs;
+            }
+    };
+}
+
+#endif
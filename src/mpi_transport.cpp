@@ -0,0 +1,385 @@
+#include "mpi_transport.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <boost/mpi/collectives.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+namespace mpi = boost::mpi;
+
+namespace dj {
+
+    namespace exec {
+
+        namespace {
+            const uint world_channel = 0;
+            const uint express_channel = 1;
+
+            MPI_Op mpi_op(ereduce_op op) {
+                return (op == ereduce_op::SUM) ? MPI_SUM : MPI_MAX;
+            }
+        }
+
+        // progress thread makes MPI calls while the main thread does not
+        mpi_transport::mpi_transport()
+            : env(mpi::threading::serialized),
+            collectives(world, mpi::comm_duplicate),
+            express(world, mpi::comm_duplicate)
+        {
+            comms[world_channel] = &world;
+            comms[express_channel] = &express;
+            inbox[world_channel] = &world_inbox;
+            inbox[express_channel] = &express_inbox;
+            if(const char* enabled = std::getenv("DJ_SHM")) shared_memory = std::string(enabled) != "0";
+            if(const char* size = std::getenv("DJ_SHM_RING")) ring_size = std::stoul(size);
+            if(const char* enabled = std::getenv("DJ_PROGRESS_THREAD")) set_progress_thread(std::string(enabled) != "0");
+        }
+
+        mpi_transport::~mpi_transport() {
+            finish();
+            outgoing* out;
+            while(outbox.pop(out)) delete out;
+            while(spare_outgoing.pop(out)) delete out;
+            envelope* mes;
+            for(auto queue: inbox) while(queue->pop(mes)) delete mes;
+            while(spare_envelopes.pop(mes)) delete mes;
+        }
+
+        uint mpi_transport::rank() const {
+            return world.rank();
+        }
+
+        uint mpi_transport::size() const {
+            return world.size();
+        }
+
+        /**
+         * Host name given in arguments is not trusted, segment is shared by processes of one machine
+         */
+        void mpi_transport::start() {
+            if(!shared_memory) shm.close();
+            if(shared_memory && !shm.is_open() && size() > 1 
+                    && shm.open(collectives, mpi::environment::processor_name(), channels_count, ring_size)) {
+                diverted.assign(channels_count, std::vector<bool>(size(), false));
+                on_ring.assign(channels_count, std::vector<bool>(size(), true));
+                for(auto& channel: early) channel = std::vector<std::deque<message>>(size());
+            }
+            if(use_progress_thread && !progress_thread) {
+                running = true;
+                progress_thread.reset(new std::thread(&mpi_transport::progress, this));
+            }
+        }
+
+        /**
+         * Progress thread hands everything queued to MPI before it stops, then sends are completed
+         */
+        void mpi_transport::finish() {
+            if(progress_thread) {
+                running = false;
+                progress_thread->join();
+                progress_thread.reset();
+            }
+            for(auto& request: in_flight) request.wait();
+            in_flight.clear();
+        }
+
+        void mpi_transport::set_shared_memory(bool enabled, std::size_t ring_size) {
+            shared_memory = enabled;
+            this->ring_size = ring_size;
+        }
+
+        void mpi_transport::set_progress_thread(bool enabled) {
+            if(enabled && mpi::environment::thread_level() < mpi::threading::serialized) {
+                std::cerr << "MPI does not support calls from other threads, progress thread is not used" << std::endl;
+                enabled = false;
+            }
+            use_progress_thread = enabled;
+        }
+
+        void mpi_transport::send(uint to, int tag, const std::string& data, bool urgent) {
+            if(!progress_thread) return send_now(to, tag, data, urgent);
+            outgoing* out;
+            if(!spare_outgoing.pop(out)) out = new outgoing;
+            out->to = to;
+            out->tag = tag;
+            out->data.assign(data);
+            out->urgent = urgent;
+            outbox.push(out);
+        }
+
+        bool mpi_transport::receive(envelope& mes) {
+            if(!progress_thread) {
+                for(uint channel: { express_channel, world_channel }) if(receive_now(channel, mes)) return true;
+                return false;
+            }
+            envelope* next;
+            for(uint channel: { express_channel, world_channel }) {
+                if(!inbox[channel]->pop(next)) continue;
+                std::swap(mes, *next);
+                spare_envelopes.push(next);
+                return true;
+            }
+            // nothing comes until progress thread gets its turn
+            std::this_thread::yield();
+            return false;
+        }
+
+        /**
+         * Message for other process of this host goes to its ring, when the ring is full a switch
+         * tells the reader to continue with MPI and another switch sent through MPI brings it back
+         */
+        void mpi_transport::send_now(uint to, int tag, const std::string& data, bool urgent) {
+            complete_sends();
+            uint channel = urgent ? express_channel : world_channel;
+            mpi::communicator& comm = *comms[channel];
+            if(shm.local(to)) {
+                shm_ring& ring = shm.to(channel, to);
+                if(diverted[channel][to] && ring.fits(data.size())) {
+                    in_flight.push_back(comm.isend(to, ring_switch_tag, std::string()));
+                    diverted[channel][to] = false;
+                }
+                if(!diverted[channel][to]) {
+                    if(ring.write(tag, data.data(), data.size())) return;
+                    ring.write_switch();
+                    diverted[channel][to] = true;
+                    if(trace) trace->instant("mpi", "ring full", "to", to);
+                }
+            }
+            // data is packed right away, request keeps the copy
+            in_flight.push_back(comm.isend(to, tag, data));
+        }
+
+        /**
+         * Sends are posted in order, so they mostly complete in order as well
+         */
+        void mpi_transport::complete_sends() {
+            while(!in_flight.empty() && in_flight.front().test()) in_flight.pop_front();
+        }
+
+        bool mpi_transport::receive_now(uint channel, envelope& mes) {
+            complete_sends();
+            mes.has_work = false;
+            mes.urgent = channel == express_channel;
+            while(true) {
+                if(receive_from_rings(channel, mes)) return true;
+                if(!pending[channel]) {
+                    buffers[channel].clear();
+                    requests[channel] = comms[channel]->irecv(mpi::any_source, mpi::any_tag, buffers[channel]);
+                    pending[channel] = true;
+                }
+                boost::optional<mpi::status> status = requests[channel].test();
+                if(!status) return false;
+                pending[channel] = false;
+                if(accept(channel, status->source(), status->tag(), mes)) return true;
+            }
+        }
+
+        /**
+         * Takes one message from rings of other processes of this host, in turns
+         */
+        bool mpi_transport::receive_from_rings(uint channel, envelope& mes) {
+            if(!shm.is_open()) return false;
+            const std::vector<uint>& peers = shm.peers();
+            for(uint i = 0; i < peers.size(); i++) {
+                if(!take_from_ring(channel, peers[(ring_turn + i) % peers.size()], mes)) continue;
+                ring_turn = (ring_turn + i + 1) % peers.size();
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Ring is read up to its switch, then messages which came through MPI meanwhile up to theirs
+         */
+        bool mpi_transport::take_from_ring(uint channel, uint from, envelope& mes) {
+            auto& waiting = early[channel][from];
+            while(true) {
+                if(on_ring[channel][from]) {
+                    if(!shm.from(channel, from).read(mes.tag, mes.data)) return false;
+                    if(mes.tag != ring_switch_tag) break;
+                    on_ring[channel][from] = false;
+                } else {
+                    if(waiting.empty()) return false;
+                    message next = std::move(waiting.front());
+                    waiting.pop_front();
+                    if(next.tag == ring_switch_tag) {
+                        on_ring[channel][from] = true;
+                        continue;
+                    }
+                    mes.tag = next.tag;
+                    mes.data = std::move(next.data);
+                    break;
+                }
+            }
+            mes.source = from;
+            return true;
+        }
+
+        /**
+         * Message of other process of this host waits until its ring is read up to the switch
+         * @return false if message is not to be received yet
+         */
+        bool mpi_transport::accept(uint channel, int source, int tag, envelope& mes) {
+            std::string& data = buffers[channel];
+            if(shm.local(source)) {
+                if(on_ring[channel][source] || !early[channel][source].empty()) {
+                    early[channel][source].emplace_back(tag, std::move(data));
+                    return false;
+                }
+                if(tag == ring_switch_tag) {
+                    on_ring[channel][source] = true;
+                    return false;
+                }
+            }
+            mes.source = source;
+            mes.tag = tag;
+            mes.data = std::move(data);
+            return true;
+        }
+
+        void mpi_transport::barrier() {
+            collective call;
+            call.kind = collective::ekind::BARRIER;
+            complete(call);
+        }
+
+        void mpi_transport::all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) {
+            collective call;
+            call.kind = collective::ekind::ALL_REDUCE;
+            call.local = local;
+            call.global = global;
+            call.count = count;
+            call.op = op;
+            complete(call);
+        }
+
+        void mpi_transport::start_all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) {
+            reduction.kind = collective::ekind::ALL_REDUCE;
+            reduction.local = local;
+            reduction.global = global;
+            reduction.count = count;
+            reduction.op = op;
+            reduction.done = false;
+            if(progress_thread) calls.push(&reduction);
+            else begin(reduction);
+        }
+
+        bool mpi_transport::all_reduce_done() {
+            if(progress_thread) return reduction.done.load(std::memory_order_acquire);
+            return advance(reduction);
+        }
+
+        std::string mpi_transport::all_reduce(const std::string& data, const data_combiner& combine) {
+            collective call;
+            call.kind = collective::ekind::ALL_REDUCE_DATA;
+            call.data = &data;
+            call.combine = &combine;
+            complete(call);
+            return std::move(call.reduced);
+        }
+
+        std::vector<std::string> mpi_transport::gather(const std::string& data) {
+            collective call;
+            call.kind = collective::ekind::GATHER;
+            call.data = &data;
+            complete(call);
+            return std::move(call.all);
+        }
+
+        std::vector<std::string> mpi_transport::all_gather(const std::string& data) {
+            collective call;
+            call.kind = collective::ekind::ALL_GATHER;
+            call.data = &data;
+            complete(call);
+            return std::move(call.all);
+        }
+
+        /**
+         * Reductions and barriers are non blocking, so that progress thread keeps receiving meanwhile
+         */
+        void mpi_transport::begin(collective& call) {
+            switch(call.kind) {
+                case collective::ekind::BARRIER:
+                    MPI_Ibarrier((MPI_Comm) world, &call.request);
+                    break;
+                case collective::ekind::ALL_REDUCE:
+                    MPI_Iallreduce(call.local, call.global, call.count, MPI_UINT64_T, mpi_op(call.op), 
+                            (MPI_Comm) collectives, &call.request);
+                    break;
+                case collective::ekind::ALL_REDUCE_DATA:
+                    // combine is not commutative, reduction tree keeps order of ranks
+                    mpi::all_reduce(collectives, *call.data, call.reduced, *call.combine);
+                    break;
+                case collective::ekind::GATHER:
+                    mpi::gather(collectives, *call.data, call.all, 0);
+                    break;
+                case collective::ekind::ALL_GATHER:
+                    mpi::all_gather(collectives, *call.data, call.all);
+                    break;
+            }
+        }
+
+        /**
+         * @return true once the collective is completed
+         */
+        bool mpi_transport::advance(collective& call) {
+            if(call.kind == collective::ekind::ALL_REDUCE_DATA || call.kind == collective::ekind::GATHER 
+                    || call.kind == collective::ekind::ALL_GATHER) return true;
+            int done = 0;
+            MPI_Test(&call.request, &done, MPI_STATUS_IGNORE);
+            return done;
+        }
+
+        /**
+         * Waits for collective made by this thread or by progress thread
+         */
+        void mpi_transport::complete(collective& call) {
+            if(progress_thread) {
+                calls.push(&call);
+                while(!call.done.load(std::memory_order_acquire)) std::this_thread::yield();
+                return;
+            }
+            begin(call);
+            while(!advance(call)) { }
+        }
+
+        /**
+         * Sends what computing thread queued, receives into its inbox and makes collectives in order
+         * they were requested. Yields when there is nothing to do.
+         */
+        void mpi_transport::progress() {
+            if(trace) trace->set_thread_name("mpi progress");
+            collective* current = nullptr;
+            while(true) {
+                bool busy = false;
+                outgoing* out;
+                while(outbox.pop(out)) {
+                    send_now(out->to, out->tag, out->data, out->urgent);
+                    spare_outgoing.push(out);
+                    busy = true;
+                }
+                for(uint channel: { express_channel, world_channel }) {
+                    envelope* mes;
+                    if(!spare_envelopes.pop(mes)) mes = new envelope;
+                    while(receive_now(channel, *mes)) {
+                        inbox[channel]->push(mes);
+                        if(!spare_envelopes.pop(mes)) mes = new envelope;
+                        busy = true;
+                    }
+                    spare_envelopes.push(mes);
+                }
+                if(!current && calls.pop(current)) begin(*current);
+                if(current && advance(*current)) {
+                    current->done.store(true, std::memory_order_release);
+                    current = nullptr;
+                    busy = true;
+                }
+                if(!busy) {
+                    if(!running && !current && outbox.empty() && calls.empty()) break;
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef MPI_TRANSPORT_HPP
+#define MPI_TRANSPORT_HPP
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <boost/mpi.hpp>
+#include <boost/lockfree/queue.hpp>
+#include "transport.hpp"
+#include "shm.hpp"
+
+namespace dj {
+
+    namespace exec {
+
+        /**
+         * Every rank is a process of MPI world. Processes on the same host send messages through rings
+         * in shared memory and use MPI only while a ring is full, see set_shared_memory.
+         * DJ_SHM and DJ_SHM_RING environment variables set it as well.
+         * With progress thread all MPI calls are made by it, see set_progress_thread.
+         */
+        class mpi_transport : public transport {
+
+            public:
+                mpi_transport();
+                ~mpi_transport();
+
+                uint rank() const override;
+                uint size() const override;
+
+                void start() override;
+                void finish() override;
+                void set_shared_memory(bool enabled, std::size_t ring_size) override;
+                void set_progress_thread(bool enabled) override;
+
+                void send(uint to, int tag, const std::string& data, bool urgent) override;
+                bool receive(envelope& mes) override;
+
+                void barrier() override;
+                void all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) override;
+                void start_all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) override;
+                bool all_reduce_done() override;
+                std::string all_reduce(const std::string& data, const data_combiner& combine) override;
+                std::vector<std::string> gather(const std::string& data) override;
+                std::vector<std::string> all_gather(const std::string& data) override;
+
+            private:
+                static const uint channels_count = 2; // world and express
+
+                struct outgoing {
+                    uint to;
+                    int tag;
+                    std::string data;
+                    bool urgent;
+                };
+
+                /**
+                 * Collective handed over to progress thread, done is set once it completed
+                 */
+                struct collective {
+                    enum class ekind { BARRIER, ALL_REDUCE, ALL_REDUCE_DATA, GATHER, ALL_GATHER };
+
+                    ekind kind;
+                    const uint64_t* local = nullptr;
+                    uint64_t* global = nullptr;
+                    uint count = 0;
+                    ereduce_op op = ereduce_op::SUM;
+                    const std::string* data = nullptr;
+                    const data_combiner* combine = nullptr;
+                    std::string reduced;
+                    std::vector<std::string> all;
+                    MPI_Request request;
+                    std::atomic<bool> done{ false };
+                };
+
+                void send_now(uint to, int tag, const std::string& data, bool urgent);
+                void complete_sends();
+                bool receive_now(uint channel, envelope& mes);
+                bool receive_from_rings(uint channel, envelope& mes);
+                bool take_from_ring(uint channel, uint from, envelope& mes);
+                bool accept(uint channel, int source, int tag, envelope& mes);
+                void begin(collective& call);
+                bool advance(collective& call);
+                void complete(collective& call);
+                void progress();
+
+                boost::mpi::environment env;
+                boost::mpi::communicator world;
+                // collectives have their own communicator, so that messages they use
+                // are never received as work
+                boost::mpi::communicator collectives;
+                // urgent messages, received before others
+                boost::mpi::communicator express;
+                boost::mpi::communicator* comms[channels_count];
+
+                // sends are not blocking, so that large messages never wait for the receiver
+                std::deque<boost::mpi::request> in_flight;
+                boost::mpi::request requests[channels_count];
+                bool pending[channels_count] = { false, false };
+                std::string buffers[channels_count];
+                collective reduction; // of start_all_reduce
+
+                // rings to processes of the same host, indexed by [channel][rank]
+                bool shared_memory = true;
+                std::size_t ring_size = 1 << 18;
+                shm_transport shm;
+                std::vector<std::vector<bool>> diverted; // sent through MPI until the ring has room
+                std::vector<std::vector<bool>> on_ring; // read from the ring until its switch
+                std::vector<std::deque<message>> early[channels_count]; // came through MPI before switch of the ring
+                uint ring_turn = 0;
+
+                // progress thread and queues between it and the computing thread, messages are recycled
+                bool use_progress_thread = false;
+                std::unique_ptr<std::thread> progress_thread;
+                std::atomic<bool> running{ false };
+                boost::lockfree::queue<outgoing*> outbox{ 1024 };
+                boost::lockfree::queue<outgoing*> spare_outgoing{ 1024 };
+                boost::lockfree::queue<envelope*> world_inbox{ 1024 };
+                boost::lockfree::queue<envelope*> express_inbox{ 1024 };
+                boost::lockfree::queue<envelope*>* inbox[channels_count];
+                boost::lockfree::queue<envelope*> spare_envelopes{ 1024 };
+                boost::lockfree::queue<collective*> calls{ 16 };
+        };
+    }
+}
+
+#endif
@@ -27,6 +27,14 @@ namespace dj {
         return _name;
     }
 
+    void base_node::set_metrics(node_metrics* metrics) {
+        _metrics = metrics;
+    }
+
+    node_metrics* base_node::metrics() const {
+        return _metrics;
+    }
+
     // --- task_node -----------------
     task_node::task_node(std::string name)
         : base_node(enode_type::TASK, std::move(name))
@@ -189,7 +197,7 @@ namespace dj {
 
         auto tp = std::make_pair(enode_type::TASK, task_index);
         if(sink_map.find(tp) == end(sink_map)) {
-            sink_map[tp] = std::make_pair(enode_type::COORDINATOR, output_index);
+            sink_map[tp] = std::make_pair(enode_type::OUTPUT, output_index);
         } else 
             throw node_exception("End of task is already connected");
     }
@@ -241,6 +249,12 @@ namespace dj {
         task_nodes[task_to]->add_coordinator(coordinator_index, coordinator_nodes[coordinator_index].get());
     }
 
+    std::pair<enode_type, uint> node_graph::sink(enode_type type, uint index) const {
+        auto it = sink_map.find(std::make_pair(type, index));
+        if(it == end(sink_map)) throw node_exception("Node is not connected to reducer or output");
+        return it->second;
+    }
+
     int node_graph::set_root(std::unique_ptr<task_node> node) {
         return root_index = add(std::move(node));
     }
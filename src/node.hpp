@@ -6,9 +6,11 @@
 #include <memory>
 #include <unordered_map>
 #include <exception>
+#include <chrono>
 
 #include "template_utils.hpp"
 #include "message.hpp"
+#include "metrics.hpp"
 
 
 namespace dj {
@@ -85,15 +87,56 @@ namespace dj {
 
             virtual void process_work(const work_unit& work, base_node* parent) = 0;
             virtual void handle_finish() = 0;
+            /**
+             * No record with lower event time will be delivered anymore
+             */
+            virtual void advance_watermark(uint64_t watermark) = 0;
+            virtual uint64_t late_records() const = 0;
             virtual void set_executor(exec::executor* processor) = 0;
             virtual void set_index(int index) = 0;
             virtual int index() const = 0;
 
+            /**
+             * @param metrics counters of this node, nullptr turns recording off
+             */
+            void set_metrics(node_metrics* metrics);
+            node_metrics* metrics() const;
+
+            /**
+             * Deserializes input of the node, time it takes is recorded in metrics
+             */
+            template <typename T>
+                void deserialize(const payload& data, T& t) const {
+                    using serialization::operator>>;
+                    if(_metrics == nullptr) {
+                        data >> t;
+                        return;
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    data >> t;
+                    _metrics->deserialization_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+                }
+
+            /**
+             * Deserializes chunk of records, see serialization::read_chunk
+             */
+            template <typename T>
+                span<const T> deserialize_chunk(const payload& data, std::vector<T>& buffer) const {
+                    if(_metrics == nullptr) return serialization::read_chunk(data, buffer);
+                    auto start = std::chrono::steady_clock::now();
+                    span<const T> records = serialization::read_chunk(data, buffer);
+                    _metrics->deserialization_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+                    return records;
+                }
+
             const enode_type type;
 
         private:
 
             std::string _name;
+            node_metrics* _metrics = nullptr;
     };
 
     class coordinator_node;
@@ -190,6 +233,12 @@ namespace dj {
             void add_directed(uint task_from, uint task_to);
             void add_coordinator(uint coordinator_index, uint task_to);
 
+            /**
+             * @return reducer or output connected to the end of task or reducer
+             * @throws node_exception if none is connected
+             */
+            std::pair<enode_type, uint> sink(enode_type type, uint index) const;
+
             int set_root(std::unique_ptr<task_node> node);
             void set_root(uint index);
             bool has_root() const;
@@ -234,6 +283,22 @@ namespace dj {
             std::unordered_map<std::pair<enode_type, uint>, std::pair<enode_type, uint>> sink_map;
     };
 
+    /**
+     * True if Task takes whole chunks of T - has operator()(span<const T>, const std::string&)
+     */
+    template <typename Task, typename T>
+        struct takes_chunks {
+
+            template <typename U>
+                static auto test(int) -> decltype(std::declval<U&>()(std::declval<span<const T>>(), 
+                            std::declval<const std::string&>()), std::true_type());
+
+            template <typename>
+                static std::false_type test(...);
+
+            static const bool value = decltype(test<Task>(0))::value;
+        };
+
     template <typename, typename...>
         class task { };
 
@@ -276,19 +341,38 @@ namespace dj {
             template <typename T>
                 struct type_checker {
 
-                        bool operator()(const work_unit& work, base_node* parent, Task<OutputParameters...>& task) const {
-                            using serialization::operator>>;
+                        bool operator()(const work_unit& work, base_node* parent, 
+                                Task<OutputParameters...>& task, const base_node* self) const {
 
-                            if(work.type_name != typeid(T).name()) 
+                            if(!same_type_name(work.type_name, typeid(T).name())) 
                                 return false;
 
+                            std::string from = (parent != nullptr) ? parent->name() : "";
+                            if(work.chunk) {
+                                // records stay in the buffer, so that it keeps its memory from chunk to chunk
+                                static thread_local std::vector<T> buffer;
+                                deliver(self->deserialize_chunk(work.data, buffer), from, task, 
+                                        std::integral_constant<bool, takes_chunks<Task<OutputParameters...>, T>::value>());
+                                return true;
+                            }
+
                             T t;
-                            work.data >> t;
-                            if(parent != nullptr) task(t, parent->name());
-                            else task(t, "");
+                            self->deserialize(work.data, t);
+                            task(t, from);
 
                             return true;
                         }
+
+                        void deliver(span<const T> records, const std::string& from, 
+                                Task<OutputParameters...>& task, std::true_type) const {
+                            task(records, from);
+                        }
+
+                        // task takes records one by one
+                        void deliver(span<const T> records, const std::string& from, 
+                                Task<OutputParameters...>& task, std::false_type) const {
+                            for(const T& record: records) task(record, from);
+                        }
                 };
 
             public:
@@ -312,11 +396,22 @@ namespace dj {
                 }
 
                 virtual void handle_finish() {
+                    _task.close_all_windows();
+                    _task.set_origin(0); // results of the whole pass
                     _task.handle_finish();
                 }
 
+                virtual void advance_watermark(uint64_t watermark) {
+                    _task.advance_watermark(watermark);
+                }
+
+                virtual uint64_t late_records() const {
+                    return _task.late_records();
+                }
+
                 virtual void process_work(const work_unit& work, base_node* parent) {
-                    if(!for_each_any<type_checker, InputParameters...>::run(work, parent, _task))
+                    if(!_task.accept_record(work)) return; // late for all windows
+                    if(!for_each_any<type_checker, InputParameters...>::run(work, parent, _task, this))
                             throw std::runtime_error("Input for task is not any of given types");
                 }
 
@@ -374,23 +469,32 @@ namespace dj {
                 }
 
                 virtual void handle_finish() {
+                    _coordinator.close_all_windows();
+                    _coordinator.set_origin(0); // results of the whole pass
                     _coordinator.handle_finish();
                 }
 
+                virtual void advance_watermark(uint64_t watermark) {
+                    _coordinator.advance_watermark(watermark);
+                }
+
+                virtual uint64_t late_records() const {
+                    return _coordinator.late_records();
+                }
+
                 template <typename... Args>
                     void initialize_coorindator(Args&& ...args) {
                         _coordinator.initialize(std::forward<Args>(args)...);
                     }
 
                 virtual void process_work(const work_unit& work, base_node* parent) {
-                    using serialization::operator>>;
-
-                    if(work.type_name != typeid(CoordinatorInput).name()) 
+                    if(!same_type_name(work.type_name, typeid(CoordinatorInput).name())) 
                         throw std::runtime_error(
                                 std::string("Input for coordinator is not of type: ") + typeid(CoordinatorInput).name());
+                    if(!_coordinator.accept_record(work)) return; // late for all windows
 
                     CoordinatorInput  work_data;
-                    work.data >> work_data;
+                    deserialize(work.data, work_data);
 
                     _coordinator.coordinate(work_data, parent->name());
                 }
@@ -438,29 +542,39 @@ namespace dj {
                 }
 
                 virtual void handle_finish() {
+                    _reducer.close_all_windows();
+                    _reducer.set_origin(0); // results of the whole pass
                     _reducer.handle_finish();
                 }
 
-                virtual void process_work(const work_unit& work, base_node* parent) {
-                    using serialization::operator>>;
+                virtual void advance_watermark(uint64_t watermark) {
+                    _reducer.advance_watermark(watermark);
+                }
 
-                    if(work.type_name != typeid(ReducerInput).name() && work.type_name != typeid(ReducerOutput).name()) 
+                virtual uint64_t late_records() const {
+                    return _reducer.late_records();
+                }
+
+                virtual void process_work(const work_unit& work, base_node* parent) {
+                    if(!same_type_name(work.type_name, typeid(ReducerInput).name()) 
+                            && !same_type_name(work.type_name, typeid(ReducerOutput).name())) 
                         throw std::runtime_error(
                                 std::string("Input for reducer is not of type: ") + typeid(ReducerInput).name());
+                    if(!_reducer.accept_record(work)) return; // late for all windows
 
                     switch(work.work_type) {
 
                         case work_unit::ework_type::REDUCER_REDUCE:
                             {
                                 ReducerInput reduce_data;
-                                work.data >> reduce_data;
+                                deserialize(work.data, reduce_data);
                                 _reducer.reduce(reduce_data, parent->name());
                             }
                             break;
                         case work_unit::ework_type::REDUCER_COLLECT:
                             {
                                 ReducerOutput collect_data;
-                                work.data >> collect_data;
+                                deserialize(work.data, collect_data);
                                 _reducer.collect(collect_data);
                             }
                             break;
@@ -522,18 +636,27 @@ namespace dj {
                     }
 
                 virtual void handle_finish() {
+                    _outputer.close_all_windows();
+                    _outputer.set_origin(0); // results of the whole pass
                     _outputer.handle_finish();
                 }
 
-                virtual void process_work(const work_unit& work, base_node* parent) {
-                    using serialization::operator>>;
+                virtual void advance_watermark(uint64_t watermark) {
+                    _outputer.advance_watermark(watermark);
+                }
 
-                    if(work.type_name != typeid(OutputerInput).name()) 
+                virtual uint64_t late_records() const {
+                    return _outputer.late_records();
+                }
+
+                virtual void process_work(const work_unit& work, base_node* parent) {
+                    if(!same_type_name(work.type_name, typeid(OutputerInput).name())) 
                         throw std::runtime_error(
                                 std::string("Input for outputer is not of type: ") + typeid(OutputerInput).name());
+                    if(!_outputer.accept_record(work)) return; // late for all windows
 
                     OutputerInput  work_data;
-                    work.data >> work_data;
+                    deserialize(work.data, work_data);
                     _outputer(work_data, parent->name());
                 }
 
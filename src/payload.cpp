@@ -0,0 +1,117 @@
+#include "payload.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace dj {
+
+    payload::payload(const char* data, std::size_t size) {
+        assign(data, size);
+    }
+
+    payload::payload(const std::string& data) {
+        assign(data.data(), data.size());
+    }
+
+    payload::payload(const payload& other) {
+        assign(other.data(), other.size());
+    }
+
+    payload::payload(payload&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    payload::~payload() {
+        delete[] heap;
+    }
+
+    payload& payload::operator=(const payload& other) {
+        if(this != &other) assign(other.data(), other.size());
+        return *this;
+    }
+
+    payload& payload::operator=(payload&& other) noexcept {
+        if(this == &other) return *this;
+        // heap buffers are exchanged, so that none is freed
+        std::swap(heap, other.heap);
+        std::swap(heap_capacity, other.heap_capacity);
+        _size = other._size;
+        if(_size <= inline_capacity) std::memcpy(local, other.local, _size);
+        other._size = 0;
+        return *this;
+    }
+
+    payload& payload::operator=(const std::string& data) {
+        assign(data.data(), data.size());
+        return *this;
+    }
+
+    payload& payload::operator=(std::initializer_list<char> data) {
+        assign(data.begin(), data.size());
+        return *this;
+    }
+
+    void payload::assign(const char* data, std::size_t size) {
+        std::memmove(prepare(size), data, size);
+    }
+
+    char* payload::prepare(std::size_t size) {
+        if(size > inline_capacity && size > heap_capacity) {
+            delete[] heap;
+            heap = nullptr; // in case new throws
+            heap_capacity = 0;
+            heap = new char[size];
+            heap_capacity = size;
+        }
+        _size = size;
+        return (size <= inline_capacity) ? local : heap;
+    }
+
+    void payload::clear() {
+        _size = 0;
+    }
+
+    const char* payload::data() const {
+        return (_size <= inline_capacity) ? local : heap;
+    }
+
+    std::size_t payload::size() const {
+        return _size;
+    }
+
+    bool payload::empty() const {
+        return _size == 0;
+    }
+
+    bool payload::on_heap() const {
+        return _size > inline_capacity;
+    }
+
+    char payload::operator[](std::size_t i) const {
+        return data()[i];
+    }
+
+    std::string payload::str() const {
+        return std::string(data(), _size);
+    }
+
+    bool operator==(const payload& p1, const payload& p2) {
+        return p1.size() == p2.size() && std::memcmp(p1.data(), p2.data(), p1.size()) == 0;
+    }
+
+    bool operator==(const payload& p, const std::string& s) {
+        return p.size() == s.size() && std::memcmp(p.data(), s.data(), s.size()) == 0;
+    }
+
+    bool operator==(const std::string& s, const payload& p) {
+        return p == s;
+    }
+
+    bool operator!=(const payload& p1, const payload& p2) {
+        return !(p1 == p2);
+    }
+
+    std::ostream& operator<<(std::ostream& os, const payload& p) {
+        return os.write(p.data(), p.size());
+    }
+}
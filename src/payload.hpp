@@ -0,0 +1,64 @@
+#ifndef PAYLOAD_HPP
+#define PAYLOAD_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+
+namespace dj {
+
+    /**
+     * Serialized data of work. Small payloads (scalars and small structs) are kept inline,
+     * larger ones on the heap. Heap buffer is kept when payload shrinks, so recycled
+     * work reuses it.
+     */
+    class payload {
+
+        public:
+            static const std::size_t inline_capacity = 32;
+
+            payload() = default;
+            payload(const char* data, std::size_t size);
+            explicit payload(const std::string& data);
+            payload(const payload& other);
+            payload(payload&& other) noexcept;
+            ~payload();
+
+            payload& operator=(const payload& other);
+            payload& operator=(payload&& other) noexcept;
+            payload& operator=(const std::string& data);
+            payload& operator=(std::initializer_list<char> data);
+
+            void assign(const char* data, std::size_t size);
+            /**
+             * @return storage for size bytes to be written, previous content is not kept
+             */
+            char* prepare(std::size_t size);
+            void clear();
+
+            const char* data() const;
+            std::size_t size() const;
+            bool empty() const;
+            /**
+             * @return true if payload is kept on heap
+             */
+            bool on_heap() const;
+            char operator[](std::size_t i) const;
+            std::string str() const;
+
+        private:
+            std::size_t _size = 0;
+            std::size_t heap_capacity = 0;
+            char* heap = nullptr;
+            char local[inline_capacity];
+    };
+
+    bool operator==(const payload& p1, const payload& p2);
+    bool operator==(const payload& p, const std::string& s);
+    bool operator==(const std::string& s, const payload& p);
+    bool operator!=(const payload& p1, const payload& p2);
+    std::ostream& operator<<(std::ostream& os, const payload& p);
+}
+
+#endif
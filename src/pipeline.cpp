@@ -1,5 +1,7 @@
 #include "pipeline.hpp"
 
+#include <algorithm>
+
 namespace dj {
 
     void input_provider::set_executor(exec::executor* processor) {
@@ -10,6 +12,29 @@ namespace dj {
         this->eof_callback = eof_callback;
     }
 
+    void input_provider::set_watermarks(uint64_t lateness, uint interval) {
+        watermarks = true;
+        this->lateness = lateness;
+        this->interval = std::max(interval, 1u);
+    }
+
+    bool input_provider::emits_watermarks() const {
+        return watermarks;
+    }
+
+    void input_provider::emit_watermark(uint64_t watermark) {
+        if(!watermarks || watermark <= last_watermark) return;
+        last_watermark = watermark;
+        processor->enqueue_watermark(watermark);
+    }
+
+    void input_provider::track_event_time(uint64_t event_time) {
+        max_event_time = std::max(max_event_time, event_time);
+        if(++since_watermark < interval) return;
+        since_watermark = 0;
+        if(max_event_time > lateness) emit_watermark(max_event_time - lateness);
+    }
+
     execution_pipeline::execution_pipeline() 
     : _inputer(new input::single_stdin_input<int>()) 
     { }
@@ -31,5 +56,9 @@ namespace dj {
         return nodes;
     }
 
+    aggregator_registry& execution_pipeline::get_aggregators() {
+        return aggregators;
+    }
+
 }
 
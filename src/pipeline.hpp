@@ -5,6 +5,7 @@
 #include <fstream>
 #include "node.hpp"
 #include "executor.hpp"
+#include "aggregator.hpp"
 
 namespace dj {
 
@@ -23,6 +24,14 @@ namespace dj {
             void set_executor(exec::executor* processor);
             void set_eof_callback(std::function<void()> eof_callback);
 
+            /**
+             * Records are followed by watermarks - the largest event time added so far minus lateness,
+             * emitted after every interval records and at the end of input.
+             * Windows are then closed by watermarks only. Has to be set before start.
+             */
+            void set_watermarks(uint64_t lateness, uint interval = 64);
+            bool emits_watermarks() const;
+
         protected:
             exec::executor* processor = nullptr;
 
@@ -31,7 +40,84 @@ namespace dj {
                     processor->enqueue_input(input);
                 }
 
+            /**
+             * @param event_time time the record happened at, in milliseconds by convention
+             */
+            template <typename InputType>
+                void add_input(const InputType& input, uint64_t event_time) {
+                    processor->enqueue_input(input, event_time);
+                    if(watermarks) track_event_time(event_time);
+                }
+
+            /**
+             * Records are handed over as one chunk, root task gets them at once if it has
+             * operator()(span<const InputType>, const std::string&), one by one otherwise
+             */
+            template <typename InputType>
+                void add_inputs(span<const InputType> inputs) {
+                    processor->enqueue_inputs(inputs);
+                }
+
+            template <typename InputType>
+                void add_inputs(const std::vector<InputType>& inputs) {
+                    add_inputs(span<const InputType>(inputs));
+                }
+
+            /**
+             * Chunk of records already serialized by serialization::write_chunk, its bytes are handed
+             * over as they are (see record_file_input)
+             */
+            template <typename InputType>
+                void add_chunk(const char* chunk, std::size_t size) {
+                    processor->enqueue_chunk<InputType>(chunk, size, context_info::get_current_timestamp());
+                }
+
+            /**
+             * Chunk goes to root task of given process instead of this one. Records of other processes
+             * have no watermarks, so windows there may close before they come.
+             */
+            template <typename InputType>
+                void add_inputs_to(uint rank, span<const InputType> inputs) {
+                    processor->enqueue_inputs_to(rank, inputs, context_info::get_current_timestamp());
+                }
+
+            template <typename InputType>
+                void add_inputs_to(uint rank, const std::vector<InputType>& inputs) {
+                    add_inputs_to(rank, span<const InputType>(inputs));
+                }
+
+            /**
+             * @param event_time time all records of the chunk happened at
+             */
+            template <typename InputType>
+                void add_inputs(span<const InputType> inputs, uint64_t event_time) {
+                    if(inputs.empty()) return;
+                    processor->enqueue_inputs(inputs, event_time);
+                    if(watermarks) track_event_time(event_time);
+                }
+
+            template <typename InputType>
+                void add_inputs(const std::vector<InputType>& inputs, uint64_t event_time) {
+                    add_inputs(span<const InputType>(inputs), event_time);
+                }
+
+            /**
+             * Promises that no record with lower event time will be added,
+             * ignored unless watermarks are set
+             */
+            void emit_watermark(uint64_t watermark);
+
             std::function<void()> eof_callback;
+
+        private:
+            void track_event_time(uint64_t event_time);
+
+            bool watermarks = false;
+            uint64_t lateness = 0;
+            uint interval = 0;
+            uint since_watermark = 0;
+            uint64_t max_event_time = 0;
+            uint64_t last_watermark = 0;
     };
 
     namespace input {
@@ -92,9 +178,11 @@ namespace dj {
 
             input_provider& get_input_provider();
             node_graph& get_node_graph();
+            aggregator_registry& get_aggregators();
 
         private:
             node_graph nodes;
+            aggregator_registry aggregators;
             std::unique_ptr<input_provider> _inputer;
 
     };
@@ -0,0 +1,71 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <boost/lockfree/stack.hpp>
+
+namespace dj {
+
+    /**
+     * Pool of objects reused instead of being deleted. Released objects keep their state,
+     * so strings and containers in them keep their memory and filling them again
+     * does not allocate while it fits. Objects can be acquired and released by any thread,
+     * at most capacity of them are kept and the pool itself never allocates after construction.
+     */
+    template <typename T>
+        class object_pool {
+
+            public:
+                struct deleter {
+                    object_pool* pool;
+                    void operator()(T* t) const { pool->release(t); }
+                };
+
+                typedef std::unique_ptr<T, deleter> pointer;
+
+                object_pool(std::size_t capacity = 1024) : free(capacity) { }
+                object_pool(const object_pool& other) = delete;
+                object_pool& operator=(const object_pool& other) = delete;
+
+                ~object_pool() {
+                    T* t;
+                    while(free.pop(t)) delete t;
+                }
+
+                /**
+                 * @return released object in the state it was left in or a new one
+                 */
+                T* acquire() {
+                    T* t;
+                    if(free.pop(t)) return t;
+                    return new T();
+                }
+
+                /**
+                 * Object is deleted when pool is full
+                 */
+                void release(T* t) {
+                    if(t != nullptr && !free.bounded_push(t)) delete t;
+                }
+
+                /**
+                 * @return acquired object released back to pool when pointer is destroyed
+                 */
+                pointer make() {
+                    return wrap(acquire());
+                }
+
+                /**
+                 * Released back to pool when pointer is destroyed
+                 */
+                pointer wrap(T* t) {
+                    return pointer(t, deleter{ this });
+                }
+
+            private:
+                boost::lockfree::stack<T*, boost::lockfree::fixed_sized<true>> free;
+        };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "record_file.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace dj {
+
+    namespace {
+        const char record_magic[8] = { 'D', 'J', 'R', 'E', 'C', 'O', 'R', 'D' };
+        const uint32_t record_version = 1;
+    }
+
+    /**
+     * FNV-1a, the same on every machine
+     */
+    uint64_t record_type_id(const std::string& schema) {
+        uint64_t hash = 14695981039346656037ull;
+        for(unsigned char c: schema) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    record_file::record_file(const std::string& filename, const std::string& schema,
+            erecord_layout layout, uint32_t record_size)
+        : filename(filename), file(filename)
+    {
+        if(file.size() < sizeof(_header)) fail("is too short for a header");
+        std::memcpy(&_header, file.data(), sizeof(_header));
+        if(std::memcmp(_header.magic, record_magic, sizeof(record_magic)) != 0) fail("is not a record file");
+        if(_header.byte_order != 1) fail("was written on a machine of other byte order");
+        if(_header.version != record_version) fail("has unknown version " + std::to_string(_header.version));
+        if(_header.data_offset > file.size() || _header.data_offset < sizeof(_header) 
+                || _header.schema_size > _header.data_offset - sizeof(_header)
+                || _header.data_offset % record_file_alignment != 0)
+            fail("has broken header");
+
+        std::string stored(file.data() + sizeof(_header), _header.schema_size);
+        if(stored != schema || _header.type_id != record_type_id(schema))
+            fail("holds records of " + stored + ", not of " + schema);
+        if(_header.layout != static_cast<uint32_t>(layout) || _header.record_size != record_size)
+            fail("has records of other layout or size");
+
+        if(layout == erecord_layout::BLOCKS) read_blocks();
+        else if(size() != _header.records*_header.record_size) fail("is truncated or was not closed");
+    }
+
+    const record_file_header& record_file::header() const {
+        return _header;
+    }
+
+    const char* record_file::data() const {
+        return file.data() + _header.data_offset;
+    }
+
+    std::size_t record_file::size() const {
+        return file.size() - _header.data_offset;
+    }
+
+    const std::vector<byte_range>& record_file::blocks() const {
+        return _blocks;
+    }
+
+    /**
+     * Finds blocks by their lengths, records of all of them have to add up to count in header
+     */
+    void record_file::read_blocks() {
+        uint64_t records = 0;
+        std::size_t at = 0;
+        while(at < size()) {
+            uint64_t length, count;
+            if(size() - at < sizeof(length)) fail("is truncated");
+            std::memcpy(&length, data() + at, sizeof(length));
+            at += sizeof(length);
+            if(length > size() - at || length < sizeof(count)) fail("is truncated");
+            std::memcpy(&count, data() + at, sizeof(count));
+            _blocks.push_back({ at, at + length });
+            records += count;
+            at += length;
+        }
+        if(records != _header.records) fail("is truncated or was not closed");
+    }
+
+    void record_file::fail(const std::string& reason) const {
+        throw std::runtime_error("Record file " + filename + " " + reason);
+    }
+
+    raw_record_writer::raw_record_writer(const std::string& filename, const std::string& schema,
+            erecord_layout layout, uint32_t record_size)
+        : filename(filename), out(filename, std::ios::binary | std::ios::trunc)
+    {
+        if(!out) throw std::runtime_error("Cannot create " + filename);
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, record_magic, sizeof(record_magic));
+        header.version = record_version;
+        header.byte_order = 1;
+        header.layout = static_cast<uint32_t>(layout);
+        header.record_size = record_size;
+        header.type_id = record_type_id(schema);
+        header.schema_size = schema.size();
+        std::size_t end = sizeof(header) + schema.size();
+        header.data_offset = (end + record_file_alignment - 1)/record_file_alignment*record_file_alignment;
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(schema.data(), schema.size());
+        std::vector<char> padding(header.data_offset - end, 0);
+        out.write(padding.data(), padding.size());
+    }
+
+    raw_record_writer::~raw_record_writer() {
+        try {
+            flush();
+        } catch(std::exception&) { }
+    }
+
+    void raw_record_writer::write(const char* data, std::size_t size, uint64_t records) {
+        out.write(data, size);
+        header.records += records;
+    }
+
+    /**
+     * Count of records is written into header in place, writing goes on at the end
+     */
+    void raw_record_writer::flush() {
+        out.seekp(offsetof(record_file_header, records));
+        out.write(reinterpret_cast<const char*>(&header.records), sizeof(header.records));
+        out.seekp(0, std::ios::end);
+        out.flush();
+        if(!out) throw std::runtime_error("Cannot write " + filename);
+    }
+}
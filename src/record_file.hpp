@@ -0,0 +1,281 @@
+#ifndef RECORD_FILE_HPP
+#define RECORD_FILE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include "file_input.hpp"
+#include "message.hpp"
+#include "pipeline.hpp"
+#include "task.hpp"
+
+namespace dj {
+
+    /**
+     * Bitwise records (see serialization::is_bitwise) are kept as their bytes one after another,
+     * other ones in blocks - byte length of the block followed by a chunk (see serialization::write_chunk)
+     */
+    enum class erecord_layout : uint32_t { FIXED = 1, BLOCKS = 2 };
+
+    /**
+     * Record file starts with header and schema, records begin at data_offset,
+     * which is aligned to record_file_alignment
+     */
+    struct record_file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order; // 1 as written by the machine which wrote the file
+        uint32_t layout;
+        uint32_t record_size; // of fixed records, 0 for blocks
+        uint64_t type_id; // hash of schema
+        uint64_t records;
+        uint64_t schema_size;
+        uint64_t data_offset;
+    };
+
+    const std::size_t record_file_alignment = 64;
+
+    /**
+     * Description of record type kept in file header, files are read only as the type of the same schema.
+     * Name of the type given by compiler by default, specialize it to share files between programs
+     * or compilers.
+     */
+    template <typename T>
+        struct record_schema {
+            static std::string name() {
+                return typeid(T).name();
+            }
+        };
+
+    uint64_t record_type_id(const std::string& schema);
+
+    template <typename T>
+        erecord_layout record_layout() {
+            return serialization::is_bitwise<T>::value ? erecord_layout::FIXED : erecord_layout::BLOCKS;
+        }
+
+    template <typename T>
+        uint32_t record_size() {
+            return serialization::is_bitwise<T>::value ? sizeof(T) : 0;
+        }
+
+    /**
+     * Record file mapped into memory, header is checked when it is opened
+     */
+    class record_file {
+
+        public:
+            /**
+             * @throws runtime_error if file is not a complete record file of given schema and layout
+             */
+            record_file(const std::string& filename, const std::string& schema,
+                    erecord_layout layout, uint32_t record_size);
+
+            const record_file_header& header() const;
+            /**
+             * @return beginning of records
+             */
+            const char* data() const;
+            /**
+             * @return bytes of records
+             */
+            std::size_t size() const;
+            /**
+             * @return chunks of blocks layout, relative to data
+             */
+            const std::vector<byte_range>& blocks() const;
+
+        private:
+            void read_blocks();
+            [[noreturn]] void fail(const std::string& reason) const;
+
+            std::string filename;
+            mapped_file file;
+            record_file_header _header;
+            std::vector<byte_range> _blocks;
+    };
+
+    /**
+     * Writes header and records, count of records in header is updated by flush
+     */
+    class raw_record_writer {
+
+        public:
+            /**
+             * @throws runtime_error if file cannot be created
+             */
+            raw_record_writer(const std::string& filename, const std::string& schema,
+                    erecord_layout layout, uint32_t record_size);
+            raw_record_writer(const raw_record_writer&) = delete;
+            raw_record_writer& operator=(const raw_record_writer&) = delete;
+            ~raw_record_writer();
+
+            void write(const char* data, std::size_t size, uint64_t records);
+            /**
+             * @throws runtime_error if file cannot be written
+             */
+            void flush();
+
+        private:
+            std::string filename;
+            std::ofstream out;
+            record_file_header header;
+    };
+
+    /**
+     * Writes records of type T, records of blocks layout are kept until block_size of them is written
+     */
+    template <typename T>
+        class record_writer {
+
+            static_assert(alignof(T) <= record_file_alignment, "records would not be aligned in file");
+
+            public:
+                explicit record_writer(const std::string& filename, uint block_size = 1024)
+                    : out(filename, record_schema<T>::name(), record_layout<T>(), record_size<T>()),
+                    block_size(std::max(block_size, 1u))
+                { }
+
+                ~record_writer() {
+                    try {
+                        flush();
+                    } catch(std::exception&) { }
+                }
+
+                void write(const T& record) {
+                    write(span<const T>(&record, 1));
+                }
+
+                void write(span<const T> records) {
+                    write(records, serialization::is_bitwise<T>());
+                }
+
+                void write(const std::vector<T>& records) {
+                    write(span<const T>(records));
+                }
+
+                /**
+                 * Writes block which is not full yet and updates header
+                 */
+                void flush() {
+                    write_block();
+                    out.flush();
+                }
+
+            private:
+                void write(span<const T> records, std::true_type /* bitwise */) {
+                    out.write(reinterpret_cast<const char*>(records.data()), records.size()*sizeof(T), records.size());
+                }
+
+                void write(span<const T> records, std::false_type /* bitwise */) {
+                    for(auto& record: records) {
+                        block.push_back(record);
+                        if(block.size() >= block_size) write_block();
+                    }
+                }
+
+                void write_block() {
+                    if(block.empty()) return;
+                    payload chunk;
+                    serialization::write_chunk(chunk, block.data(), block.size());
+                    uint64_t length = chunk.size();
+                    out.write(reinterpret_cast<const char*>(&length), sizeof(length), 0);
+                    out.write(chunk.data(), chunk.size(), block.size());
+                    block.clear();
+                }
+
+                raw_record_writer out;
+                uint block_size;
+                std::vector<T> block;
+        };
+
+    /**
+     * Writes records it gets into a record file. With more processes every one writes its own file,
+     * with its rank appended to the name. Records are flushed at the end of every pass.
+     */
+    template <typename T>
+        class record_file_outputer : public base_outputer<T> {
+
+            public:
+                record_file_outputer() : base_outputer<T>("record_file_outputer") { }
+
+                void initialize(std::string filename) {
+                    this->filename = std::move(filename);
+                }
+
+                virtual void operator()(const T& input, const std::string& /* parent */) override {
+                    if(!writer) {
+                        std::string name = filename;
+                        if(this->world_size() > 1) name += "." + std::to_string(this->rank());
+                        writer.reset(new record_writer<T>(name));
+                    }
+                    writer->write(input);
+                }
+
+                virtual void handle_finish() override {
+                    if(writer) writer->flush();
+                }
+
+            private:
+                std::string filename = "output.rec";
+                std::unique_ptr<record_writer<T>> writer;
+        };
+
+    namespace input {
+
+        /**
+         * Every process maps every file and takes its share of records - a range of fixed records
+         * or every size-th block. Nothing is parsed: fixed records are copied straight from the mapping
+         * into chunks, blocks are handed over as chunks they hold, and root task taking
+         * span<const T> reads bitwise records in place.
+         */
+        template <typename T>
+            class record_file_input : public input_provider {
+
+                public:
+                    /**
+                     * @param chunk_size fixed records added at once, blocks keep their size
+                     */
+                    record_file_input(std::vector<std::string> filenames, uint chunk_size = 1024)
+                        : filenames(std::move(filenames)), chunk_size(std::max(chunk_size, 1u))
+                    { }
+
+                    virtual void operator()() override {
+                        context_info context = processor->context();
+                        for(auto& filename: filenames) {
+                            record_file file(filename, record_schema<T>::name(), record_layout<T>(), record_size<T>());
+                            read(file, context.rank, context.size, serialization::is_bitwise<T>());
+                        }
+                        eof_callback();
+                    }
+
+                private:
+                    void read(const record_file& file, uint part, uint parts, std::true_type /* bitwise */) {
+                        const T* records = reinterpret_cast<const T*>(file.data());
+                        uint64_t count = file.header().records;
+                        uint64_t end = count*(part + 1)/parts;
+                        for(uint64_t i = count*part/parts; i < end; i += chunk_size) {
+                            add_inputs(span<const T>(records + i, std::min<uint64_t>(chunk_size, end - i)));
+                        }
+                    }
+
+                    void read(const record_file& file, uint part, uint parts, std::false_type /* bitwise */) {
+                        const std::vector<byte_range>& blocks = file.blocks();
+                        for(std::size_t i = part; i < blocks.size(); i += parts) {
+                            add_chunk<T>(file.data() + blocks[i].begin, blocks[i].end - blocks[i].begin);
+                        }
+                    }
+
+                    std::vector<std::string> filenames;
+                    uint chunk_size;
+            };
+    }
+}
+
+#endif
@@ -0,0 +1,152 @@
+#!/bin/bash
+#
+# Strong and weak scaling of example pipelines on local ranks.
+#
+# usage: scaling.sh <examples bin dir> <output dir> [max ranks]
+#
+# Environment:
+#   MPIRUN         launcher with its options (default: mpirun --oversubscribe)
+#   BFS_SIZES      vertices of map_reduce_bfs graphs for strong scaling (default: 2000 8000)
+#   ADD_SIZES      numbers in every complex_add file (default: 20000 80000)
+#   TRIANGLE_SIZES vertices of graph_stream_triangle_count graphs (default: 60 120)
+#   REPEAT         runs of every configuration, the fastest one is kept (default: 1)
+#
+# Weak scaling uses the first size of every example per rank. Every run is done with
+# DJ_METRICS and DJ_TRAFFIC, results are in <output dir>/results.csv and tables of speedup
+# and efficiency in <output dir>/tables.txt.
+
+set -u
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <examples bin dir> <output dir> [max ranks]" >&2
+    exit 1
+fi
+
+BIN=$(cd "$1" && pwd)
+OUT=$2
+MAX_RANKS=${3:-$(nproc)}
+MPIRUN=${MPIRUN:-mpirun --oversubscribe}
+BFS_SIZES=${BFS_SIZES:-2000 8000}
+ADD_SIZES=${ADD_SIZES:-20000 80000}
+TRIANGLE_SIZES=${TRIANGLE_SIZES:-60 120}
+REPEAT=${REPEAT:-1}
+
+mkdir -p "$OUT/inputs" "$OUT/runs"
+OUT=$(cd "$OUT" && pwd)
+RESULTS=$OUT/results.csv
+TABLES=$OUT/tables.txt
+
+# 1, 2, 4, ... and max ranks
+RANKS=""
+for (( r = 1; r < MAX_RANKS; r *= 2 )); do RANKS="$RANKS $r"; done
+RANKS="$RANKS $MAX_RANKS"
+
+# inputs are generated once for every size
+
+bfs_input() { # vertices
+    local file=$OUT/inputs/bfs_$1
+    [ -f "$file" ] || "$BIN/graph_generator" "$1" $(( 4*$1 )) "$file" > "$file.expected"
+    echo "$file"
+}
+
+add_input() { # numbers, files
+    local dir=$OUT/inputs/add_$1_$2
+    if [ ! -d "$dir" ]; then
+        mkdir -p "$dir"
+        for (( f = 1; f <= $2; f++ )); do
+            awk -v n="$1" -v seed="$f" 'BEGIN { srand(seed); for(i = 0; i < n; i++) print int(rand()*100) }' > "$dir/in$f"
+        done
+    fi
+    echo "$dir"
+}
+
+triangle_input() { # vertices, files
+    local dir=$OUT/inputs/triangle_$1_$2
+    if [ ! -d "$dir" ]; then
+        mkdir -p "$dir"
+        (cd "$dir" && "$BIN/graph_generate" "$1" "$2" > expected)
+    fi
+    echo "$dir"
+}
+
+# runs example and appends a row to results
+# run <example> <scaling> <size> <ranks> <input dir or file> <args...>
+run() {
+    local example=$1 scaling=$2 size=$3 ranks=$4 input=$5
+    shift 5
+    local dir=$OUT/runs/${example}_${scaling}_${size}_${ranks}
+    mkdir -p "$dir"
+
+    local best="" status=ok
+    for (( i = 0; i < REPEAT; i++ )); do
+        local start=$(date +%s%N)
+        if [ -f "$input" ]; then
+            (cd "$dir" && DJ_METRICS=$dir/metrics DJ_TRAFFIC=$dir/traffic \
+                $MPIRUN -np "$ranks" "$BIN/$example" "$@" < "$input" > out 2> err)
+        else
+            (cd "$input" && DJ_METRICS=$dir/metrics DJ_TRAFFIC=$dir/traffic \
+                $MPIRUN -np "$ranks" "$BIN/$example" "$@" > "$dir/out" 2> "$dir/err")
+        fi
+        if [ $? -ne 0 ]; then status=failed; break; fi
+        local ms=$(( ($(date +%s%N) - start)/1000000 ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then best=$ms; fi
+    done
+
+    local metrics=$dir/metrics.json traffic=$dir/traffic.json
+    if [ "$status" = ok ] && [ -f "$metrics" ] && [ -f "$traffic" ]; then
+        # phases and memory are maxima over ranks, messages and bytes are sums of sent ones
+        local phases=$(grep -o '"phase_ns": {[^}]*}' "$metrics" | grep -o '[0-9]\+' | awk '{ printf "%s%.3f", (NR > 1 ? "," : ""), $1/1e6 }')
+        local rss=$(grep -o '"peak_rss_kb": [0-9]\+' "$metrics" | grep -o '[0-9]\+$')
+        local messages=$(grep -o '"sent_messages": [0-9]\+' "$traffic" | awk '{ s += $2 } END { print s+0 }')
+        local bytes=$(grep -o '"sent_bytes": [0-9]\+' "$traffic" | awk '{ s += $2 } END { print s+0 }')
+        echo "$example,$scaling,$size,$ranks,$best,$phases,$rss,$messages,$bytes,ok" >> "$RESULTS"
+    else
+        echo "$example,$scaling,$size,$ranks,,,,,,,,,failed" >> "$RESULTS"
+    fi
+    echo "$example $scaling size $size ranks $ranks: ${best:-} ms $status" >&2
+}
+
+echo "example,scaling,size,ranks,wall_ms,tasks_ms,reduction_ms,pipe_end_ms,work_end_ms,peak_rss_kb,messages,bytes,status" > "$RESULTS"
+
+for r in $RANKS; do
+    for n in $BFS_SIZES; do
+        run map_reduce_bfs strong "$n" "$r" "$(bfs_input "$n")"
+    done
+    for n in $ADD_SIZES; do
+        dir=$(add_input "$n" "$MAX_RANKS")
+        run complex_add strong "$n" "$r" "$dir" $(cd "$dir" && ls)
+    done
+    for n in $TRIANGLE_SIZES; do
+        dir=$(triangle_input "$n" "$MAX_RANKS")
+        run graph_stream_triangle_count strong "$n" "$r" "$dir" $(cd "$dir" && ls edges_*)
+    done
+
+    # work grows with ranks
+    n=$(( $(echo $BFS_SIZES | cut -d' ' -f1)*r ))
+    run map_reduce_bfs weak "$n" "$r" "$(bfs_input "$n")"
+    n=$(echo $ADD_SIZES | cut -d' ' -f1)
+    dir=$(add_input "$n" "$r")
+    run complex_add weak "$n" "$r" "$dir" $(cd "$dir" && ls)
+    n=$(echo $TRIANGLE_SIZES | cut -d' ' -f1)
+    dir=$(triangle_input "$n" "$r")
+    run graph_stream_triangle_count weak "$n" "$r" "$dir" $(cd "$dir" && ls edges_*)
+done
+
+# speedup is relative to the fewest ranks that succeeded, for weak scaling efficiency is t(base)/t(ranks)
+tail -n +2 "$RESULTS" | awk -F, -v OFS=, '{ print ($2 == "strong") ? $3 : 0, $0 }' |
+    sort -t, -k2,2 -k3,3 -k1,1n -k5,5n | cut -d, -f2- | awk -F, '
+    {
+        # size of weak scaling grows with ranks
+        key = ($2 == "strong") ? $1 " " $2 " size " $3 : $1 " " $2
+        if(key != last) {
+            printf "\n%s\n%6s %8s %10s %10s %10s %10s %10s %12s %12s %8s %10s\n", key, "ranks", "size",
+                "wall ms", "tasks ms", "reduce ms", "end ms", "rss kb", "messages", "bytes", "speedup", "efficiency"
+            last = key; base = 0
+        }
+        if($13 != "ok") { printf "%6s %8s %10s\n", $4, $3, "failed"; next }
+        if(base == 0) { base = $5; base_ranks = $4 }
+        speedup = ($5 > 0) ? base/$5 : 0
+        efficiency = ($2 == "strong") ? speedup*base_ranks/$4 : speedup
+        printf "%6d %8d %10d %10.1f %10.1f %10.1f %10d %12d %12d %8.2f %10.2f\n",
+            $4, $3, $5, $6, $7, $8 + $9, $10, $11, $12, ($2 == "strong") ? speedup : 1, efficiency
+    }' | tee "$TABLES"
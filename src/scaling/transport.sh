@@ -0,0 +1,45 @@
+#!/bin/bash
+#
+# Shared memory rings against plain MPI for example pipelines on local ranks.
+#
+# usage: transport.sh <examples bin dir> <output dir> [max ranks]
+#
+# Runs scaling.sh with DJ_SHM=0 into <output dir>/mpi and with DJ_SHM=1 into <output dir>/shm,
+# both on the same inputs and with the same environment (see scaling.sh). Wall times of both
+# and speedup of rings are in <output dir>/transport.txt.
+
+set -u
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <examples bin dir> <output dir> [max ranks]" >&2
+    exit 1
+fi
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+OUT=$2
+mkdir -p "$OUT/mpi/inputs" "$OUT/shm"
+OUT=$(cd "$OUT" && pwd)
+[ -e "$OUT/shm/inputs" ] || ln -s "$OUT/mpi/inputs" "$OUT/shm/inputs"
+
+DJ_SHM=0 "$HERE/scaling.sh" "$1" "$OUT/mpi" ${3:-} > /dev/null || exit 1
+DJ_SHM=1 "$HERE/scaling.sh" "$1" "$OUT/shm" ${3:-} > /dev/null || exit 1
+
+# rows of both runs are joined by example, scaling, size and ranks
+awk -F, '
+    FNR == 1 { next }
+    {
+        key = $1 "," $2 "," $3 "," $4
+        wall = ($13 == "ok") ? $5 : ""
+        if(FILENAME ~ /\/mpi\//) { mpi[key] = wall; order[++n] = key } else shm[key] = wall
+    }
+    END {
+        printf "%-28s %7s %8s %6s %10s %10s %8s\n", "example", "scaling", "size", "ranks", "mpi ms", "shm ms", "speedup"
+        for(i = 1; i <= n; i++) {
+            key = order[i]
+            split(key, k, ",")
+            m = mpi[key]; s = shm[key]
+            speedup = (m != "" && s != "" && s > 0) ? sprintf("%.2f", m/s) : "-"
+            printf "%-28s %7s %8s %6s %10s %10s %8s\n", k[1], k[2], k[3], k[4],
+                (m == "") ? "failed" : m, (s == "") ? "failed" : s, speedup
+        }
+    }' "$OUT/mpi/results.csv" "$OUT/shm/results.csv" | tee "$OUT/transport.txt"
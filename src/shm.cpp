@@ -0,0 +1,217 @@
+#include "shm.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/mpi/collectives.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/utility.hpp>
+
+namespace mpi = boost::mpi;
+
+namespace dj {
+
+    namespace {
+        const std::size_t record_header = 8; // size and tag
+        const std::size_t switch_size = record_header;
+
+        std::size_t align(std::size_t size, std::size_t to) {
+            return (size + to - 1) / to * to;
+        }
+    }
+
+    std::size_t shm_ring::footprint(std::size_t capacity) {
+        return sizeof(header) + align(capacity, alignof(header));
+    }
+
+    void shm_ring::create(void* at, std::size_t capacity) {
+        header* ends = new (at) header;
+        ends->head.store(0, std::memory_order_relaxed);
+        ends->tail.store(0, std::memory_order_relaxed);
+        ends->capacity = align(capacity, alignof(header));
+    }
+
+    /**
+     * Processes mapping the ring have to agree on its layout, e.g. on DJ_SHM_RING
+     */
+    shm_ring::shm_ring(void* at, std::size_t capacity)
+        : ends(static_cast<header*>(at)), data(static_cast<char*>(at) + sizeof(header)),
+          capacity(align(capacity, alignof(header)))
+    {
+        if(ends->capacity != this->capacity)
+            throw std::runtime_error("Shared memory ring of " + std::to_string(ends->capacity) 
+                    + " bytes used as one of " + std::to_string(this->capacity));
+    }
+
+    std::size_t shm_ring::record_size(std::size_t size) {
+        return record_header + align(size, 8);
+    }
+
+    bool shm_ring::fits(std::size_t size) const {
+        uint64_t used = ends->head.load(std::memory_order_relaxed) - ends->tail.load(std::memory_order_acquire);
+        return used + record_size(size) + switch_size <= capacity;
+    }
+
+    bool shm_ring::write(int tag, const char* data, std::size_t size) {
+        if(size > UINT32_MAX || !fits(size)) return false;
+        uint64_t head = ends->head.load(std::memory_order_relaxed);
+        uint32_t size32 = size;
+        int32_t tag32 = tag;
+        copy_in(head, &size32, sizeof(size32));
+        copy_in(head + sizeof(size32), &tag32, sizeof(tag32));
+        copy_in(head + record_header, data, size);
+        ends->head.store(head + record_size(size), std::memory_order_release);
+        return true;
+    }
+
+    void shm_ring::write_switch() {
+        // there is always room for it
+        uint64_t head = ends->head.load(std::memory_order_relaxed);
+        uint32_t size32 = 0;
+        int32_t tag32 = ring_switch_tag;
+        copy_in(head, &size32, sizeof(size32));
+        copy_in(head + sizeof(size32), &tag32, sizeof(tag32));
+        ends->head.store(head + switch_size, std::memory_order_release);
+    }
+
+    bool shm_ring::read(int& tag, std::string& data) {
+        uint64_t tail = ends->tail.load(std::memory_order_relaxed);
+        if(ends->head.load(std::memory_order_acquire) == tail) return false;
+        uint32_t size32;
+        int32_t tag32;
+        copy_out(tail, &size32, sizeof(size32));
+        copy_out(tail + sizeof(size32), &tag32, sizeof(tag32));
+        tag = tag32;
+        data.resize(size32);
+        if(size32 > 0) copy_out(tail + record_header, &data[0], size32);
+        ends->tail.store(tail + record_size(size32), std::memory_order_release);
+        return true;
+    }
+
+    void shm_ring::copy_in(uint64_t at, const void* from, std::size_t size) {
+        std::size_t offset = at % capacity;
+        std::size_t first = std::min(size, capacity - offset);
+        std::memcpy(data + offset, from, first);
+        std::memcpy(data, static_cast<const char*>(from) + first, size - first);
+    }
+
+    void shm_ring::copy_out(uint64_t at, void* to, std::size_t size) const {
+        std::size_t offset = at % capacity;
+        std::size_t first = std::min(size, capacity - offset);
+        std::memcpy(to, data + offset, first);
+        std::memcpy(static_cast<char*>(to) + first, data, size - first);
+    }
+
+    shm_transport::~shm_transport() {
+        close();
+    }
+
+    bool shm_transport::open(const mpi::communicator& comm, const std::string& host, uint channels, std::size_t ring_size) {
+        close();
+        std::vector<std::pair<std::string, long>> hosts;
+        mpi::all_gather(comm, std::make_pair(host, static_cast<long>(getpid())), hosts);
+
+        rank = comm.rank();
+        local_index.assign(comm.size(), -1);
+        uint leader = rank;
+        for(uint i = 0; i < hosts.size(); i++) {
+            if(hosts[i].first != host) continue;
+            local_index[i] = locals++;
+            leader = std::min(leader, i);
+            if(i != rank) _peers.push_back(i);
+        }
+
+        std::size_t stride = shm_ring::footprint(ring_size);
+        segment_size = stride * channels * locals * locals;
+        std::string name = "/dj-" + std::to_string(hosts[leader].second) + "-" + std::to_string(leader);
+
+        // leader creates and fills the segment before the others map it, it is unlinked once all have it,
+        // segment of other size is not mapped - touching pages past its end would kill the process
+        std::size_t found = segment_size;
+        auto map = [&](int flags) {
+            int fd = shm_open(name.c_str(), flags, 0600);
+            if(fd == -1) return false;
+            struct stat st;
+            if(!(flags & O_CREAT) && fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) != segment_size) {
+                found = st.st_size;
+                ::close(fd);
+                return false;
+            }
+            bool sized = !(flags & O_CREAT) || ftruncate(fd, segment_size) == 0;
+            void* at = sized ? mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+            ::close(fd);
+            if(at == MAP_FAILED) return false;
+            segment = at;
+            return true;
+        };
+        bool alone = locals < 2;
+        bool ok = alone || rank != leader || map(O_CREAT | O_EXCL | O_RDWR);
+        if(ok && !alone && rank == leader) {
+            for(std::size_t offset = 0; offset < segment_size; offset += stride) {
+                shm_ring::create(static_cast<char*>(segment) + offset, ring_size);
+            }
+        }
+        ok = mpi::all_reduce(comm, ok, std::logical_and<bool>());
+        if(ok && !alone && rank != leader) ok = map(O_RDWR);
+        // 1 if some process could not map the segment, 2 if processes differ in its size
+        int state = (found != segment_size) ? 2 : !ok;
+        state = mpi::all_reduce(comm, state, mpi::maximum<int>());
+        if(!alone && rank == leader) shm_unlink(name.c_str());
+        if(state == 2) {
+            std::string error = (found != segment_size)
+                ? "Shared memory segment of " + std::to_string(found) + " bytes mapped as one of " + std::to_string(segment_size)
+                : "Shared memory segment mapped with other size by another process";
+            close();
+            throw std::runtime_error(error + ", DJ_SHM_RING differs between processes");
+        }
+        ok = state == 0;
+
+        if(!ok || alone) {
+            close();
+            return false;
+        }
+        for(std::size_t offset = 0; offset < segment_size; offset += stride) {
+            rings.emplace_back(static_cast<char*>(segment) + offset, ring_size);
+        }
+        return true;
+    }
+
+    void shm_transport::close() {
+        if(segment) munmap(segment, segment_size);
+        segment = nullptr;
+        segment_size = 0;
+        local_index.clear();
+        _peers.clear();
+        locals = 0;
+        rings.clear();
+    }
+
+    bool shm_transport::is_open() const {
+        return segment != nullptr;
+    }
+
+    bool shm_transport::local(int rank) const {
+        return is_open() && rank >= 0 && rank < static_cast<int>(local_index.size()) && local_index[rank] != -1 && static_cast<uint>(rank) != this->rank;
+    }
+
+    const std::vector<uint>& shm_transport::peers() const {
+        return _peers;
+    }
+
+    shm_ring& shm_transport::to(uint channel, uint rank) {
+        return ring(channel, this->rank, rank);
+    }
+
+    shm_ring& shm_transport::from(uint channel, uint rank) {
+        return ring(channel, rank, this->rank);
+    }
+
+    shm_ring& shm_transport::ring(uint channel, uint from, uint to) {
+        return rings[(channel*locals + local_index[from])*locals + local_index[to]];
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef SHM_HPP
+#define SHM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+#include "flow_control.hpp"
+
+namespace dj {
+
+    /**
+     * Tag of message telling that the following messages of its sender come through the other
+     * transport - in a ring it means they go through MPI, in MPI that they go through the ring again
+     */
+    const int ring_switch_tag = credit_tag + 1;
+
+    /**
+     * Ring of messages in memory shared by two processes, written only by one and read only by the other.
+     * Every message is its size, tag and data padded to 8 bytes. Room for a switch is always
+     * kept, so that writer can tell reader to look elsewhere when the ring is full.
+     */
+    class shm_ring {
+
+        public:
+            /**
+             * @return bytes of memory needed by ring of given capacity
+             */
+            static std::size_t footprint(std::size_t capacity);
+            /**
+             * Empty ring at given memory, aligned to 64 bytes
+             */
+            static void create(void* at, std::size_t capacity);
+
+            /**
+             * @throws runtime_error if the ring at given memory was created with other capacity
+             */
+            shm_ring(void* at, std::size_t capacity);
+
+            bool fits(std::size_t size) const;
+            /**
+             * @return false if message does not fit
+             */
+            bool write(int tag, const char* data, std::size_t size);
+            void write_switch();
+            /**
+             * @return false if there is no message
+             */
+            bool read(int& tag, std::string& data);
+
+        private:
+            struct header {
+                alignas(64) std::atomic<uint64_t> head; // bytes written
+                alignas(64) std::atomic<uint64_t> tail; // bytes read
+                uint64_t capacity; // written once by create
+            };
+
+            static std::size_t record_size(std::size_t size);
+            void copy_in(uint64_t at, const void* from, std::size_t size);
+            void copy_out(uint64_t at, void* to, std::size_t size) const;
+
+            header* ends;
+            char* data;
+            std::size_t capacity;
+    };
+
+    /**
+     * Rings between processes of one host in a segment mapped by all of them. Every ordered pair
+     * of processes has a ring for each channel.
+     */
+    class shm_transport {
+
+        public:
+            shm_transport() = default;
+            shm_transport(const shm_transport&) = delete;
+            shm_transport& operator=(const shm_transport&) = delete;
+            ~shm_transport();
+
+            /**
+             * Collective over comm, processes with equal host share a segment
+             * @return false if no other process is on the same host or segment could not be mapped
+             * @throws std::runtime_error in every process if processes of a host differ in ring_size
+             */
+            bool open(const boost::mpi::communicator& comm, const std::string& host, uint channels, std::size_t ring_size);
+            void close();
+            bool is_open() const;
+
+            /**
+             * @return true if process of given rank is on the same host
+             */
+            bool local(int rank) const;
+            /**
+             * Ranks of other processes on the same host
+             */
+            const std::vector<uint>& peers() const;
+
+            shm_ring& to(uint channel, uint rank);
+            shm_ring& from(uint channel, uint rank);
+
+        private:
+            shm_ring& ring(uint channel, uint from, uint to);
+
+            void* segment = nullptr;
+            std::size_t segment_size = 0;
+            std::vector<int> local_index; // for every rank, -1 if it is on other host
+            std::vector<uint> _peers;
+            uint rank = 0;
+            uint locals = 0;
+            std::vector<shm_ring> rings; // for (channel*locals + from)*locals + to
+    };
+}
+
+#endif
@@ -27,4 +27,78 @@ namespace dj {
     int base_unit::rank() const {
         return (processor != nullptr) ? processor->context().rank : -1;
     }
+
+    void base_unit::set_window(window_spec spec) {
+        windows.reset(new window_store(std::move(spec)));
+    }
+
+    bool base_unit::is_windowed() const {
+        return windows != nullptr;
+    }
+
+    uint64_t base_unit::event_time() const {
+        return _event_time;
+    }
+
+    uint64_t base_unit::origin() const {
+        return _origin;
+    }
+
+    uint64_t base_unit::origin_host() const {
+        return _origin_host;
+    }
+
+    void base_unit::set_origin(uint64_t origin) {
+        _origin = origin;
+    }
+
+    bool base_unit::accept_record(const work_unit& work) {
+        uint64_t event_time = work.event_time;
+        if(windows) {
+            // without watermarks records are out of order by at most lateness
+            uint64_t lateness = windows->spec().lateness();
+            if(event_time > lateness && !(processor != nullptr && processor->watermarks_enabled()))
+                windows->close_until(event_time - lateness, [this](const window& w) { close_window(w); });
+            if(!windows->assign(event_time)) {
+                _late_records++;
+                return false;
+            }
+        }
+        _event_time = event_time;
+        _origin = work.origin;
+        _origin_host = work.origin_host;
+        return true;
+    }
+
+    void base_unit::advance_watermark(uint64_t watermark) {
+        if(windows) windows->close_until(watermark, [this](const window& w) { close_window(w); });
+    }
+
+    uint64_t base_unit::late_records() const {
+        return _late_records;
+    }
+
+    void base_unit::close_all_windows() {
+        if(windows) windows->close_all([this](const window& w) { close_window(w); });
+    }
+
+    void base_unit::close_window(const window& w) {
+        uint64_t event_time = _event_time;
+        uint64_t origin = _origin;
+        _event_time = w.end - 1; // results of the window are emitted at its end
+        _origin = 0; // and do not belong to any single record
+        handle_window(w);
+        _event_time = event_time;
+        _origin = origin;
+    }
+
+    const std::vector<window>& base_unit::current_windows() const {
+        if(!windows) throw std::runtime_error("Node " + _name + " has no window set");
+        return windows->current();
+    }
+
+    arena& base_unit::window_arena(const window& w) {
+        if(!windows) throw std::runtime_error("Node " + _name + " has no window set");
+        return windows->arena_for(w);
+    }
 }
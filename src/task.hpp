@@ -7,6 +7,8 @@
 #include "node.hpp"
 #include "template_utils.hpp"
 #include "executor.hpp"
+#include "aggregator.hpp"
+#include "window.hpp"
 
 namespace dj {
 
@@ -27,9 +29,97 @@ namespace dj {
             int rank() const;
             virtual void handle_finish() = 0; // no more data will be delivered in this pass
 
+            /**
+             * Records delivered to this node are grouped into windows of their event time,
+             * handle_window is called for every window as soon as it closes.
+             * Has to be set before start, usually in constructor.
+             */
+            void set_window(window_spec spec);
+            bool is_windowed() const;
+            /**
+             * no more data will be delivered to this window, its state is released afterwards
+             */
+            virtual void handle_window(const window& /* w */) { }
+
+            /**
+             * @return event time of processed record, results emitted now carry it
+             */
+            uint64_t event_time() const;
+
+            /**
+             * @return monotonic time the sampled input record processed now entered the pipeline,
+             * 0 if it was not sampled (see executor::set_latency_sampling)
+             */
+            uint64_t origin() const;
+            /**
+             * @return machine of origin, see latency_sampler::host
+             */
+            uint64_t origin_host() const;
+            void set_origin(uint64_t origin);
+
+            /**
+             * Called by node before record is processed - closes windows left behind
+             * @return false if record is late for all of its windows and should be dropped
+             */
+            bool accept_record(const work_unit& work);
+            /**
+             * Closes windows ending at or before watermark
+             */
+            void advance_watermark(uint64_t watermark);
+            void close_all_windows();
+            /**
+             * @return number of records dropped because all their windows were closed
+             */
+            uint64_t late_records() const;
+
+        protected:
+            /**
+             * @return windows the processed record belongs to
+             */
+            const std::vector<window>& current_windows() const;
+            /**
+             * Memory released when window closes, see arena_allocator
+             */
+            arena& window_arena(const window& w);
+
+            /**
+             * @return state of the window, constructed from args in its arena on first use.
+             * Node has to use the same T for all windows.
+             */
+            template <typename T, typename... Args>
+                T& window_state(const window& w, Args&&... args) {
+                    if(!windows) throw std::runtime_error("Node " + name() + " has no window set");
+                    void*& state = windows->state_for(w);
+                    if(state == nullptr) state = windows->arena_for(w).make<T>(std::forward<Args>(args)...);
+                    return *static_cast<T*>(state);
+                }
+
+            /**
+             * Updates local value of aggregator registered in pipeline
+             */
+            template <typename T>
+                void aggregate(const std::string& name, const T& value) {
+                    processor->get_aggregators().get<T>(name).update(value);
+                }
+
+            /**
+             * @return value of aggregator combined from all processes when tasks phase ended
+             */
+            template <typename T>
+                T aggregated(const std::string& name) const {
+                    return processor->get_aggregators().get<T>(name).value();
+                }
+
         private:
+            void close_window(const window& w);
+
             std::string _name;
             int _index = -1;
+            uint64_t _event_time = 0;
+            uint64_t _origin = 0;
+            uint64_t _origin_host = 0;
+            uint64_t _late_records = 0;
+            std::unique_ptr<window_store> windows;
 
         protected:
             exec::executor* processor = nullptr;
@@ -49,6 +139,17 @@ namespace dj {
                  */
                 template <typename T, enode_type TargetType>
                     void emit(const T& value, const std::string& target="", int rk=-2) const {
+                        emit_with_priority<T, TargetType>(value, 0, target, rk);
+                    }
+
+                /**
+                 * the same as emit, but in asynchronous execution mode result with
+                 * lower priority is processed before others waiting on the target's process
+                 * (e.g. distance bucket in delta-stepping)
+                 */
+                template <typename T, enode_type TargetType>
+                    void emit_with_priority(const T& value, int64_t priority, 
+                            const std::string& target="", int rk=-2) const {
                         using serialization::operator<<;
 
                         static_assert(is_any_same<T, OutputParameters...>{}, 
@@ -59,6 +160,10 @@ namespace dj {
                         result.type_name = typeid(T).name();
                         result.index_from = index();
                         result.locale = locale_info::get_basic();
+                        result.priority = priority;
+                        result.event_time = event_time();
+                        result.origin = origin();
+                        result.origin_host = origin_host();
 
                         std::pair<uint, uint> identity;
 
@@ -110,8 +215,8 @@ namespace dj {
                         }
                         result.index_to = identity.second;
 
-                        if(rk == -2) processor->send(result, identity.first);
-                        else processor->send(result, rk);
+                        if(rk == -2) processor->send(std::move(result), identity.first);
+                        else processor->send(std::move(result), rk);
                     }
         };
 
@@ -148,14 +253,17 @@ namespace dj {
                     work.type_name = typeid(PipeInputType).name();
                     work.index_from = index();
                     work.locale = locale_info::get_basic();
+                    work.event_time = event_time();
+                    work.origin = origin();
+                    work.origin_host = origin_host();
 
                     std::pair<uint, uint> identity = processor->get_rank_and_index_for(
                             enode_type::REDUCER, index(), enode_type::TASK, ""); // it defaults to root node
 
                     work.index_to = identity.second;
 
-                    if(rn == -2) processor->send(work, identity.first);
-                    else processor->send(work, rn);
+                    if(rn == -2) processor->send(std::move(work), identity.first);
+                    else processor->send(std::move(work), rn);
                 }
 
                 /**
@@ -167,14 +275,18 @@ namespace dj {
                     work.work_type = work_unit::ework_type::REDUCER_WORK_OUTPUT;
                     work.data << output;
                     work.type_name = typeid(OutputType).name();
+                    work.locale = locale_info::get_basic();
                     work.index_from = index();
+                    work.event_time = event_time();
+                    work.origin = origin();
+                    work.origin_host = origin_host();
 
                     std::pair<uint, uint> identity = processor->get_rank_and_index_for(
                             enode_type::REDUCER, index(), enode_type::OUTPUT, ""); // it defaults to root node
 
                     work.index_to = identity.second;
 
-                    processor->send(work, identity.first);
+                    processor->send(std::move(work), identity.first);
                 }
 
                 /**
@@ -190,9 +302,12 @@ namespace dj {
                     work.index_from = index();
                     work.index_to = index();
                     work.locale = locale_info::get_basic();
+                    work.event_time = event_time();
+                    work.origin = origin();
+                    work.origin_host = origin_host();
                     uint to = processor->get_root_reducer_rank(index());
 
-                    processor->send(work, to);
+                    processor->send(std::move(work), to);
                 }
 
             private:
@@ -220,12 +335,15 @@ namespace dj {
                     work.data << coordinator_output;
                     work.index_from = index();
                     work.locale = locale_info::get_basic();
+                    work.event_time = event_time();
+                    work.origin = origin();
+                    work.origin_host = origin_host();
 
                     std::pair<uint, uint> identity = processor->get_rank_and_index_for(
                             enode_type::COORDINATOR, index(), enode_type::TASK, target); // it defaults to root node
                     work.index_to = identity.second;
 
-                    processor->send(work, -1); // to all
+                    processor->send(std::move(work), -1); // to all
                 }
         };
 
@@ -1,8 +1,10 @@
 #ifndef TEMPLATE_UTILS_HPP
 #define TEMPLATE_UTILS_HPP
 
+#include <cstddef>
 #include <type_traits>
 #include <functional>
+#include <vector>
 
 namespace dj {
 
@@ -41,6 +43,33 @@ namespace dj {
                 }
         };
 
+
+    /**
+     * Records lying one after another in memory, which span does not own
+     */
+    template <typename T>
+        class span {
+
+            public:
+                span() = default;
+                span(T* data, std::size_t size) : _data(data), _size(size) { }
+
+                template <typename U, typename = typename std::enable_if<std::is_const<T>::value
+                    && std::is_same<typename std::remove_const<T>::type, U>::value>::type>
+                    span(const std::vector<U>& records) : _data(records.data()), _size(records.size()) { }
+
+                T* data() const { return _data; }
+                std::size_t size() const { return _size; }
+                bool empty() const { return _size == 0; }
+                T& operator[](std::size_t i) const { return _data[i]; }
+                T* begin() const { return _data; }
+                T* end() const { return _data + _size; }
+
+            private:
+                T* _data = nullptr;
+                std::size_t _size = 0;
+        };
+
 }
 
 #endif
@@ -0,0 +1,57 @@
+#define BOOST_TEST_MODULE aggregator_test
+
+#include <boost/test/unit_test.hpp>
+#include "../aggregator.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(aggregator_test)
+
+    BOOST_AUTO_TEST_CASE(combine_test) {
+
+        // two processes with the same aggregators
+        aggregator_registry r1, r2;
+        for(aggregator_registry* r: { &r1, &r2 }) {
+            r->add<int>("sum", eaggregation::SUM);
+            r->add<double>("min", eaggregation::MIN);
+            r->add<long>("max", eaggregation::MAX);
+            r->add<int>("product", [](const int& a, const int& b) { return a*b; }, 1);
+        }
+
+        r1.get<int>("sum").update(3);
+        r1.get<int>("sum").update(4);
+        r2.get<int>("sum").update(5);
+        r1.get<double>("min").update(2.5);
+        r2.get<double>("min").update(-1.5);
+        r2.get<long>("max").update(7);
+        r1.get<int>("product").update(3);
+        r2.get<int>("product").update(5);
+
+        auto global = r1.combine(r1.local_values(), r2.local_values());
+        r1.set_global(global);
+        r2.set_global(global);
+
+        for(aggregator_registry* r: { &r1, &r2 }) {
+            BOOST_CHECK_EQUAL(r->get<int>("sum").value(), 12);
+            BOOST_CHECK_EQUAL(r->get<double>("min").value(), -1.5);
+            BOOST_CHECK_EQUAL(r->get<long>("max").value(), 7);
+            BOOST_CHECK_EQUAL(r->get<int>("product").value(), 15);
+        }
+
+        // local values start from identity after combination
+        r1.set_global(r1.combine(r1.local_values(), r2.local_values()));
+        BOOST_CHECK_EQUAL(r1.get<int>("sum").value(), 0);
+        BOOST_CHECK_EQUAL(r1.get<int>("product").value(), 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(lookup_test) {
+
+        aggregator_registry r;
+        r.add<int>("sum", eaggregation::SUM);
+
+        BOOST_CHECK_THROW(r.add<int>("sum", eaggregation::MAX), std::runtime_error);
+        BOOST_CHECK_THROW(r.get<int>("none"), std::runtime_error);
+        BOOST_CHECK_THROW(r.get<double>("sum"), std::runtime_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
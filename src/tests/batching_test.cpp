@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE batching_test
+
+#include <boost/test/unit_test.hpp>
+#include "../batching.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(batching_test)
+
+    BOOST_AUTO_TEST_CASE(pack_test) {
+
+        std::vector<message> batch;
+        batch.emplace_back(1, "first");
+        batch.emplace_back(3, std::string("sec\0nd", 6));
+        batch.emplace_back(2, "");
+
+        message mes = pack_batch(batch);
+        BOOST_CHECK_EQUAL(mes.tag, batch_tag);
+
+        std::vector<message> unpacked = unpack_batch(mes);
+        BOOST_REQUIRE_EQUAL(unpacked.size(), batch.size());
+        for(uint i = 0; i < batch.size(); i++) {
+            BOOST_CHECK_EQUAL(unpacked[i].tag, batch[i].tag);
+            BOOST_CHECK_EQUAL(unpacked[i].data, batch[i].data);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(buffer_test) {
+
+        using serialization::operator<<;
+        work_unit work(work_unit::ework_type::TASK_WORK, payload(), typeid(int).name(), locale_info(1, "host", 2), 1, 0);
+        work.data << 42;
+        batch_buffer batch;
+        std::size_t bytes = batch.add(work);
+        batch.add(3, "abc", 3);
+        BOOST_CHECK_EQUAL(batch.size(), 2u);
+        BOOST_CHECK(bytes > 0);
+
+        message mes(batch_tag, batch.packed());
+        std::vector<int> tags;
+        std::vector<work_unit> read;
+        for_each_in_batch(mes, [&](int tag, const char* data, std::size_t size) {
+            tags.push_back(tag);
+            if(tag == static_cast<int>(work.work_type)) {
+                work_unit w;
+                w.read(tag, data, size);
+                read.push_back(std::move(w));
+            } else {
+                BOOST_CHECK_EQUAL(std::string(data, size), "abc");
+            }
+        });
+        BOOST_REQUIRE_EQUAL(tags.size(), 2u);
+        BOOST_CHECK_EQUAL(tags[1], 3);
+        BOOST_REQUIRE_EQUAL(read.size(), 1u);
+        BOOST_CHECK_EQUAL(read[0].data, work.data);
+        BOOST_CHECK_EQUAL(read[0].index_to, work.index_to);
+        BOOST_CHECK(same_type_name(read[0].type_name, typeid(int).name()));
+
+        // cleared batch is empty but keeps its memory
+        batch.clear();
+        BOOST_CHECK(batch.empty());
+        BOOST_CHECK_EQUAL(unpack_batch(message(batch_tag, batch.packed())).size(), 0u);
+
+        // truncated batch is not read past its end
+        batch.add(1, "abcdef", 6);
+        std::string truncated = batch.packed().substr(0, batch.packed().size() - 2);
+        BOOST_CHECK_THROW(unpack_batch(message(batch_tag, truncated)), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(adaptation_test) {
+
+        adaptive_batch ab(1, 100);
+        ab.set_target(std::chrono::microseconds(1000));
+        BOOST_CHECK_EQUAL(ab.size(), 1u);
+
+        // full batches well within target grow
+        for(int i = 0; i < 50; i++) ab.record(std::chrono::microseconds(10), ab.size());
+        BOOST_CHECK_EQUAL(ab.size(), 100u);
+
+        // not full batches do not
+        adaptive_batch idle(1, 100);
+        idle.set_target(std::chrono::microseconds(1000));
+        idle.record(std::chrono::microseconds(10), 0);
+        BOOST_CHECK_EQUAL(idle.size(), 1u);
+
+        ab.record(std::chrono::microseconds(2000), 100);
+        BOOST_CHECK_EQUAL(ab.size(), 50u);
+        for(int i = 0; i < 20; i++) ab.record(std::chrono::microseconds(2000), ab.size());
+        BOOST_CHECK_EQUAL(ab.size(), 1u);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,153 @@
+#define BOOST_TEST_MODULE file_input_test
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "../DistributedJobs"
+
+using namespace dj;
+
+namespace {
+
+    std::atomic<long> result{ 0 };
+    std::atomic<int> misplaced{ 0 };
+    std::atomic<int> ranks_with_input{ 0 };
+    bool partitioned = false;
+
+    template <typename... Output>
+        class add_task : public base_task<Output...> { };
+
+    template <>
+        class add_task<long> : public base_task<long> {
+
+            public:
+                add_task() : base_task<long>("add_task") { }
+
+                void operator()(long input, const std::string& /* from */) {
+                    counter += input;
+                    if(partitioned && input % world_size() != rank()) misplaced++;
+                }
+
+                virtual void handle_finish() override {
+                    result += counter;
+                    if(counter > 0) ranks_with_input++;
+                }
+
+            private:
+                long counter = 0;
+        };
+
+    /**
+     * Numbers 1 to n, a few on every line
+     */
+    void write_numbers(std::ostream& out, int n) {
+        for(int i = 1; i <= n; i++) out << i << ((i % 3 == 0) ? "\n" : " \t");
+    }
+
+    std::string numbers_file(int n) {
+        std::string filename = "file_input_test." + std::to_string(n) + ".txt";
+        std::ofstream out(filename);
+        write_numbers(out, n);
+        return filename;
+    }
+
+    void run_add(std::unique_ptr<exec::transport> rank, std::unique_ptr<input_provider> input, 
+            exec::eexecution_mode mode = exec::eexecution_mode::RING) {
+        execution_pipeline pipe(std::move(input));
+        node_graph& graph = pipe.get_node_graph();
+        graph.set_root(graph.add(std::unique_ptr<task_node>(new task<add_task<long>, long>("add"))));
+        exec::executor processor(std::move(rank), pipe);
+        processor.set_execution_mode(mode);
+        processor.start();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(file_input_test)
+
+    BOOST_AUTO_TEST_CASE(line_range_test) {
+
+        std::string text = "1 2\n33\n\n444 5\n6";
+        for(uint parts: { 1, 2, 3, 7, 40 }) {
+            std::size_t covered = 0;
+            for(uint part = 0; part < parts; part++) {
+                byte_range range = line_range(text.data(), text.size(), part, parts);
+                // parts follow each other and start at lines
+                BOOST_CHECK_EQUAL(range.begin, covered);
+                BOOST_CHECK(range.begin == 0 || range.begin == text.size() || text[range.begin - 1] == '\n');
+                covered = range.end;
+            }
+            BOOST_CHECK_EQUAL(covered, text.size());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(scanner_test) {
+
+        std::string text = " 12\t-7\r\n+3 0 9223372036854775807\n";
+        text_scanner in(text.data(), text.data() + text.size());
+        std::vector<int64_t> read;
+        int64_t value;
+        while(in.next(value)) read.push_back(value);
+        std::vector<int64_t> expected = { 12, -7, 3, 0, 9223372036854775807 };
+        BOOST_CHECK_EQUAL_COLLECTIONS(read.begin(), read.end(), expected.begin(), expected.end());
+
+        std::string wrong = "1 x";
+        text_scanner bad(wrong.data(), wrong.data() + wrong.size());
+        int i;
+        BOOST_CHECK(bad.next(i));
+        BOOST_CHECK_THROW(bad.next(i), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(mmap_input_test) {
+
+        std::vector<std::string> files = { numbers_file(1000), numbers_file(10), numbers_file(0) };
+        for(uint ranks: { 1, 3 }) {
+            for(uint readers: { 1, 2 }) {
+                result = 0;
+                exec::thread_group group(ranks);
+                group.run([&files, readers](std::unique_ptr<exec::transport> rank) {
+                            run_add(std::move(rank), std::unique_ptr<input_provider>(
+                                        new input::mmap_file_input<long>(files, readers, 16)));
+                        });
+                BOOST_CHECK_EQUAL(result, 500500 + 55);
+            }
+        }
+
+        BOOST_CHECK_THROW(mapped_file("file_input_test.missing"), std::runtime_error);
+        for(auto& file: files) std::remove(file.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE(scatter_input_test) {
+
+        // in turns
+        for(auto mode: { exec::eexecution_mode::RING, exec::eexecution_mode::BSP, exec::eexecution_mode::ASYNC }) {
+            std::stringstream in;
+            write_numbers(in, 1000);
+            result = 0;
+            ranks_with_input = 0;
+            exec::thread_group group(3);
+            group.run([&in, mode](std::unique_ptr<exec::transport> rank) {
+                        run_add(std::move(rank), std::unique_ptr<input_provider>(
+                                    new input::scatter_stdin_input<long>(16, nullptr, in)), mode);
+                    });
+            BOOST_CHECK_EQUAL(result, 500500);
+            BOOST_CHECK_EQUAL(ranks_with_input, 3);
+        }
+
+        // by partitioner, input longer than a block
+        std::stringstream in;
+        write_numbers(in, 300000);
+        result = 0;
+        partitioned = true;
+        exec::thread_group group(3);
+        group.run([&in](std::unique_ptr<exec::transport> rank) {
+                    run_add(std::move(rank), std::unique_ptr<input_provider>(
+                                new input::scatter_stdin_input<long>(256, [](const long& n) { return n; }, in)));
+                });
+        partitioned = false;
+        BOOST_CHECK_EQUAL(result, 300000L*300001/2);
+        BOOST_CHECK_EQUAL(misplaced, 0);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,60 @@
+#define BOOST_TEST_MODULE flow_control_test
+
+#include <boost/test/unit_test.hpp>
+#include "../flow_control.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(flow_control_test)
+
+    BOOST_AUTO_TEST_CASE(credit_message_test) {
+
+        message mes = credit_message(1234);
+        BOOST_CHECK_EQUAL(mes.tag, credit_tag);
+        BOOST_CHECK_EQUAL(credits_of(mes), 1234u);
+        BOOST_CHECK_THROW(credits_of(message(credit_tag, "x")), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(window_test) {
+
+        credit_window credits;
+        credits.reset(3, 4);
+        credits.sent(1, 3);
+        BOOST_CHECK(!credits.exhausted());
+        credits.sent(1, 1);
+        BOOST_CHECK(credits.exhausted());
+        BOOST_CHECK(credits.exhausted(1));
+        BOOST_CHECK(!credits.exhausted(2));
+        credits.sent(2, 10); // batches may go over the window
+        BOOST_CHECK_EQUAL(credits.in_flight(2), 10u);
+
+        credits.granted(1, 2);
+        BOOST_CHECK(credits.exhausted());
+        credits.granted(2, 10);
+        BOOST_CHECK(!credits.exhausted());
+        BOOST_CHECK_EQUAL(credits.in_flight(1), 2u);
+
+        // credits from previous run are ignored
+        credits.granted(2, 5);
+        BOOST_CHECK_EQUAL(credits.in_flight(2), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(return_test) {
+
+        credit_window credits;
+        credits.reset(2, 4);
+        // credits are returned for every half of window
+        BOOST_CHECK_EQUAL(credits.processed(1), 0u);
+        BOOST_CHECK_EQUAL(credits.processed(1), 2u);
+        BOOST_CHECK_EQUAL(credits.processed(0), 0u);
+        BOOST_CHECK_EQUAL(credits.processed(1), 0u);
+
+        // nothing is counted without flow control
+        credits.reset(2, 0);
+        credits.sent(1, 100);
+        BOOST_CHECK(!credits.exhausted());
+        BOOST_CHECK(!credits.exhausted(1));
+        BOOST_CHECK_EQUAL(credits.processed(1), 0u);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
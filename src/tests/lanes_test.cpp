@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE lanes_test
+
+#include <boost/test/unit_test.hpp>
+#include "../lanes.hpp"
+
+using namespace dj;
+
+namespace {
+    work_unit make_work(work_unit::ework_type type, int64_t priority = 0) {
+        work_unit work;
+        work.work_type = type;
+        work.priority = priority;
+        return work;
+    }
+
+    work_unit make_watermark(enode_type from, enode_type to, uint index_from = 0) {
+        work_unit work = make_work(work_unit::ework_type::WATERMARK);
+        work.data = { static_cast<char>(from), static_cast<char>(to) };
+        work.index_from = index_from;
+        return work;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(lanes_test)
+
+    BOOST_AUTO_TEST_CASE(lane_of_test) {
+
+        BOOST_CHECK(lane_of(make_work(work_unit::ework_type::COORDINATOR_OUTPUT)) == ework_lane::COORDINATOR);
+        BOOST_CHECK(lane_of(make_work(work_unit::ework_type::REDUCER_REDUCE)) == ework_lane::REDUCER);
+        BOOST_CHECK(lane_of(make_work(work_unit::ework_type::TASK_WORK_OUTPUT)) == ework_lane::TASK);
+        BOOST_CHECK(lane_of(make_work(work_unit::ework_type::INPUT_WORK)) == ework_lane::INPUT);
+
+        // watermarks go with work on their edges
+        BOOST_CHECK(lane_of(make_watermark(enode_type::COORDINATOR, enode_type::TASK)) == ework_lane::COORDINATOR);
+        BOOST_CHECK(lane_of(make_watermark(enode_type::TASK, enode_type::REDUCER)) == ework_lane::REDUCER);
+        BOOST_CHECK(lane_of(make_watermark(enode_type::REDUCER, enode_type::OUTPUT)) == ework_lane::REDUCER);
+        BOOST_CHECK(lane_of(make_watermark(enode_type::TASK, enode_type::OUTPUT)) == ework_lane::TASK);
+        BOOST_CHECK(lane_of(make_watermark(input_source.first, enode_type::TASK, input_source.second)) 
+                == ework_lane::INPUT);
+    }
+
+    BOOST_AUTO_TEST_CASE(priority_test) {
+
+        work_unit task1 = make_work(work_unit::ework_type::TASK_WORK);
+        work_unit task2 = make_work(work_unit::ework_type::TASK_WORK);
+        work_unit input = make_work(work_unit::ework_type::INPUT_WORK);
+        work_unit coordinator = make_work(work_unit::ework_type::COORDINATOR_OUTPUT);
+
+        work_lanes lanes;
+        lanes.push(&input);
+        lanes.push(&task1);
+        lanes.push(&task2);
+        lanes.push(&coordinator);
+        BOOST_CHECK_EQUAL(lanes.size(ework_lane::TASK), 2u);
+
+        BOOST_CHECK_EQUAL(lanes.pop(), &coordinator);
+        BOOST_CHECK_EQUAL(lanes.pop(), &task1);
+        BOOST_CHECK_EQUAL(lanes.pop(), &task2);
+        BOOST_CHECK_EQUAL(lanes.pop(), &input);
+        BOOST_CHECK(lanes.pop() == nullptr);
+        BOOST_CHECK(lanes.empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(weights_test) {
+
+        std::vector<work_unit> tasks(6, make_work(work_unit::ework_type::TASK_WORK));
+        std::vector<work_unit> inputs(3, make_work(work_unit::ework_type::INPUT_WORK));
+
+        work_lanes lanes;
+        lanes.set_weights({ 0, 0, 2, 1 });
+        for(auto& w: tasks) lanes.push(&w);
+        for(auto& w: inputs) lanes.push(&w);
+
+        // two tasks for every input while there are both
+        std::string order;
+        while(work_unit* w = lanes.pop()) order += (w->work_type == work_unit::ework_type::TASK_WORK) ? 't' : 'i';
+        BOOST_CHECK_EQUAL(order, "ttittitti");
+    }
+
+    BOOST_AUTO_TEST_CASE(prioritized_test) {
+
+        work_unit late = make_work(work_unit::ework_type::TASK_WORK, 5);
+        work_unit early = make_work(work_unit::ework_type::TASK_WORK, 1);
+        work_unit reducer = make_work(work_unit::ework_type::REDUCER_REDUCE, 10);
+
+        work_lanes lanes;
+        lanes.set_prioritized(true);
+        lanes.push(&late);
+        lanes.push(&early);
+        lanes.push(&reducer);
+
+        // lane goes before priority
+        BOOST_CHECK_EQUAL(lanes.pop(), &reducer);
+        BOOST_CHECK_EQUAL(lanes.pop(), &early);
+        BOOST_CHECK_EQUAL(lanes.pop(), &late);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
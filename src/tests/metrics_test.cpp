@@ -0,0 +1,190 @@
+#define BOOST_TEST_MODULE metrics_test
+
+#include <boost/test/unit_test.hpp>
+#include "../metrics.hpp"
+#include "../message.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(metrics_test)
+
+    BOOST_AUTO_TEST_CASE(histogram_test) {
+
+        latency_histogram h;
+        BOOST_CHECK_EQUAL(h.count(), 0u);
+        BOOST_CHECK_EQUAL(h.percentile(0.5), 0u);
+
+        for(uint64_t v = 1; v <= 1000; v++) h.record(v*1000);
+        BOOST_CHECK_EQUAL(h.count(), 1000u);
+        BOOST_CHECK_EQUAL(h.min(), 1000u);
+        BOOST_CHECK_EQUAL(h.max(), 1000000u);
+        BOOST_CHECK_CLOSE(h.mean(), 500500.0, 0.001);
+
+        // relative error bounded by bucket width
+        BOOST_CHECK_CLOSE(double(h.percentile(0.5)), 500000.0, 100.0/latency_histogram::sub_buckets);
+        BOOST_CHECK_CLOSE(double(h.percentile(0.99)), 990000.0, 100.0/latency_histogram::sub_buckets);
+        BOOST_CHECK_EQUAL(h.percentile(1), h.max());
+
+        latency_histogram small;
+        for(uint64_t v = 0; v < 10; v++) small.record(v);
+        BOOST_CHECK_EQUAL(small.percentile(0.5), 4u); // small values are exact
+
+        small.merge(h);
+        BOOST_CHECK_EQUAL(small.count(), 1010u);
+        BOOST_CHECK_EQUAL(small.min(), 0u);
+        BOOST_CHECK_EQUAL(small.max(), 1000000u);
+    }
+
+    BOOST_AUTO_TEST_CASE(registry_test) {
+        using serialization::operator<<;
+        using serialization::operator>>;
+
+        metrics_registry first;
+        node_metrics* task = first.add("task", "splitter", 0);
+        task->records_in = 3;
+        task->process_ns.record(100);
+        first.add("output", "printer", 0)->records_in = 1;
+
+        metrics_registry second;
+        node_metrics* other = second.add("task", "splitter", 0);
+        other->records_in = 4;
+        other->bytes_out = 10;
+        other->process_ns.record(200);
+
+        // phases and memory are of the slowest and the largest process
+        first.add_phase_time(static_cast<uint>(ecomputation_phase::TASKS), 500);
+        first.set_peak_rss(1000);
+        second.add_phase_time(static_cast<uint>(ecomputation_phase::TASKS), 700);
+        second.add_phase_time(static_cast<uint>(ecomputation_phase::REDUCTION), 30);
+        second.set_peak_rss(800);
+        first.add_input_stall(40);
+        second.add_credit_stall(90);
+
+        std::string data;
+        data << second;
+        metrics_registry received;
+        data >> received;
+
+        first.merge(received);
+        BOOST_CHECK_EQUAL(task->records_in, 7u);
+        BOOST_CHECK_EQUAL(task->bytes_out, 10u);
+        BOOST_CHECK_EQUAL(task->process_ns.count(), 2u);
+        BOOST_CHECK_EQUAL(task->process_ns.max(), 200u);
+        BOOST_CHECK_EQUAL(first.phase_time(static_cast<uint>(ecomputation_phase::TASKS)), 700u);
+        BOOST_CHECK_EQUAL(first.phase_time(static_cast<uint>(ecomputation_phase::REDUCTION)), 30u);
+        BOOST_CHECK_EQUAL(first.peak_rss(), 1000u);
+        BOOST_CHECK_EQUAL(first.input_stall(), 40u);
+        BOOST_CHECK_EQUAL(first.credit_stall(), 90u);
+
+        std::string json = first.to_json(-1, 2);
+        BOOST_CHECK(json.find("\"name\": \"splitter\"") != std::string::npos);
+        BOOST_CHECK(json.find("\"records_in\": 7") != std::string::npos);
+        BOOST_CHECK(json.find("\"name\": \"printer\"") != std::string::npos);
+        BOOST_CHECK(json.find("\"peak_rss_kb\": 1000") != std::string::npos);
+        BOOST_CHECK(json.find("\"TASKS\": 700") != std::string::npos);
+        BOOST_CHECK(json.find("\"stall_ns\": {\"input\": 40, \"credits\": 90}") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(traffic_test) {
+        using serialization::operator<<;
+        using serialization::operator>>;
+
+        const int task_work = static_cast<int>(work_unit::ework_type::TASK_WORK);
+        const int reduce = static_cast<int>(work_unit::ework_type::REDUCER_REDUCE);
+
+        traffic_matrix first;
+        first.reset(0, 2);
+        first.record_sent(1, task_work, 100);
+        first.record_sent(1, reduce, 20);
+        first.record_received(1, task_work, 50);
+        first.end_pass();
+        first.record_sent(1, task_work, 300);
+
+        traffic_matrix second;
+        second.reset(1, 2);
+        second.record_received(0, task_work, 100);
+        second.record_received(0, reduce, 20);
+        second.record_sent(0, task_work, 50);
+        second.end_pass();
+        second.end_pass();
+        second.record_sent(0, reduce, 7);
+
+        std::string data;
+        data << second;
+        traffic_matrix received;
+        data >> received;
+
+        traffic_matrix merged;
+        merged.reset(0, 2);
+        merged.merge(first);
+        merged.merge(received);
+
+        BOOST_REQUIRE_EQUAL(merged.passes(), 3u);
+        BOOST_CHECK_EQUAL(merged.sent_messages(0, 0, 1), 2u);
+        BOOST_CHECK_EQUAL(merged.sent_bytes(0, 0, 1), 120u);
+        BOOST_CHECK_EQUAL(merged.sent_messages(0, 1, 0), 1u);
+        BOOST_CHECK_EQUAL(merged.sent_bytes(1, 0, 1), 300u);
+        BOOST_CHECK_EQUAL(merged.sent_messages(2, 1, 0), 1u);
+        BOOST_CHECK_EQUAL(merged.sent_messages(0, 0, 0), 0u);
+
+        BOOST_CHECK_EQUAL(merged.message_sizes(0, 1).count(), 3u);
+        BOOST_CHECK_EQUAL(merged.message_sizes(0, 1).max(), 300u);
+        BOOST_CHECK_EQUAL(merged.message_sizes(1, 0).count(), 2u);
+
+        std::string json = merged.to_json();
+        BOOST_CHECK(json.find("\"messages\": [[0, 2], [1, 0]]") != std::string::npos);
+        BOOST_CHECK(json.find("\"type\": \"REDUCER_REDUCE\", \"sent_messages\": 1, \"sent_bytes\": 20, "
+                    "\"received_messages\": 1, \"received_bytes\": 20") != std::string::npos);
+
+        traffic_matrix other_size;
+        other_size.reset(0, 3);
+        BOOST_CHECK_THROW(merged.merge(other_size), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(latency_test) {
+        using serialization::operator<<;
+        using serialization::operator>>;
+
+        latency_sampler off;
+        off.reset(0);
+        for(int i = 0; i < 10; i++) BOOST_CHECK_EQUAL(off.sample(), 0u);
+
+        latency_sampler sampler;
+        sampler.reset(4);
+        sampler.add_output(2, "printer");
+        uint sampled = 0;
+        for(int i = 0; i < 12; i++) {
+            uint64_t origin = sampler.sample();
+            if(origin == 0) continue;
+            BOOST_CHECK(origin <= latency_sampler::now());
+            sampled++;
+            sampler.record(2, origin, sampler.host());
+        }
+        BOOST_CHECK_EQUAL(sampled, 3u);
+        BOOST_CHECK_EQUAL(sampler.latencies(2).count(), 3u);
+        BOOST_CHECK_THROW(sampler.record(1, 1, sampler.host()), std::runtime_error);
+
+        // clock of another machine is not compared
+        sampler.record(2, 1, sampler.host() + 1);
+        BOOST_CHECK_EQUAL(sampler.latencies(2).count(), 3u);
+        BOOST_CHECK_EQUAL(sampler.other_host_samples(2), 1u);
+
+        latency_sampler other;
+        other.reset(4);
+        other.add_output(2, "printer");
+        other.record(2, latency_sampler::now() - 1000000, other.host());
+        other.record(2, 1, other.host() + 1);
+
+        std::string data;
+        data << other;
+        latency_sampler received;
+        data >> received;
+        sampler.merge(received);
+        BOOST_CHECK_EQUAL(sampler.latencies(2).count(), 4u);
+        BOOST_CHECK(sampler.latencies(2).max() >= 1000000u);
+        BOOST_CHECK_EQUAL(sampler.other_host_samples(2), 2u);
+        BOOST_CHECK(sampler.to_json(-1, 2).find("\"other_host_samples\": 2") != std::string::npos);
+        BOOST_CHECK(sampler.to_json(-1, 2).find("\"name\": \"printer\"") != std::string::npos);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
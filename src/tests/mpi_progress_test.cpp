@@ -0,0 +1,160 @@
+#define BOOST_TEST_MODULE mpi_progress_test
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <thread>
+#include "../DistributedJobs"
+#include "../mpi_transport.hpp"
+
+using namespace dj;
+namespace mpi = boost::mpi;
+
+/**
+ * Runs under mpirun with several processes (see CMakeLists.txt),
+ * every executor of the test uses MPI environment of the whole run
+ */
+namespace {
+
+    struct mpi_fixture {
+        mpi::environment env{ mpi::threading::serialized };
+    };
+
+    int result = 0;
+    int outputs = 0;
+
+    /**
+     * Numbers 1 to 1000 split between processes
+     */
+    class range_input : public input_provider {
+
+        public:
+            virtual void operator()() override {
+                context_info context = processor->context();
+                for(int i = context.rank + 1; i <= 1000; i += context.size) add_input(i);
+                eof_callback();
+            }
+    };
+
+    template <typename... Output>
+        class spread_task : public base_task<Output...> { };
+
+    /**
+     * Every number goes to add task of another process, first process finishes slowly
+     */
+    template <>
+        class spread_task<int> : public base_task<int> {
+
+            public:
+                spread_task() : base_task<int>("spread_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    emit<int, enode_type::TASK>(input, "add", (rank() + 1) % world_size());
+                }
+
+                virtual void handle_finish() override {
+                    if(rank() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+        };
+
+    template <typename... Output>
+        class add_task : public base_task<Output...> { };
+
+    template <>
+        class add_task<int> : public base_task<int> {
+
+            public:
+                add_task() : base_task<int>("add_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    counter += input;
+                }
+
+                virtual void handle_finish() override {
+                    emit<int, enode_type::REDUCER>(counter);
+                }
+
+            private:
+                int counter = 0;
+        };
+
+    template <typename PipeInputType, typename InputType, typename OutputType>
+        class add_reducer : public base_reducer<PipeInputType, InputType, OutputType> {
+
+            public:
+                add_reducer() : base_reducer<PipeInputType, InputType, OutputType>("add_reducer") { }
+
+                virtual void reduce(const InputType& input, const std::string& /* parent */) override {
+                    accumulator += input;
+                }
+
+                virtual void collect(const OutputType& data_to_collect) override {
+                    accumulator += data_to_collect;
+                }
+
+                virtual void handle_finish() override {
+                    if(this->is_root_reducer()) this->return_output(accumulator);
+                }
+
+            private:
+                int accumulator = 0;
+        };
+
+    template <typename OutputerInput>
+        class sum_outputer : public base_outputer<OutputerInput> {
+
+            public:
+                sum_outputer() : base_outputer<OutputerInput>("sum_outputer") { }
+
+                virtual void operator()(const OutputerInput& input, const std::string& /* parent */) override {
+                    result = input;
+                    outputs++;
+                }
+
+                virtual void handle_finish() override { }
+        };
+
+    void run_spread(exec::eexecution_mode mode, bool batching, bool shared_memory) {
+        execution_pipeline pipe(std::unique_ptr<input_provider>(new range_input()));
+        node_graph& graph = pipe.get_node_graph();
+        uint root = graph.add(std::unique_ptr<task_node>(new task<spread_task<int>, int>("spread")));
+        uint add = graph.add(std::unique_ptr<task_node>(new task<add_task<int>, int>("add")));
+        uint sum = graph.add(std::unique_ptr<reducer_node>(
+                    new reducer<add_reducer, int, int, int>("sum", reducer_node::ereducer_type::SINGLE)));
+        uint out = graph.add(std::unique_ptr<output_node>(new outputer<sum_outputer, int>("out")));
+        graph.set_root(root);
+        graph.add_directed(root, add);
+        graph.add_output_to_reducer(out, sum);
+        graph.add_reducer_to_task(sum, add);
+
+        exec::executor processor(std::unique_ptr<exec::transport>(new exec::mpi_transport()), pipe);
+        processor.set_execution_mode(mode);
+        processor.set_progress_thread(true);
+        processor.set_shared_memory(shared_memory);
+        processor.set_inbound_capacity(6);
+        if(batching) processor.set_target_latency(std::chrono::milliseconds(1));
+        processor.start();
+    }
+}
+
+BOOST_GLOBAL_FIXTURE(mpi_fixture);
+
+BOOST_AUTO_TEST_SUITE(mpi_progress_test)
+
+    BOOST_AUTO_TEST_CASE(progress_thread_test) {
+
+        mpi::communicator world;
+        for(auto mode: { exec::eexecution_mode::RING, exec::eexecution_mode::BSP, exec::eexecution_mode::ASYNC }) {
+            for(bool batching: { false, true }) {
+                for(bool shared_memory: { true, false }) {
+                    result = 0;
+                    outputs = 0;
+                    run_spread(mode, batching, shared_memory);
+                    // output is written by one of processes
+                    BOOST_CHECK_EQUAL(mpi::all_reduce(world, result, mpi::maximum<int>()), 500500);
+                    BOOST_CHECK_EQUAL(mpi::all_reduce(world, outputs, std::plus<int>()), 1);
+                }
+            }
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,43 @@
+#define BOOST_TEST_MODULE mpi_shm_test
+
+#include <boost/test/unit_test.hpp>
+#include <boost/mpi.hpp>
+#include "../shm.hpp"
+
+using namespace dj;
+namespace mpi = boost::mpi;
+
+/**
+ * Runs under mpirun with several processes of one host (see CMakeLists.txt)
+ */
+namespace {
+
+    struct mpi_fixture {
+        mpi::environment env;
+    };
+}
+
+BOOST_GLOBAL_FIXTURE(mpi_fixture);
+
+BOOST_AUTO_TEST_SUITE(mpi_shm_test)
+
+    BOOST_AUTO_TEST_CASE(open_test) {
+
+        mpi::communicator world;
+        shm_transport shm;
+        BOOST_CHECK_EQUAL(shm.open(world, "host", 2, 4096), world.size() > 1);
+        BOOST_CHECK_EQUAL(shm.peers().size(), world.size() - 1u);
+        shm.close();
+    }
+
+    BOOST_AUTO_TEST_CASE(ring_size_test) {
+
+        // follower with a larger ring would map past the end of the segment
+        mpi::communicator world;
+        if(world.size() < 2) return;
+        shm_transport shm;
+        BOOST_CHECK_THROW(shm.open(world, "host", 2, world.rank() == 1 ? 8192 : 4096), std::runtime_error);
+        BOOST_CHECK(!shm.is_open());
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE pool_test
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <boost/test/unit_test.hpp>
+#include "../pool.hpp"
+#include "../message.hpp"
+
+using namespace dj;
+
+// every allocation of this binary is counted
+std::atomic<std::size_t> allocations{ 0 };
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /* size */) noexcept {
+    std::free(ptr);
+}
+
+BOOST_AUTO_TEST_SUITE(pool_test)
+
+    BOOST_AUTO_TEST_CASE(reuse_test) {
+
+        object_pool<work_unit> pool(1);
+        work_unit* first = pool.acquire();
+        work_unit* second = pool.acquire();
+        BOOST_CHECK(first != second);
+
+        first->data = "kept";
+        pool.release(first);
+        pool.release(second); // pool is full, deleted
+
+        work_unit* again = pool.acquire();
+        BOOST_CHECK_EQUAL(again, first);
+        BOOST_CHECK_EQUAL(again->data, "kept");
+        {
+            object_pool<work_unit>::pointer wrapped = pool.wrap(again);
+        }
+        BOOST_CHECK_EQUAL(pool.acquire(), first);
+        pool.release(first);
+    }
+
+    BOOST_AUTO_TEST_CASE(allocation_test) {
+
+        work_unit prototype;
+        prototype.work_type = work_unit::ework_type::TASK_WORK;
+        prototype.type_name = "some long name of type of the record";
+        prototype.data = std::string(200, 'x');
+        prototype.locale = locale_info(1, "some long name of the host", 12345);
+        end_message end_mes { 1, 2, 3, end_message::eend_message_type::TASK_END };
+
+        object_pool<work_unit> work_pool;
+        object_pool<end_message> end_pool;
+        auto cycle = [&]() {
+            // recycled work is filled in place, as when it is received
+            work_unit* work = work_pool.acquire();
+            *work = prototype;
+            object_pool<work_unit>::pointer queued = work_pool.wrap(work);
+            end_message* end_ptr = end_pool.acquire();
+            *end_ptr = end_mes;
+            end_pool.release(end_ptr);
+        };
+
+        cycle();
+        std::size_t before = allocations;
+        for(int i = 0; i < 1000; i++) cycle();
+        std::size_t after = allocations;
+        BOOST_CHECK_EQUAL(after - before, 0u);
+
+        // new objects are allocated only when pool runs out
+        before = allocations;
+        work_unit* first = work_pool.acquire();
+        work_unit* second = work_pool.acquire();
+        after = allocations;
+        BOOST_CHECK(after > before);
+        work_pool.release(first);
+        work_pool.release(second);
+    }
+
+    BOOST_AUTO_TEST_CASE(scalar_work_test) {
+
+        using serialization::operator<<;
+        work_unit sent(work_unit::ework_type::TASK_WORK, payload(), typeid(int).name(), locale_info(1, "host", 2), 0, 0);
+        sent.data << 42;
+        message mes;
+        mes << sent;
+
+        object_pool<work_unit> pool;
+        auto cycle = [&]() {
+            // as when work is received
+            object_pool<work_unit>::pointer work = pool.wrap(pool.acquire());
+            work->read(mes.tag, mes.data.data(), mes.data.size());
+        };
+
+        // scalar payload is kept inline, received work of it is not allocated at all
+        cycle();
+        std::size_t before = allocations;
+        for(int i = 0; i < 1000; i++) cycle();
+        BOOST_CHECK_EQUAL(allocations - before, 0u);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
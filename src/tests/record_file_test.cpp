@@ -0,0 +1,176 @@
+#define BOOST_TEST_MODULE record_file_test
+
+#include <boost/test/unit_test.hpp>
+#include <boost/serialization/string.hpp>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "../DistributedJobs"
+
+using namespace dj;
+
+namespace {
+
+    std::atomic<long> result{ 0 };
+    std::atomic<long> chunks{ 0 };
+
+    template <typename... Output>
+        class sum_task : public base_task<Output...> { };
+
+    /**
+     * Numbers come in chunks, words of blocks one by one
+     */
+    template <>
+        class sum_task<long> : public base_task<long> {
+
+            public:
+                sum_task() : base_task<long>("sum_task") { }
+
+                void operator()(span<const long> inputs, const std::string& /* from */) {
+                    chunks++;
+                    for(long input: inputs) counter += input;
+                }
+
+                void operator()(long input, const std::string& /* from */) {
+                    counter += input;
+                }
+
+                void operator()(const std::string& input, const std::string& /* from */) {
+                    counter += std::stol(input);
+                }
+
+                virtual void handle_finish() override {
+                    result += counter;
+                }
+
+            private:
+                long counter = 0;
+        };
+
+    template <typename... Output>
+        class pass_task : public base_task<Output...> { };
+
+    template <>
+        class pass_task<long> : public base_task<long> {
+
+            public:
+                pass_task() : base_task<long>("pass_task") { }
+
+                void operator()(long input, const std::string& /* from */) {
+                    emit<long, enode_type::OUTPUT>(input);
+                }
+
+                virtual void handle_finish() override { }
+        };
+
+    template <typename T>
+        void run_sum(std::vector<std::string> files, uint ranks) {
+            result = 0;
+            chunks = 0;
+            exec::thread_group group(ranks);
+            group.run([&files](std::unique_ptr<exec::transport> rank) {
+                        execution_pipeline pipe(std::unique_ptr<input_provider>(
+                                    new input::record_file_input<T>(files, 16)));
+                        node_graph& graph = pipe.get_node_graph();
+                        graph.set_root(graph.add(std::unique_ptr<task_node>(
+                                        new task<sum_task<long>, T>("sum"))));
+                        exec::executor processor(std::move(rank), pipe);
+                        processor.start();
+                    });
+        }
+}
+
+BOOST_AUTO_TEST_SUITE(record_file_test)
+
+    BOOST_AUTO_TEST_CASE(fixed_records_test) {
+
+        {
+            record_writer<long> out("record_file_test.fixed");
+            std::vector<long> numbers;
+            for(long i = 1; i <= 1000; i++) numbers.push_back(i);
+            out.write(numbers);
+            out.write(1001);
+        }
+        record_file file("record_file_test.fixed", record_schema<long>::name(), erecord_layout::FIXED, sizeof(long));
+        BOOST_CHECK_EQUAL(file.header().records, 1001);
+        BOOST_CHECK_EQUAL(file.size(), 1001*sizeof(long));
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(file.data()) % record_file_alignment, 0);
+
+        for(uint ranks: { 1, 3 }) {
+            run_sum<long>({ "record_file_test.fixed" }, ranks);
+            BOOST_CHECK_EQUAL(result, 1001*1002/2);
+            BOOST_CHECK(chunks >= 1001/16);
+        }
+
+        BOOST_CHECK_THROW(record_file("record_file_test.fixed", record_schema<int>::name(),
+                    erecord_layout::FIXED, sizeof(int)), std::runtime_error);
+
+        // the last record is cut off
+        std::ofstream cut("record_file_test.cut");
+        std::ifstream in("record_file_test.fixed");
+        cut << in.rdbuf();
+        cut.close();
+        {
+            std::ifstream whole("record_file_test.cut", std::ios::ate);
+            long size = whole.tellg();
+            BOOST_CHECK(truncate("record_file_test.cut", size - 1) == 0);
+        }
+        BOOST_CHECK_THROW(record_file("record_file_test.cut", record_schema<long>::name(),
+                    erecord_layout::FIXED, sizeof(long)), std::runtime_error);
+
+        std::remove("record_file_test.fixed");
+        std::remove("record_file_test.cut");
+    }
+
+    BOOST_AUTO_TEST_CASE(blocks_test) {
+
+        {
+            record_writer<std::string> out("record_file_test.blocks", 7);
+            for(long i = 1; i <= 100; i++) out.write(std::to_string(i));
+        }
+        record_file file("record_file_test.blocks", record_schema<std::string>::name(), erecord_layout::BLOCKS, 0);
+        BOOST_CHECK_EQUAL(file.header().records, 100);
+        BOOST_CHECK_EQUAL(file.blocks().size(), 15);
+
+        {
+            record_writer<std::string> empty("record_file_test.empty");
+        }
+        for(uint ranks: { 1, 3, 4 }) {
+            run_sum<std::string>({ "record_file_test.blocks", "record_file_test.empty" }, ranks);
+            BOOST_CHECK_EQUAL(result, 5050);
+        }
+
+        BOOST_CHECK_THROW(record_file("record_file_test.blocks", record_schema<long>::name(),
+                    erecord_layout::FIXED, sizeof(long)), std::runtime_error);
+        std::remove("record_file_test.blocks");
+        std::remove("record_file_test.empty");
+    }
+
+    BOOST_AUTO_TEST_CASE(outputer_test) {
+
+        std::stringstream in;
+        for(long i = 1; i <= 500; i++) in << i << "\n";
+        exec::thread_group group(1);
+        group.run([&in](std::unique_ptr<exec::transport> rank) {
+                    execution_pipeline pipe(std::unique_ptr<input_provider>(
+                                new input::scatter_stdin_input<long>(16, nullptr, in)));
+                    node_graph& graph = pipe.get_node_graph();
+                    uint root = graph.add(std::unique_ptr<task_node>(new task<pass_task<long>, long>("pass")));
+                    std::unique_ptr<outputer<record_file_outputer, long>> out(
+                            new outputer<record_file_outputer, long>("out"));
+                    out->initialize_outputer("record_file_test.out");
+                    uint output = graph.add(std::unique_ptr<output_node>(std::move(out)));
+                    graph.set_root(root);
+                    graph.add_output_to_task(output, root);
+                    exec::executor processor(std::move(rank), pipe);
+                    processor.start();
+                });
+
+        run_sum<long>({ "record_file_test.out" }, 2);
+        BOOST_CHECK_EQUAL(result, 500*501/2);
+        std::remove("record_file_test.out");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
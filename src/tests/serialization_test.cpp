@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <tuple>
+#include <type_traits>
 #include <boost/test/unit_test.hpp>
 #include "../message.hpp"
 
@@ -28,7 +29,7 @@ BOOST_AUTO_TEST_SUITE(serialization_test)
         uint pass_number = 2;
         uint counter = 3;
         end_message::eend_message_type end_type = end_message::eend_message_type::WORK_END;
-        end_message end_mes { from_rank, pass_number, counter, end_type };
+        end_message end_mes { from_rank, pass_number, counter, end_type, 4 };
 
         message mes;
         mes << end_mes;
@@ -41,6 +42,7 @@ BOOST_AUTO_TEST_SUITE(serialization_test)
         BOOST_CHECK_EQUAL(end_mes_d.pass_number, pass_number);
         BOOST_CHECK_EQUAL(end_mes_d.counter, counter);
         BOOST_CHECK(end_mes_d.end_type ==  end_type);
+        BOOST_CHECK_EQUAL(end_mes_d.urgent_sent, 4);
     }
 
     BOOST_AUTO_TEST_CASE(work_unit_test) {
@@ -62,6 +64,10 @@ BOOST_AUTO_TEST_SUITE(serialization_test)
         work.data = data;
         work.locale = locale; 
         work.phase = phase;
+        work.priority = -7;
+        work.event_time = 1234;
+        work.origin = 987654321;
+        work.origin_host = 42;
 
         message mes;
         mes << work;
@@ -78,6 +84,93 @@ BOOST_AUTO_TEST_SUITE(serialization_test)
         BOOST_CHECK_EQUAL(work_d.locale.timestamp, timestamp);
         BOOST_CHECK_EQUAL(work_d.locale.hostname, hostname);
         BOOST_CHECK(work.phase == phase);
+        BOOST_CHECK_EQUAL(work_d.priority, -7);
+        BOOST_CHECK_EQUAL(work_d.event_time, 1234u);
+        BOOST_CHECK_EQUAL(work_d.origin, 987654321u);
+        BOOST_CHECK_EQUAL(work_d.origin_host, 42u);
+
+        // not sampled work carries no origin
+        work.origin = 0;
+        message unsampled;
+        unsampled << work;
+        BOOST_CHECK_EQUAL(unsampled.data.size() + 2*sizeof(uint64_t), mes.data.size());
+        work_d << unsampled;
+        BOOST_CHECK_EQUAL(work_d.origin, 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(work_unit_move_test) {
+
+        static_assert(std::is_nothrow_move_constructible<work_unit>::value, "work is moved through the pipeline");
+        static_assert(std::is_nothrow_move_assignable<work_unit>::value, "work is moved through the pipeline");
+
+        work_unit work(work_unit::ework_type::TASK_WORK, payload(std::string("payload")), "type", locale_info(3, "host", 7), 5, 6);
+        work.phase = ecomputation_phase::REDUCTION;
+        work.priority = 2;
+        work.origin = 11;
+
+        work_unit moved(std::move(work));
+        work_unit assigned;
+        assigned = std::move(moved);
+        BOOST_CHECK(assigned.work_type == work_unit::ework_type::TASK_WORK);
+        BOOST_CHECK_EQUAL(assigned.data, "payload");
+        BOOST_CHECK_EQUAL(assigned.type_name, "type");
+        BOOST_CHECK_EQUAL(assigned.locale.rank, 3u);
+        BOOST_CHECK_EQUAL(assigned.locale.hostname, "host");
+        BOOST_CHECK_EQUAL(assigned.index_to, 5u);
+        BOOST_CHECK_EQUAL(assigned.index_from, 6u);
+        BOOST_CHECK(assigned.phase == ecomputation_phase::REDUCTION);
+        BOOST_CHECK_EQUAL(assigned.priority, 2);
+        BOOST_CHECK_EQUAL(assigned.origin, 11u);
+
+        // long payload is not copied
+        work.data = std::string(100, 'x');
+        const char* payload = work.data.data();
+        assigned = std::move(work);
+        BOOST_CHECK_EQUAL(static_cast<const void*>(assigned.data.data()), static_cast<const void*>(payload));
+    }
+
+    BOOST_AUTO_TEST_CASE(payload_test) {
+
+        payload small(std::string("small"));
+        BOOST_CHECK(!small.on_heap());
+        payload large(std::string(100, 'x'));
+        BOOST_CHECK(large.on_heap());
+        BOOST_CHECK(small != large);
+
+        // heap buffer is kept for following payloads
+        const char* buffer = large.data();
+        large = std::string("small");
+        BOOST_CHECK_EQUAL(large, small);
+        large = std::string(50, 'y');
+        BOOST_CHECK_EQUAL(static_cast<const void*>(large.data()), static_cast<const void*>(buffer));
+
+        payload moved(std::move(small));
+        BOOST_CHECK_EQUAL(moved, "small");
+        BOOST_CHECK(small.empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(scalar_serialization) {
+
+        using serialization::operator<<;
+        using serialization::operator>>;
+
+        payload data;
+        data << 3.5;
+        BOOST_CHECK_EQUAL(data.size(), sizeof(double));
+        double d;
+        data >> d;
+        BOOST_CHECK_EQUAL(d, 3.5);
+
+        int i;
+        BOOST_CHECK_THROW(data >> i, serialization::serialization_exception);
+
+        // other types go through archives
+        tuple_wrapper tw;
+        tw.tp = std::make_tuple(1, 2, 'c');
+        data << tw;
+        tuple_wrapper tw_d;
+        data >> tw_d;
+        BOOST_CHECK(tw.tp == tw_d.tp);
     }
 
     BOOST_AUTO_TEST_CASE(custom_type_serialization) {
@@ -97,6 +190,38 @@ BOOST_AUTO_TEST_SUITE(serialization_test)
         BOOST_CHECK(std::get<2>(t) == std::get<2>(tw_d.tp));
     }
 
+    BOOST_AUTO_TEST_CASE(chunk_serialization) {
+
+        std::vector<int> numbers = { 1, 2, 3, 4, 5 };
+        work_unit work;
+        work.work_type = work_unit::ework_type::INPUT_WORK;
+        work.type_name = typeid(int).name();
+        serialization::write_chunk(work.data, numbers.data(), numbers.size());
+        work.chunk = true;
+
+        // flag travels with work
+        message mes;
+        mes << work;
+        work_unit received;
+        received << mes;
+        BOOST_CHECK(received.chunk);
+        BOOST_CHECK_EQUAL(serialization::chunk_size(received.data), 5u);
+
+        std::vector<int> buffer;
+        span<const int> read = serialization::read_chunk(received.data, buffer);
+        BOOST_CHECK_EQUAL_COLLECTIONS(read.begin(), read.end(), numbers.begin(), numbers.end());
+
+        // other types are archived all at once
+        std::vector<std::string> words = { "one", "", "three" };
+        serialization::write_chunk(work.data, words.data(), words.size());
+        std::vector<std::string> read_words;
+        span<const std::string> read_span = serialization::read_chunk(work.data, read_words);
+        BOOST_CHECK_EQUAL_COLLECTIONS(read_span.begin(), read_span.end(), words.begin(), words.end());
+
+        std::vector<double> doubles;
+        BOOST_CHECK_THROW(serialization::read_chunk(received.data, doubles), serialization::serialization_exception);
+    }
+
 BOOST_AUTO_TEST_SUITE_END ( )
 
 // this class has a default constructor
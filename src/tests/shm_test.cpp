@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE shm_test
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
+#include "../shm.hpp"
+
+using namespace dj;
+
+namespace {
+    struct ring_memory {
+        ring_memory(std::size_t capacity)
+            : memory(shm_ring::footprint(capacity)/64 + 1) {
+            shm_ring::create(memory.data(), capacity);
+        }
+
+        struct alignas(64) line { char bytes[64]; };
+        std::vector<line> memory;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(shm_test)
+
+    BOOST_AUTO_TEST_CASE(ring_test) {
+
+        ring_memory memory(64);
+        shm_ring writer(memory.memory.data(), 64);
+        shm_ring reader(memory.memory.data(), 64);
+        int tag;
+        std::string data;
+        BOOST_CHECK(!reader.read(tag, data));
+        BOOST_CHECK_THROW(shm_ring(memory.memory.data(), 128), std::runtime_error);
+
+        BOOST_CHECK(writer.write(3, "abc", 3));
+        BOOST_CHECK(writer.write(4, "", 0));
+        BOOST_CHECK(reader.read(tag, data));
+        BOOST_CHECK_EQUAL(tag, 3);
+        BOOST_CHECK_EQUAL(data, "abc");
+        BOOST_CHECK(reader.read(tag, data));
+        BOOST_CHECK_EQUAL(tag, 4);
+        BOOST_CHECK_EQUAL(data, "");
+        BOOST_CHECK(!reader.read(tag, data));
+
+        // messages wrap around the end
+        std::string long_data(30, 'x');
+        for(int i = 0; i < 10; i++) {
+            long_data[0] = 'a' + i;
+            BOOST_CHECK(writer.write(i, long_data.data(), long_data.size()));
+            BOOST_CHECK(reader.read(tag, data));
+            BOOST_CHECK_EQUAL(tag, i);
+            BOOST_CHECK_EQUAL(data, long_data);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(switch_test) {
+
+        ring_memory memory(64);
+        shm_ring ring(memory.memory.data(), 64);
+        // room for a switch is kept
+        BOOST_CHECK(ring.write(1, std::string(16, 'a').data(), 16));
+        BOOST_CHECK(ring.write(2, std::string(16, 'b').data(), 16));
+        BOOST_CHECK(!ring.fits(1));
+        BOOST_CHECK(!ring.write(3, "c", 1));
+        ring.write_switch();
+
+        int tag;
+        std::string data;
+        BOOST_CHECK(ring.read(tag, data));
+        BOOST_CHECK(ring.read(tag, data));
+        BOOST_CHECK_EQUAL(tag, 2);
+        BOOST_CHECK(ring.read(tag, data));
+        BOOST_CHECK_EQUAL(tag, ring_switch_tag);
+        BOOST_CHECK(ring.fits(16));
+    }
+
+    BOOST_AUTO_TEST_CASE(threads_test) {
+
+        const int count = 100000;
+        ring_memory memory(256);
+        shm_ring writer(memory.memory.data(), 256);
+        shm_ring reader(memory.memory.data(), 256);
+
+        std::thread producer([&]() {
+                    for(int i = 0; i < count; i++) {
+                        std::string data(i % 50, static_cast<char>(i));
+                        while(!writer.write(i, data.data(), data.size())) std::this_thread::yield();
+                    }
+                });
+        int tag;
+        std::string data;
+        bool ordered = true;
+        for(int i = 0; i < count; i++) {
+            while(!reader.read(tag, data)) std::this_thread::yield();
+            ordered = ordered && tag == i && data == std::string(i % 50, static_cast<char>(i));
+        }
+        producer.join();
+        BOOST_CHECK(ordered);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -11,6 +11,8 @@ using namespace dj;
 std::string last_string_input;
 int last_int_input;
 bool finish_handled;
+int chunks_taken;
+int chunk_sum;
 
 template <typename... Output>
     class simple_task : public base_task<Output...> {
@@ -31,6 +33,24 @@ template <typename... Output>
             }
     }; 
 
+template <typename... Output>
+    class chunk_task : public base_task<Output...> {
+
+        public:
+            chunk_task() : base_task<Output...>("chunk_task") { }
+
+            void operator()(span<const int> inputs, const std::string& from) {
+                chunks_taken++;
+                for(int input: inputs) chunk_sum += input;
+            }
+
+            void operator()(int input, const std::string& from) {
+                chunk_sum += input;
+            }
+
+            virtual void handle_finish() { }
+    }; 
+
 simple_task<std::string, int> task_instance;
 
 BOOST_AUTO_TEST_SUITE(task_test)
@@ -66,5 +86,32 @@ BOOST_AUTO_TEST_SUITE(task_test)
         BOOST_CHECK(finish_handled == true);
     }
     
+    BOOST_AUTO_TEST_CASE(chunk_test) {
+
+        std::vector<int> inputs = { 1, 2, 3, 4 };
+        work_unit work;
+        serialization::write_chunk(work.data, inputs.data(), inputs.size());
+        work.chunk = true;
+        work.type_name = typeid(int).name();
+        work.work_type = work_unit::ework_type::TASK_WORK;
+
+        static_assert(takes_chunks<chunk_task<int>, int>::value, "chunk_task takes chunks");
+        static_assert(!takes_chunks<simple_task<int>, int>::value, "simple_task takes single records");
+
+        // whole chunk at once
+        chunks_taken = 0;
+        chunk_sum = 0;
+        task<chunk_task<int>, int> chunked("chunk_task_node");
+        chunked.process_work(work, nullptr);
+        BOOST_CHECK_EQUAL(chunks_taken, 1);
+        BOOST_CHECK_EQUAL(chunk_sum, 10);
+
+        // one by one
+        last_int_input = 0;
+        task<simple_task<int, std::string>, std::string, int> single("simple_task_node");
+        single.process_work(work, nullptr);
+        BOOST_CHECK_EQUAL(last_int_input, 4);
+    }
+
 BOOST_AUTO_TEST_SUITE_END ( )
 
@@ -0,0 +1,434 @@
+#define BOOST_TEST_MODULE thread_transport_test
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <thread>
+#include "../DistributedJobs"
+
+using namespace dj;
+
+namespace {
+
+    std::atomic<int> result{ 0 };
+    std::atomic<int> outputs{ 0 };
+    std::atomic<int> inputs_seen{ 0 };
+    std::atomic<std::chrono::steady_clock::rep> lone_added{ 0 };
+    std::atomic<std::chrono::steady_clock::rep> lone_processed{ 0 };
+
+    /**
+     * Numbers 1 to 1000 split between ranks
+     */
+    class range_input : public input_provider {
+
+        public:
+            virtual void operator()() override {
+                context_info context = processor->context();
+                for(int i = context.rank + 1; i <= 1000; i += context.size) add_input(i);
+                eof_callback();
+            }
+    };
+
+    /**
+     * The same numbers handed over in chunks
+     */
+    class chunked_range_input : public input_provider {
+
+        public:
+            virtual void operator()() override {
+                context_info context = processor->context();
+                std::vector<int> chunk;
+                for(int i = context.rank + 1; i <= 1000; i += context.size) {
+                    chunk.push_back(i);
+                    if(chunk.size() == 64) {
+                        add_inputs(chunk);
+                        chunk.clear();
+                    }
+                }
+                add_inputs(chunk);
+                eof_callback();
+            }
+    };
+
+    /**
+     * Burst of records growing input chunks, then a lone one long before the end of input
+     */
+    class lone_record_input : public input_provider {
+
+        public:
+            virtual void operator()() override {
+                for(int i = 0; i < 1000; i++) add_input(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                // takes the rest of the burst along, as its time is up
+                add_input(0);
+                lone_added = std::chrono::steady_clock::now().time_since_epoch().count();
+                add_input(-1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                eof_callback();
+            }
+    };
+
+    template <typename... Output>
+        class add_task : public base_task<Output...> { };
+
+    template <>
+        class add_task<int> : public base_task<int> {
+
+            public:
+                add_task() : base_task<int>("add_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    counter += input;
+                }
+
+                virtual void handle_finish() override {
+                    emit<int, enode_type::REDUCER>(counter);
+                }
+
+            private:
+                int counter = 0;
+        };
+
+    template <typename... Output>
+        class lone_task : public base_task<Output...> { };
+
+    template <>
+        class lone_task<int> : public base_task<int> {
+
+            public:
+                lone_task() : base_task<int>("lone_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    if(input == -1) lone_processed = std::chrono::steady_clock::now().time_since_epoch().count();
+                }
+
+                virtual void handle_finish() override { }
+        };
+
+    template <typename... Output>
+        class spread_task : public base_task<Output...> { };
+
+    /**
+     * Every number goes to add task of another rank
+     */
+    template <>
+        class spread_task<int> : public base_task<int> {
+
+            public:
+                spread_task() : base_task<int>("spread_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    emit<int, enode_type::TASK>(input, "add", (rank() + 1) % world_size());
+                }
+
+                virtual void handle_finish() override { }
+        };
+
+    template <typename... Output>
+        class counting_task : public base_task<Output...> { };
+
+    /**
+     * Adds numbers and counts them in an aggregator
+     */
+    template <>
+        class counting_task<int> : public base_task<int> {
+
+            public:
+                counting_task() : base_task<int>("counting_task") { }
+
+                void operator()(int input, const std::string& /* from */) {
+                    aggregate<int>("inputs", 1);
+                    counter += input;
+                }
+
+                virtual void handle_finish() override {
+                    inputs_seen = aggregated<int>("inputs");
+                    emit<int, enode_type::REDUCER>(counter);
+                    counter = 0;
+                }
+
+            private:
+                int counter = 0;
+        };
+
+    /**
+     * Sum of the first pass goes through the pipeline once more
+     */
+    template <typename PipeInputType, typename InputType, typename OutputType>
+        class again_reducer : public base_reducer<PipeInputType, InputType, OutputType> {
+
+            public:
+                again_reducer() : base_reducer<PipeInputType, InputType, OutputType>("again_reducer") { }
+
+                virtual void reduce(const InputType& input, const std::string& /* parent */) override {
+                    accumulator += input;
+                }
+
+                virtual void collect(const OutputType& data_to_collect) override {
+                    accumulator += data_to_collect;
+                }
+
+                virtual void handle_finish() override {
+                    if(!this->is_root_reducer()) return;
+                    if(first_pass) this->pass_again(accumulator);
+                    else this->return_output(accumulator);
+                    first_pass = false;
+                    accumulator = 0;
+                }
+
+            private:
+                int accumulator = 0;
+                bool first_pass = true;
+        };
+
+    template <typename PipeInputType, typename InputType, typename OutputType>
+        class add_reducer : public base_reducer<PipeInputType, InputType, OutputType> {
+
+            public:
+                add_reducer() : base_reducer<PipeInputType, InputType, OutputType>("add_reducer") { }
+
+                virtual void reduce(const InputType& input, const std::string& /* parent */) override {
+                    accumulator += input;
+                }
+
+                virtual void collect(const OutputType& data_to_collect) override {
+                    accumulator += data_to_collect;
+                }
+
+                virtual void handle_finish() override {
+                    if(this->is_root_reducer()) this->return_output(accumulator);
+                }
+
+            private:
+                int accumulator = 0;
+        };
+
+    template <typename OutputerInput>
+        class sum_outputer : public base_outputer<OutputerInput> {
+
+            public:
+                sum_outputer() : base_outputer<OutputerInput>("sum_outputer") { }
+
+                virtual void operator()(const OutputerInput& input, const std::string& /* parent */) override {
+                    result = input;
+                    outputs++;
+                }
+
+                virtual void handle_finish() override { }
+        };
+
+    void run_sum(std::unique_ptr<exec::transport> ranks, exec::eexecution_mode mode, bool chunked = false) {
+        execution_pipeline pipe(std::unique_ptr<input_provider>(
+                    chunked ? static_cast<input_provider*>(new chunked_range_input()) : new range_input()));
+        node_graph& graph = pipe.get_node_graph();
+        uint root = graph.add(std::unique_ptr<task_node>(new task<add_task<int>, int>("add")));
+        uint sum = graph.add(std::unique_ptr<reducer_node>(
+                    new reducer<add_reducer, int, int, int>("sum", reducer_node::ereducer_type::SINGLE)));
+        uint out = graph.add(std::unique_ptr<output_node>(new outputer<sum_outputer, int>("out")));
+        graph.set_root(root);
+        graph.add_output_to_reducer(out, sum);
+        graph.add_reducer_to_task(sum, root);
+
+        exec::executor processor(std::move(ranks), pipe);
+        processor.set_execution_mode(mode);
+        processor.start();
+    }
+
+    void run_passes(std::unique_ptr<exec::transport> ranks, exec::eexecution_mode mode) {
+        execution_pipeline pipe(std::unique_ptr<input_provider>(new range_input()));
+        pipe.get_aggregators().add<int>("inputs", eaggregation::SUM);
+        node_graph& graph = pipe.get_node_graph();
+        uint root = graph.add(std::unique_ptr<task_node>(new task<counting_task<int>, int>("count")));
+        uint sum = graph.add(std::unique_ptr<reducer_node>(
+                    new reducer<again_reducer, int, int, int>("sum", reducer_node::ereducer_type::SINGLE)));
+        uint out = graph.add(std::unique_ptr<output_node>(new outputer<sum_outputer, int>("out")));
+        graph.set_root(root);
+        graph.add_output_to_reducer(out, sum);
+        graph.add_reducer_to_task(sum, root);
+
+        exec::executor processor(std::move(ranks), pipe);
+        processor.set_execution_mode(mode);
+        processor.start();
+    }
+
+    void run_lone(std::unique_ptr<exec::transport> ranks) {
+        execution_pipeline pipe(std::unique_ptr<input_provider>(new lone_record_input()));
+        node_graph& graph = pipe.get_node_graph();
+        graph.set_root(graph.add(std::unique_ptr<task_node>(new task<lone_task<int>, int>("lone"))));
+
+        exec::executor processor(std::move(ranks), pipe);
+        processor.set_target_latency(std::chrono::milliseconds(5));
+        processor.start();
+    }
+
+    /**
+     * Work of tasks is sent to other ranks with a window of a few records
+     */
+    void run_spread(std::unique_ptr<exec::transport> ranks, exec::eexecution_mode mode, bool batching) {
+        execution_pipeline pipe(std::unique_ptr<input_provider>(new range_input()));
+        node_graph& graph = pipe.get_node_graph();
+        uint root = graph.add(std::unique_ptr<task_node>(new task<spread_task<int>, int>("spread")));
+        uint add = graph.add(std::unique_ptr<task_node>(new task<add_task<int>, int>("add")));
+        uint sum = graph.add(std::unique_ptr<reducer_node>(
+                    new reducer<add_reducer, int, int, int>("sum", reducer_node::ereducer_type::SINGLE)));
+        uint out = graph.add(std::unique_ptr<output_node>(new outputer<sum_outputer, int>("out")));
+        graph.set_root(root);
+        graph.add_directed(root, add);
+        graph.add_output_to_reducer(out, sum);
+        graph.add_reducer_to_task(sum, add);
+
+        exec::executor processor(std::move(ranks), pipe);
+        processor.set_execution_mode(mode);
+        processor.set_inbound_capacity(6);
+        if(batching) processor.set_target_latency(std::chrono::milliseconds(1));
+        processor.start();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(thread_transport_test)
+
+    BOOST_AUTO_TEST_CASE(messages_test) {
+
+        exec::thread_group group(3);
+        std::atomic<int> received{ 0 };
+        group.run([&received](std::unique_ptr<exec::transport> ranks) {
+                    uint rank = ranks->rank();
+                    uint next = (rank + 1) % ranks->size();
+                    ranks->send(next, 1, std::to_string(rank), false);
+                    ranks->send(next, 2, "urgent", true);
+                    ranks->barrier();
+
+                    // urgent message is received first
+                    exec::envelope mes;
+                    while(!ranks->receive(mes)) { }
+                    if(mes.tag == 2 && mes.data == "urgent" && mes.urgent) received++;
+                    while(!ranks->receive(mes)) { }
+                    if(mes.tag == 1 && mes.source == static_cast<int>((rank + 2) % 3)
+                            && mes.data == std::to_string(mes.source)) received++;
+                });
+        BOOST_CHECK_EQUAL(received, 6);
+    }
+
+    BOOST_AUTO_TEST_CASE(collectives_test) {
+
+        exec::thread_group group(4);
+        std::atomic<int> correct{ 0 };
+        group.run([&correct](std::unique_ptr<exec::transport> ranks) {
+                    uint64_t local[2] = { ranks->rank(), 1 };
+                    uint64_t global[2];
+                    ranks->all_reduce(local, global, 2, exec::ereduce_op::SUM);
+                    bool ok = global[0] == 6 && global[1] == 4;
+                    ranks->all_reduce(local, global, 2, exec::ereduce_op::MAX);
+                    ok = ok && global[0] == 3 && global[1] == 1;
+
+                    ranks->start_all_reduce(local, global, 1, exec::ereduce_op::SUM);
+                    while(!ranks->all_reduce_done()) { }
+                    ok = ok && global[0] == 6;
+
+                    std::vector<std::string> all = ranks->gather(std::to_string(ranks->rank()));
+                    ok = ok && all.size() == (ranks->rank() == 0 ? 4u : 0u);
+                    all = ranks->all_gather(std::to_string(ranks->rank()));
+                    ok = ok && all == std::vector<std::string>({ "0", "1", "2", "3" });
+
+                    // concatenation is not commutative
+                    auto concat = [](const std::string& a, const std::string& b) { return a + b; };
+                    for(int i = 0; i < 3; i++)
+                        ok = ok && ranks->all_reduce(std::to_string(ranks->rank() + i), concat) 
+                            == std::to_string(i) + std::to_string(i + 1) + std::to_string(i + 2) + std::to_string(i + 3);
+                    ranks->barrier();
+                    if(ok) correct++;
+                });
+        BOOST_CHECK_EQUAL(correct, 4);
+    }
+
+    BOOST_AUTO_TEST_CASE(pipeline_test) {
+
+        for(auto mode: { exec::eexecution_mode::RING, exec::eexecution_mode::BSP, exec::eexecution_mode::ASYNC }) {
+            for(uint ranks: { 1, 4 }) {
+                result = 0;
+                outputs = 0;
+                exec::thread_group group(ranks);
+                group.run([mode](std::unique_ptr<exec::transport> rank) { run_sum(std::move(rank), mode); });
+                BOOST_CHECK_EQUAL(result, 500500);
+                BOOST_CHECK_EQUAL(outputs, 1);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(chunked_input_test) {
+
+        // add_task takes chunks record by record
+        for(uint ranks: { 1, 3 }) {
+            result = 0;
+            outputs = 0;
+            exec::thread_group group(ranks);
+            group.run([](std::unique_ptr<exec::transport> rank) { 
+                        run_sum(std::move(rank), exec::eexecution_mode::RING, true); 
+                    });
+            BOOST_CHECK_EQUAL(result, 500500);
+            BOOST_CHECK_EQUAL(outputs, 1);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(parked_work_test) {
+
+        // work for ranks out of credits waits in the sender
+        for(auto mode: { exec::eexecution_mode::RING, exec::eexecution_mode::BSP, exec::eexecution_mode::ASYNC }) {
+            for(bool batching: { false, true }) {
+                result = 0;
+                outputs = 0;
+                exec::thread_group group(4);
+                group.run([mode, batching](std::unique_ptr<exec::transport> rank) { 
+                            run_spread(std::move(rank), mode, batching); 
+                        });
+                BOOST_CHECK_EQUAL(result, 500500);
+                BOOST_CHECK_EQUAL(outputs, 1);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(aggregator_passes_test) {
+
+        // next pass of ring starts in one process only, aggregators are refused
+        exec::thread_group ring(3);
+        BOOST_CHECK_THROW(ring.run([](std::unique_ptr<exec::transport> rank) { 
+                        run_passes(std::move(rank), exec::eexecution_mode::RING); 
+                    }), std::runtime_error);
+
+        for(auto mode: { exec::eexecution_mode::BSP, exec::eexecution_mode::ASYNC }) {
+            for(uint ranks: { 1, 3 }) {
+                result = 0;
+                outputs = 0;
+                inputs_seen = 0;
+                exec::thread_group group(ranks);
+                group.run([mode](std::unique_ptr<exec::transport> rank) { run_passes(std::move(rank), mode); });
+                BOOST_CHECK_EQUAL(result, 500500);
+                BOOST_CHECK_EQUAL(outputs, 1);
+                // the second pass has only the sum of the first one as input
+                BOOST_CHECK_EQUAL(inputs_seen, 1);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(lone_record_test) {
+
+        // chunk of input goes on when its time is up, even if no other record comes
+        lone_added = 0;
+        lone_processed = 0;
+        exec::thread_group group(1);
+        group.run([](std::unique_ptr<exec::transport> rank) { run_lone(std::move(rank)); });
+        BOOST_REQUIRE(lone_processed != 0);
+        auto delay = std::chrono::steady_clock::duration(lone_processed - lone_added);
+        BOOST_CHECK_LT(std::chrono::duration_cast<std::chrono::milliseconds>(delay).count(), 100);
+    }
+
+    BOOST_AUTO_TEST_CASE(failure_test) {
+
+        // others waiting in a collective are released
+        exec::thread_group group(3);
+        BOOST_CHECK_THROW(group.run([](std::unique_ptr<exec::transport> ranks) {
+                        if(ranks->rank() == 1) throw std::logic_error("failed");
+                        ranks->barrier();
+                    }), std::logic_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,69 @@
+#define BOOST_TEST_MODULE trace_test
+
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include "../trace.hpp"
+
+using namespace dj;
+
+namespace {
+    uint occurrences(const std::string& text, const std::string& pattern) {
+        uint count = 0;
+        for(size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos+1)) count++;
+        return count;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(trace_test)
+
+    BOOST_AUTO_TEST_CASE(disabled_test) {
+
+        tracer trace;
+        {
+            trace_span span(trace, "work", "TASK_WORK");
+        }
+        trace.instant("phase", "REDUCTION");
+        BOOST_CHECK_EQUAL(occurrences(trace.events_json(0), "\"ph\": \"X\""), 0u);
+        BOOST_CHECK_EQUAL(occurrences(trace.events_json(0), "\"ph\": \"i\""), 0u);
+    }
+
+    BOOST_AUTO_TEST_CASE(threads_test) {
+
+        tracer trace;
+        trace.enable(4);
+        trace.set_thread_name("executor");
+        {
+            trace_span span(trace, "mpi", "send");
+            span.set_arg("bytes", 42);
+        }
+        trace.instant("phase", "REDUCTION");
+
+        std::thread other([&trace]() {
+                    trace.set_thread_name("input");
+                    for(int i = 0; i < 10; i++) trace.instant("input", "input chunk", "records", i);
+                });
+        other.join();
+
+        std::string events = trace.events_json(3);
+        BOOST_CHECK(events.find("\"name\": \"executor\"") != std::string::npos);
+        BOOST_CHECK(events.find("\"name\": \"input\"") != std::string::npos);
+        BOOST_CHECK(events.find("\"name\": \"send\", \"cat\": \"mpi\", \"ph\": \"X\", \"pid\": 3, \"tid\": 0") 
+                != std::string::npos);
+        BOOST_CHECK(events.find("\"args\": {\"bytes\": 42}") != std::string::npos);
+        BOOST_CHECK_EQUAL(occurrences(events, "\"name\": \"REDUCTION\""), 1u);
+
+        // ring buffer keeps only the last events
+        BOOST_CHECK_EQUAL(occurrences(events, "\"name\": \"input chunk\""), 4u);
+        BOOST_CHECK(events.find("\"records\": 5}") == std::string::npos);
+        BOOST_CHECK(events.find("\"records\": 9}") != std::string::npos);
+
+        std::string json = tracer::trace_json({ events, trace.events_json(4) });
+        BOOST_CHECK_EQUAL(json.find("{\"traceEvents\": ["), 0u);
+        BOOST_CHECK_EQUAL(occurrences(json, "\"process_name\""), 2u);
+
+        trace.clear();
+        BOOST_CHECK(!trace.enabled());
+        BOOST_CHECK_EQUAL(occurrences(trace.events_json(0), "\"ph\""), 1u); // only name of process
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+#define BOOST_TEST_MODULE watermark_test
+
+#include <boost/test/unit_test.hpp>
+#include "../watermark.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(watermark_test)
+
+    BOOST_AUTO_TEST_CASE(minimum_test) {
+
+        node_id task(enode_type::TASK, 1);
+        node_id output(enode_type::OUTPUT, 0);
+        node_id source(enode_type::TASK, 0);
+
+        watermark_tracker tracker;
+        tracker.set_inputs(task, { { 0, source }, { 1, source } });
+        tracker.set_inputs(output, { });
+
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 0u);
+        BOOST_CHECK_EQUAL(tracker.watermark(output), max_watermark);
+
+        // minimum of both edges
+        BOOST_CHECK(!tracker.update(task, 0, source, 10));
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 0u);
+        BOOST_CHECK(tracker.update(task, 1, source, 5));
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 5u);
+        BOOST_CHECK(tracker.update(task, 1, source, 20));
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 10u);
+
+        // watermarks never go back and unknown edges are ignored
+        BOOST_CHECK(!tracker.update(task, 0, source, 3));
+        BOOST_CHECK(!tracker.update(task, 2, source, 30));
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 10u);
+
+        BOOST_CHECK(tracker.update(task, 0, source, max_watermark));
+        BOOST_CHECK_EQUAL(tracker.watermark(task), 20u);
+
+        BOOST_CHECK_THROW(tracker.update(node_id(enode_type::REDUCER, 0), 0, source, 1), std::runtime_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
@@ -0,0 +1,91 @@
+#define BOOST_TEST_MODULE window_test
+
+#include <boost/test/unit_test.hpp>
+#include "../window.hpp"
+
+using namespace dj;
+
+BOOST_AUTO_TEST_SUITE(window_test)
+
+    BOOST_AUTO_TEST_CASE(assignment_test) {
+
+        auto tumbling = window_spec::tumbling(10).windows_for(25);
+        BOOST_REQUIRE_EQUAL(tumbling.size(), 1u);
+        BOOST_CHECK(tumbling[0] == (window{ 20, 30 }));
+
+        auto sliding = window_spec::sliding(10, 5).windows_for(12);
+        BOOST_REQUIRE_EQUAL(sliding.size(), 2u);
+        BOOST_CHECK(sliding[0] == (window{ 5, 15 }));
+        BOOST_CHECK(sliding[1] == (window{ 10, 20 }));
+
+        // no windows before zero
+        auto first = window_spec::sliding(10, 5).windows_for(3);
+        BOOST_REQUIRE_EQUAL(first.size(), 1u);
+        BOOST_CHECK(first[0] == (window{ 0, 10 }));
+
+        BOOST_CHECK_THROW(window_spec::sliding(5, 10), std::runtime_error);
+        BOOST_CHECK_THROW(window_spec::tumbling(0), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(closing_test) {
+
+        window_store store(window_spec::sliding(10, 5));
+        std::vector<window> closed;
+        auto on_close = [&](const window& w) {
+            closed.push_back(w);
+            BOOST_CHECK_EQUAL(*static_cast<int*>(store.state_for(w)), 1);
+        };
+
+        for(uint64_t t: { 1, 7, 12 }) {
+            BOOST_CHECK(store.assign(t));
+            for(const window& w: store.current()) {
+                void*& state = store.state_for(w);
+                if(state == nullptr) state = store.arena_for(w).make<int>(1);
+            }
+        }
+        BOOST_CHECK_EQUAL(store.open_count(), 3u);
+
+        store.close_until(12, on_close);
+        BOOST_REQUIRE_EQUAL(closed.size(), 1u);
+        BOOST_CHECK(closed[0] == (window{ 0, 10 }));
+
+        // [0, 10) is closed, [5, 15) is still open
+        BOOST_CHECK(store.assign(8));
+        BOOST_REQUIRE_EQUAL(store.current().size(), 1u);
+        BOOST_CHECK(store.current()[0] == (window{ 5, 15 }));
+
+        store.close_until(20, on_close);
+        BOOST_CHECK(!store.assign(3)); // late
+        BOOST_CHECK_THROW(store.arena_for({ 0, 10 }), std::runtime_error);
+
+        store.close_all(on_close);
+        BOOST_CHECK_EQUAL(closed.size(), 3u);
+        BOOST_CHECK_EQUAL(store.open_count(), 0u);
+        BOOST_CHECK(store.assign(3)); // from scratch after closing all
+    }
+
+    BOOST_AUTO_TEST_CASE(arena_test) {
+
+        arena ar(64);
+        std::vector<int, arena_allocator<int>> values{ arena_allocator<int>(ar) };
+        for(int i = 0; i < 100; i++) values.push_back(i);
+        BOOST_CHECK_EQUAL(values[99], 99);
+        BOOST_CHECK(ar.allocated() >= 100*sizeof(int));
+
+        int destroyed = 0;
+        struct counted {
+            int* destroyed;
+            ~counted() { (*destroyed)++; }
+        };
+        ar.make<counted>(counted{ &destroyed });
+        ar.make<counted>(counted{ &destroyed });
+        int moved_from = destroyed;
+
+        values.clear();
+        values.shrink_to_fit();
+        ar.release();
+        BOOST_CHECK_EQUAL(destroyed - moved_from, 2);
+        BOOST_CHECK_EQUAL(ar.allocated(), 0u);
+    }
+
+BOOST_AUTO_TEST_SUITE_END ( )
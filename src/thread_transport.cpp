@@ -0,0 +1,267 @@
+#include "thread_transport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <boost/lockfree/queue.hpp>
+
+namespace dj {
+
+    namespace exec {
+
+        namespace {
+            const uint channels_count = 2; // normal and urgent
+            const std::size_t queue_capacity = 1024;
+
+            std::string to_bytes(const uint64_t* values, uint count) {
+                return std::string(reinterpret_cast<const char*>(values), count*sizeof(uint64_t));
+            }
+
+            void reduce(const std::vector<std::string>& all, uint64_t* global, uint count, ereduce_op op) {
+                std::vector<uint64_t> values(count);
+                for(uint r = 0; r < all.size(); r++) {
+                    std::memcpy(values.data(), all[r].data(), count*sizeof(uint64_t));
+                    for(uint i = 0; i < count; i++) {
+                        if(r == 0) global[i] = values[i];
+                        else global[i] = (op == ereduce_op::SUM) ? global[i] + values[i] : std::max(global[i], values[i]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * State shared by ranks of a group. Collective of generation g uses slots g%2, which are
+         * written again only after every rank came to the next collective and so read its result.
+         * Envelopes are recycled, so that their buffers are allocated once.
+         */
+        struct thread_hub {
+
+            explicit thread_hub(uint ranks) : ranks(ranks) {
+                for(uint i = 0; i < ranks*channels_count; i++)
+                    queues.emplace_back(new boost::lockfree::queue<envelope*>(queue_capacity));
+                for(auto& s: slots) s.resize(ranks);
+            }
+
+            ~thread_hub() {
+                envelope* mes;
+                for(auto& queue: queues) while(queue->pop(mes)) delete mes;
+                while(spare.pop(mes)) delete mes;
+            }
+
+            envelope* make_envelope() {
+                envelope* mes;
+                if(!spare.pop(mes)) mes = new envelope;
+                return mes;
+            }
+
+            boost::lockfree::queue<envelope*>& queue(uint rank, uint channel) {
+                return *queues[rank*channels_count + channel];
+            }
+
+            uint64_t arrive(uint rank, const std::string& data) {
+                std::lock_guard<std::mutex> lock(mutex);
+                uint64_t current = generation;
+                slots[current % 2][rank] = data;
+                if(++arrived == ranks) {
+                    arrived = 0;
+                    generation++;
+                    all_arrived.notify_all();
+                }
+                return current;
+            }
+
+            bool done(uint64_t of) {
+                std::lock_guard<std::mutex> lock(mutex);
+                check();
+                return generation != of;
+            }
+
+            std::vector<std::string> wait(uint64_t of) {
+                std::unique_lock<std::mutex> lock(mutex);
+                all_arrived.wait(lock, [this, of]() { return generation != of || aborted; });
+                check();
+                return slots[of % 2];
+            }
+
+            std::vector<std::string> result(uint64_t of) {
+                std::lock_guard<std::mutex> lock(mutex);
+                return slots[of % 2];
+            }
+
+            /**
+             * Data of all ranks is combined in order of ranks once, by the first rank to ask for it
+             */
+            std::string fold(uint64_t of, const data_combiner& combine) {
+                std::unique_lock<std::mutex> lock(mutex);
+                all_arrived.wait(lock, [this, of]() { return generation != of || aborted; });
+                check();
+                if(folded_of[of % 2] != of) {
+                    const std::vector<std::string>& all = slots[of % 2];
+                    std::string combined = all[0];
+                    for(uint r = 1; r < ranks; r++) combined = combine(combined, all[r]);
+                    folded[of % 2] = std::move(combined);
+                    folded_of[of % 2] = of;
+                }
+                return folded[of % 2];
+            }
+
+            void abort() {
+                std::lock_guard<std::mutex> lock(mutex);
+                aborted = true;
+                all_arrived.notify_all();
+            }
+
+            void check() const {
+                if(aborted) throw std::runtime_error("Other rank of thread group failed");
+            }
+
+            const uint ranks;
+            std::vector<std::unique_ptr<boost::lockfree::queue<envelope*>>> queues; // for each rank and channel
+            boost::lockfree::queue<envelope*> spare{ queue_capacity };
+            std::atomic<bool> aborted{ false };
+
+            std::mutex mutex;
+            std::condition_variable all_arrived;
+            uint arrived = 0;
+            uint64_t generation = 0;
+            std::vector<std::string> slots[2];
+            std::string folded[2];
+            uint64_t folded_of[2] = { ~0ull, ~0ull }; // generation folded into each slot
+        };
+
+        namespace {
+
+            class thread_transport : public transport {
+
+                public:
+                    thread_transport(std::shared_ptr<thread_hub> hub, uint rank)
+                        : hub(std::move(hub)), _rank(rank)
+                    { }
+
+                    uint rank() const override {
+                        return _rank;
+                    }
+
+                    uint size() const override {
+                        return hub->ranks;
+                    }
+
+                    void send(uint to, int tag, const std::string& data, bool urgent) override {
+                        envelope* mes = hub->make_envelope();
+                        mes->source = _rank;
+                        mes->tag = tag;
+                        mes->data.assign(data);
+                        mes->has_work = false;
+                        mes->urgent = urgent;
+                        hub->queue(to, urgent ? 1 : 0).push(mes);
+                    }
+
+                    bool pass(uint to, work_unit& work, bool urgent) override {
+                        envelope* mes = hub->make_envelope();
+                        mes->source = _rank;
+                        mes->tag = static_cast<int>(work.work_type);
+                        mes->data.clear();
+                        mes->has_work = true;
+                        mes->work = std::move(work);
+                        mes->urgent = urgent;
+                        hub->queue(to, urgent ? 1 : 0).push(mes);
+                        return true;
+                    }
+
+                    bool receive(envelope& mes) override {
+                        if(hub->aborted) hub->check();
+                        envelope* next;
+                        for(uint channel: { 1, 0 }) {
+                            if(!hub->queue(_rank, channel).pop(next)) continue;
+                            std::swap(mes, *next);
+                            hub->spare.push(next);
+                            return true;
+                        }
+                        return false;
+                    }
+
+                    void barrier() override {
+                        hub->wait(hub->arrive(_rank, std::string()));
+                    }
+
+                    void all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) override {
+                        reduce(hub->wait(hub->arrive(_rank, to_bytes(local, count))), global, count, op);
+                    }
+
+                    void start_all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) override {
+                        reduction = hub->arrive(_rank, to_bytes(local, count));
+                        reduced = global;
+                        reduced_count = count;
+                        reduce_op = op;
+                    }
+
+                    bool all_reduce_done() override {
+                        if(!hub->done(reduction)) return false;
+                        reduce(hub->result(reduction), reduced, reduced_count, reduce_op);
+                        return true;
+                    }
+
+                    std::string all_reduce(const std::string& data, const data_combiner& combine) override {
+                        return hub->fold(hub->arrive(_rank, data), combine);
+                    }
+
+                    std::vector<std::string> gather(const std::string& data) override {
+                        std::vector<std::string> all = all_gather(data);
+                        if(_rank != 0) all.clear();
+                        return all;
+                    }
+
+                    std::vector<std::string> all_gather(const std::string& data) override {
+                        return hub->wait(hub->arrive(_rank, data));
+                    }
+
+                private:
+                    std::shared_ptr<thread_hub> hub;
+                    uint _rank;
+
+                    // pending start_all_reduce
+                    uint64_t reduction = 0;
+                    uint64_t* reduced = nullptr;
+                    uint reduced_count = 0;
+                    ereduce_op reduce_op = ereduce_op::SUM;
+            };
+        }
+
+        thread_group::thread_group(uint ranks)
+            : hub(std::make_shared<thread_hub>(std::max(ranks, 1u)))
+        { }
+
+        uint thread_group::size() const {
+            return hub->ranks;
+        }
+
+        std::unique_ptr<transport> thread_group::rank_transport(uint rank) {
+            if(rank >= hub->ranks) throw std::runtime_error("No rank " + std::to_string(rank) + " in thread group");
+            return std::unique_ptr<transport>(new thread_transport(hub, rank));
+        }
+
+        void thread_group::run(const std::function<void(std::unique_ptr<transport>)>& body) {
+            std::exception_ptr failure;
+            std::mutex failure_mutex;
+            std::vector<std::thread> threads;
+            for(uint r = 0; r < hub->ranks; r++) {
+                threads.emplace_back([this, r, &body, &failure, &failure_mutex]() {
+                            try {
+                                body(rank_transport(r));
+                            } catch(...) {
+                                std::lock_guard<std::mutex> lock(failure_mutex);
+                                if(!failure) failure = std::current_exception();
+                                hub->abort();
+                            }
+                        });
+            }
+            for(auto& t: threads) t.join();
+            if(failure) std::rethrow_exception(failure);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef THREAD_TRANSPORT_HPP
+#define THREAD_TRANSPORT_HPP
+
+#include <functional>
+#include <memory>
+#include "transport.hpp"
+
+namespace dj {
+
+    namespace exec {
+
+        struct thread_hub;
+
+        /**
+         * Ranks running as threads of one process, without MPI. Messages and work go between them
+         * by pointer through lock-free queues, collectives meet in slots shared by all ranks.
+         * Every rank needs its own pipeline and executor, constructed on its thread.
+         */
+        class thread_group {
+
+            public:
+                explicit thread_group(uint ranks);
+
+                uint size() const;
+                std::unique_ptr<transport> rank_transport(uint rank);
+
+                /**
+                 * Runs body with transport of every rank on its own thread and waits for all of them.
+                 * When a rank throws, receives and collectives of the others throw too
+                 * and the first exception is rethrown.
+                 */
+                void run(const std::function<void(std::unique_ptr<transport>)>& body);
+
+            private:
+                std::shared_ptr<thread_hub> hub;
+        };
+    }
+}
+
+#endif
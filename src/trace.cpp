@@ -0,0 +1,142 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+namespace dj {
+
+    namespace {
+
+        std::atomic<uint64_t> generations{ 0 };
+
+        struct thread_cache {
+            const void* owner = nullptr;
+            uint64_t generation = 0;
+            void* buffer = nullptr;
+        };
+
+        thread_local thread_cache cache;
+
+        void write_us(std::ostream& os, int64_t epoch_us, uint64_t ns) {
+            os << epoch_us + ns/1000 << '.' << std::setw(3) << std::setfill('0') << ns%1000;
+        }
+    }
+
+    void tracer::enable(uint capacity) {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        this->capacity = std::max(capacity, 1u);
+        generation = ++generations;
+        buffers.clear();
+        epoch = std::chrono::steady_clock::now();
+        epoch_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        _enabled.store(true, std::memory_order_release);
+    }
+
+    bool tracer::enabled() const {
+        return _enabled.load(std::memory_order_acquire);
+    }
+
+    void tracer::clear() {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        _enabled = false;
+        generation = ++generations;
+        buffers.clear();
+    }
+
+    tracer::thread_buffer& tracer::buffer() {
+        if(cache.owner != this || cache.generation != generation) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers.emplace_back(new thread_buffer());
+            buffers.back()->events.resize(capacity);
+            cache.owner = this;
+            cache.generation = generation;
+            cache.buffer = buffers.back().get();
+        }
+        return *static_cast<thread_buffer*>(cache.buffer);
+    }
+
+    void tracer::set_thread_name(const std::string& name) {
+        if(!enabled()) return;
+        buffer().name = name;
+    }
+
+    uint64_t tracer::now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void tracer::add(const event& e) {
+        thread_buffer& buf = buffer();
+        buf.events[buf.written++ % capacity] = e;
+    }
+
+    void tracer::complete(const char* category, const char* name, uint64_t start, const char* arg_name, int64_t arg) {
+        if(!enabled()) return;
+        add({ category, name, start, now() - start, false, arg_name, arg });
+    }
+
+    void tracer::instant(const char* category, const char* name, const char* arg_name, int64_t arg) {
+        if(!enabled()) return;
+        add({ category, name, now(), 0, true, arg_name, arg });
+    }
+
+    std::string tracer::events_json(int pid) const {
+
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        std::ostringstream os;
+        os << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+            << ", \"args\": {\"name\": \"rank " << pid << "\"}}";
+
+        for(uint tid = 0; tid < buffers.size(); tid++) {
+            const thread_buffer& buf = *buffers[tid];
+            if(!buf.name.empty()) {
+                os << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << tid
+                    << ", \"args\": {\"name\": \"" << buf.name << "\"}}";
+            }
+            // the oldest events were overwritten
+            uint64_t first = (buf.written > capacity) ? buf.written - capacity : 0;
+            for(uint64_t i = first; i < buf.written; i++) {
+                const event& e = buf.events[i % capacity];
+                os << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \""
+                    << (e.instant ? "i" : "X") << "\", \"pid\": " << pid << ", \"tid\": " << tid << ", \"ts\": ";
+                write_us(os, epoch_us, e.start);
+                if(e.instant) {
+                    os << ", \"s\": \"t\"";
+                } else {
+                    os << ", \"dur\": ";
+                    write_us(os, 0, e.duration);
+                }
+                if(e.arg_name) os << ", \"args\": {\"" << e.arg_name << "\": " << e.arg << "}";
+                os << "}";
+            }
+        }
+        return os.str();
+    }
+
+    std::string tracer::trace_json(const std::vector<std::string>& events) {
+        std::string result = "{\"traceEvents\": [\n";
+        for(uint i = 0; i < events.size(); i++) {
+            if(i) result += ",\n";
+            result += events[i];
+        }
+        result += "\n]}\n";
+        return result;
+    }
+
+    trace_span::trace_span(tracer& trace, const char* category, const char* name)
+        : trace(trace), category(category), name(name)
+    {
+        if(trace.enabled()) start = trace.now();
+    }
+
+    trace_span::~trace_span() {
+        if(trace.enabled()) trace.complete(category, name, start, arg_name, arg);
+    }
+
+    void trace_span::set_arg(const char* name, int64_t value) {
+        arg_name = name;
+        arg = value;
+    }
+}
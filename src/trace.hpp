@@ -0,0 +1,107 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dj {
+
+    /**
+     * Records spans into ring buffers of threads and writes them in Chrome trace event format
+     * (chrome://tracing, Perfetto). Every thread keeps only its last capacity events.
+     * Names and categories have to be string literals, only pointers are stored.
+     */
+    class tracer {
+
+        public:
+            /**
+             * Has to be called before threads start recording
+             */
+            void enable(uint capacity = 1 << 16);
+            bool enabled() const;
+            /**
+             * Drops all events and disables tracing, has to be called while no thread records
+             */
+            void clear();
+
+            /**
+             * Names the track of the calling thread
+             */
+            void set_thread_name(const std::string& name);
+
+            /**
+             * @return nanoseconds since tracer was enabled
+             */
+            uint64_t now() const;
+            void complete(const char* category, const char* name, uint64_t start,
+                    const char* arg_name = nullptr, int64_t arg = 0);
+            void instant(const char* category, const char* name, const char* arg_name = nullptr, int64_t arg = 0);
+
+            /**
+             * @param pid track of process (its rank), every thread has own track inside
+             * @return comma separated events without enclosing array
+             */
+            std::string events_json(int pid) const;
+            /**
+             * @return trace file made of outputs of events_json
+             */
+            static std::string trace_json(const std::vector<std::string>& events);
+
+        private:
+            struct event {
+                const char* category;
+                const char* name;
+                uint64_t start;
+                uint64_t duration;
+                bool instant;
+                const char* arg_name;
+                int64_t arg;
+            };
+
+            struct thread_buffer {
+                std::string name;
+                std::vector<event> events;
+                uint64_t written = 0;
+            };
+
+            thread_buffer& buffer();
+            void add(const event& e);
+
+            // read by every recording thread, enable publishes settings below with it
+            std::atomic<bool> _enabled{ false };
+            uint capacity = 0;
+            uint64_t generation = 0; // buffers of threads are created again after clear
+            std::chrono::steady_clock::time_point epoch;
+            int64_t epoch_us = 0; // wall clock of epoch, so that tracks of processes line up
+
+            mutable std::mutex buffers_mutex;
+            std::vector<std::unique_ptr<thread_buffer>> buffers;
+    };
+
+    /**
+     * Complete event from construction to destruction, nothing is recorded when tracing is off
+     */
+    class trace_span {
+
+        public:
+            trace_span(tracer& trace, const char* category, const char* name);
+            ~trace_span();
+
+            void set_arg(const char* name, int64_t value);
+
+        private:
+            tracer& trace;
+            const char* category;
+            const char* name;
+            uint64_t start = 0;
+            const char* arg_name = nullptr;
+            int64_t arg = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "message.hpp"
+#include "trace.hpp"
+
+namespace dj {
+
+    namespace exec {
+
+        /**
+         * Message taken from transport, work of rank in the same process comes as it is
+         */
+        struct envelope {
+            int source = 0;
+            int tag = 0;
+            std::string data;
+            bool has_work = false;
+            bool urgent = false; // came on the channel of urgent messages
+            work_unit work; // if has_work, tag is its type and data is empty
+        };
+
+        enum class ereduce_op {
+            SUM,
+            MAX
+        };
+
+        typedef std::function<std::string(const std::string&, const std::string&)> data_combiner;
+
+        /**
+         * Moves messages of executor between ranks. Point to point operations never wait for the receiver,
+         * urgent messages go on their own channel and are received before others, order of messages
+         * between two ranks is kept on every channel. Collectives have to be called by all ranks in the same order
+         * and never mix with point to point messages.
+         */
+        class transport {
+
+            public:
+                virtual ~transport() = default;
+
+                virtual uint rank() const = 0;
+                virtual uint size() const = 0;
+
+                /**
+                 * Called at the beginning of every run of executor, collective
+                 */
+                virtual void start() { }
+                /**
+                 * Called at the end of every run of executor, messages sent so far are delivered
+                 */
+                virtual void finish() { }
+                /**
+                 * Lets processes of one host exchange messages through shared memory, if transport crosses processes
+                 */
+                virtual void set_shared_memory(bool /* enabled */, std::size_t /* ring_size */) { }
+                /**
+                 * Moves communication to its own thread, if transport needs to be progressed
+                 */
+                virtual void set_progress_thread(bool /* enabled */) { }
+                void set_tracer(tracer* trace) { this->trace = trace; }
+
+                virtual void send(uint to, int tag, const std::string& data, bool urgent) = 0;
+                /**
+                 * Work goes to rank of the same process as it is
+                 * @return false if it has to be serialized and sent instead
+                 */
+                virtual bool pass(uint /* to */, work_unit& /* work */, bool /* urgent */) { return false; }
+                /**
+                 * @return false if no message came
+                 */
+                virtual bool receive(envelope& mes) = 0;
+
+                virtual void barrier() = 0;
+                virtual void all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) = 0;
+                /**
+                 * Non blocking all_reduce, global is written once all_reduce_done returns true
+                 */
+                virtual void start_all_reduce(const uint64_t* local, uint64_t* global, uint count, ereduce_op op) = 0;
+                virtual bool all_reduce_done() = 0;
+                /**
+                 * Data of all ranks combined in order of ranks, combine has to be associative
+                 * @return combined data on every rank
+                 */
+                virtual std::string all_reduce(const std::string& data, const data_combiner& combine) = 0;
+                /**
+                 * @return data of all ranks on the first one, nothing on others
+                 */
+                virtual std::vector<std::string> gather(const std::string& data) = 0;
+                virtual std::vector<std::string> all_gather(const std::string& data) = 0;
+
+            protected:
+                tracer* trace = nullptr;
+        };
+    }
+}
+
+#endif
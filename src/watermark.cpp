@@ -0,0 +1,48 @@
+#include "watermark.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dj {
+
+    void watermark_tracker::set_inputs(const node_id& node, const std::vector<std::pair<uint, node_id>>& inputs) {
+        if(states.find(node) == end(states)) _nodes.push_back(node);
+        node_state& state = states[node];
+        state.inputs.clear();
+        for(auto& in: inputs) state.inputs[in] = 0;
+        state.watermark = inputs.empty() ? max_watermark : 0;
+    }
+
+    bool watermark_tracker::update(const node_id& node, uint from_rank, const node_id& from, uint64_t watermark) {
+
+        auto st = states.find(node);
+        if(st == end(states))
+            throw std::runtime_error("No watermark inputs set for node: " + std::to_string(node.second));
+        node_state& state = st->second;
+
+        auto in = state.inputs.find(std::make_pair(from_rank, from));
+        if(in == end(state.inputs)) return false; // not tracked edge (e.g. closing a cycle)
+        if(watermark <= in->second) return false;
+        in->second = watermark;
+
+        uint64_t minimum = max_watermark;
+        for(auto& p: state.inputs) minimum = std::min(minimum, p.second);
+        if(minimum <= state.watermark) return false;
+        state.watermark = minimum;
+        return true;
+    }
+
+    uint64_t watermark_tracker::watermark(const node_id& node) const {
+        auto st = states.find(node);
+        return (st == end(states)) ? 0 : st->second.watermark;
+    }
+
+    const std::vector<node_id>& watermark_tracker::nodes() const {
+        return _nodes;
+    }
+
+    void watermark_tracker::clear() {
+        states.clear();
+        _nodes.clear();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef WATERMARK_HPP
+#define WATERMARK_HPP
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include "node.hpp"
+
+namespace dj {
+
+    typedef std::pair<enode_type, uint> node_id;
+
+    /**
+     * Source of watermarks emitted by input provider of a process
+     */
+    const node_id input_source = { enode_type::TASK, std::numeric_limits<uint>::max() };
+
+    const uint64_t max_watermark = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * Watermarks of nodes of this process. Watermark of a node is the minimum
+     * of the last watermarks received on each of its incoming edges (rank and node they came from).
+     */
+    class watermark_tracker {
+
+        public:
+            /**
+             * Node waits for watermarks from all of given edges, without any it is at max_watermark
+             */
+            void set_inputs(const node_id& node, const std::vector<std::pair<uint, node_id>>& inputs);
+
+            /**
+             * @return true if watermark of the node advanced
+             */
+            bool update(const node_id& node, uint from_rank, const node_id& from, uint64_t watermark);
+
+            uint64_t watermark(const node_id& node) const;
+            const std::vector<node_id>& nodes() const;
+            void clear();
+
+        private:
+            struct node_state {
+                std::map<std::pair<uint, node_id>, uint64_t> inputs;
+                uint64_t watermark = 0;
+            };
+
+            std::unordered_map<node_id, node_state> states;
+            std::vector<node_id> _nodes;
+    };
+}
+
+#endif
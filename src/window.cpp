@@ -0,0 +1,144 @@
+#include "window.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dj {
+
+    bool window::contains(uint64_t event_time) const {
+        return start <= event_time && event_time < end;
+    }
+
+    bool window::operator==(const window& other) const {
+        return start == other.start && end == other.end;
+    }
+
+    bool window::operator!=(const window& other) const {
+        return !(*this == other);
+    }
+
+    window_spec::window_spec(uint64_t size, uint64_t slide) : _size(size), _slide(slide) {
+        if(size == 0 || slide == 0 || slide > size)
+            throw std::runtime_error("Window slide has to be positive and not greater than its size");
+    }
+
+    window_spec window_spec::tumbling(uint64_t size) {
+        return window_spec(size, size);
+    }
+
+    window_spec window_spec::sliding(uint64_t size, uint64_t slide) {
+        return window_spec(size, slide);
+    }
+
+    window_spec& window_spec::allow_lateness(uint64_t lateness) {
+        _lateness = lateness;
+        return *this;
+    }
+
+    std::vector<window> window_spec::windows_for(uint64_t event_time) const {
+        std::vector<window> windows;
+        for(uint64_t start = event_time - event_time%_slide; start + _size > event_time; start -= _slide) {
+            windows.push_back({ start, start + _size });
+            if(start < _slide) break;
+        }
+        std::reverse(begin(windows), end(windows));
+        return windows;
+    }
+
+    uint64_t window_spec::size() const {
+        return _size;
+    }
+
+    uint64_t window_spec::slide() const {
+        return _slide;
+    }
+
+    uint64_t window_spec::lateness() const {
+        return _lateness;
+    }
+
+    window_store::window_store(window_spec spec) : _spec(std::move(spec)) { }
+
+    bool window_store::assign(uint64_t event_time) {
+
+        _current.clear();
+        _max_event_time = std::max(_max_event_time, event_time);
+        for(const window& w: _spec.windows_for(event_time)) {
+            if(w.end <= _closed_until) continue; // already closed
+
+            auto it = open.find(w.start);
+            if(it == end(open)) {
+                open_window ow;
+                ow.w = w;
+                if(!spare.empty()) {
+                    ow.memory = std::move(spare.back());
+                    spare.pop_back();
+                } else {
+                    ow.memory.reset(new arena());
+                }
+                open.emplace(w.start, std::move(ow));
+            }
+            _current.push_back(w);
+        }
+        return !_current.empty();
+    }
+
+    const std::vector<window>& window_store::current() const {
+        return _current;
+    }
+
+    window_store::open_window& window_store::find(const window& w) {
+        auto it = open.find(w.start);
+        if(it == end(open) || it->second.w != w)
+            throw std::runtime_error("Window [" + std::to_string(w.start) + ", "
+                    + std::to_string(w.end) + ") is not open");
+        return it->second;
+    }
+
+    arena& window_store::arena_for(const window& w) {
+        return *find(w).memory;
+    }
+
+    void*& window_store::state_for(const window& w) {
+        return find(w).state;
+    }
+
+    void window_store::close(std::map<uint64_t, open_window>::iterator it,
+            const std::function<void(const window&)>& on_close)
+    {
+        on_close(it->second.w);
+        it->second.memory->release();
+        if(spare.size() < 8) spare.push_back(std::move(it->second.memory));
+        open.erase(it);
+    }
+
+    void window_store::close_until(uint64_t time, const std::function<void(const window&)>& on_close) {
+        if(time <= _closed_until) return;
+        _closed_until = time;
+        // all windows are of the same size - ordered by start they are ordered by end as well
+        while(!open.empty() && begin(open)->second.w.end <= time) close(begin(open), on_close);
+    }
+
+    void window_store::close_all(const std::function<void(const window&)>& on_close) {
+        while(!open.empty()) close(begin(open), on_close);
+        _current.clear();
+        _closed_until = 0;
+        _max_event_time = 0;
+    }
+
+    uint64_t window_store::closed_until() const {
+        return _closed_until;
+    }
+
+    uint64_t window_store::max_event_time() const {
+        return _max_event_time;
+    }
+
+    std::size_t window_store::open_count() const {
+        return open.size();
+    }
+
+    const window_spec& window_store::spec() const {
+        return _spec;
+    }
+}
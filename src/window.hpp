@@ -0,0 +1,126 @@
+#ifndef WINDOW_HPP
+#define WINDOW_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "arena.hpp"
+
+namespace dj {
+
+    /**
+     * Range of event time [start, end)
+     */
+    struct window {
+        uint64_t start;
+        uint64_t end;
+
+        bool contains(uint64_t event_time) const;
+        bool operator==(const window& other) const;
+        bool operator!=(const window& other) const;
+    };
+
+    class window_spec {
+
+        public:
+            /**
+             * Windows of given size following one another
+             */
+            static window_spec tumbling(uint64_t size);
+            /**
+             * Windows of given size started every slide, record belongs to size/slide of them
+             */
+            static window_spec sliding(uint64_t size, uint64_t slide);
+
+            /**
+             * Window is closed when event time lateness past its end is seen,
+             * records arriving out of order within that time are still accepted
+             */
+            window_spec& allow_lateness(uint64_t lateness);
+
+            /**
+             * @return windows containing event time ordered by start
+             */
+            std::vector<window> windows_for(uint64_t event_time) const;
+
+            uint64_t size() const;
+            uint64_t slide() const;
+            uint64_t lateness() const;
+
+        private:
+            window_spec(uint64_t size, uint64_t slide);
+
+            uint64_t _size;
+            uint64_t _slide;
+            uint64_t _lateness = 0;
+    };
+
+    /**
+     * Windows opened by a node, state of every window is kept in its own arena
+     * which is released at once when the window closes
+     */
+    class window_store {
+
+        public:
+            window_store(window_spec spec);
+
+            /**
+             * Opens windows containing event time and makes them current
+             * @return false if all of them are already closed - record is late
+             */
+            bool assign(uint64_t event_time);
+            /**
+             * @return open windows of the last assigned record
+             */
+            const std::vector<window>& current() const;
+
+            /**
+             * @throws runtime_error if window is not open
+             */
+            arena& arena_for(const window& w);
+            /**
+             * Slot for pointer to node's state of the window, nullptr when nothing is set
+             */
+            void*& state_for(const window& w);
+
+            /**
+             * Closes windows ending at or before time, oldest first,
+             * on_close is called before window's arena is released
+             */
+            void close_until(uint64_t time, const std::function<void(const window&)>& on_close);
+            /**
+             * Closes every open window and starts from scratch
+             */
+            void close_all(const std::function<void(const window&)>& on_close);
+
+            /**
+             * @return event time up to which all windows are closed
+             */
+            uint64_t closed_until() const;
+            uint64_t max_event_time() const;
+            std::size_t open_count() const;
+            const window_spec& spec() const;
+
+        private:
+            struct open_window {
+                window w;
+                std::unique_ptr<arena> memory;
+                void* state = nullptr;
+            };
+
+            open_window& find(const window& w);
+            void close(std::map<uint64_t, open_window>::iterator it,
+                    const std::function<void(const window&)>& on_close);
+
+            window_spec _spec;
+            std::map<uint64_t, open_window> open; // by start
+            std::vector<window> _current;
+            std::vector<std::unique_ptr<arena>> spare; // released arenas keep their first block
+            uint64_t _closed_until = 0;
+            uint64_t _max_event_time = 0;
+    };
+}
+
+#endif